@@ -0,0 +1,59 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+#include "block_log_reader.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <fc/exception/exception.hpp>
+
+namespace eosio {
+
+block_log_reader::block_log_reader(const boost::filesystem::path& blocks_dir):
+    m_log((blocks_dir / "blocks.log").string(), std::ios::in | std::ios::binary),
+    m_index((blocks_dir / "blocks.index").string(), std::ios::in | std::ios::binary)
+{
+    FC_ASSERT(m_log.is_open() && m_index.is_open(), "cannot open block log in ${d}", ("d", blocks_dir.string()));
+
+    uint32_t version = 0;
+    m_log.read(reinterpret_cast<char*>(&version), sizeof(version));
+    FC_ASSERT(m_log && version > 0, "invalid block log in ${d}", ("d", blocks_dir.string()));
+
+    // version 1 logs always start from the genesis block
+    m_first_block_num = 1;
+    if (version > 1) {
+        m_log.read(reinterpret_cast<char*>(&m_first_block_num), sizeof(m_first_block_num));
+    }
+
+    const auto index_size = boost::filesystem::file_size(blocks_dir / "blocks.index");
+    FC_ASSERT(index_size >= sizeof(uint64_t), "empty block log in ${d}", ("d", blocks_dir.string()));
+    m_last_block_num = m_first_block_num + static_cast<uint32_t>(index_size / sizeof(uint64_t)) - 1;
+}
+
+uint32_t block_log_reader::first_block_num() const
+{
+    return m_first_block_num;
+}
+
+uint32_t block_log_reader::last_block_num() const
+{
+    return m_last_block_num;
+}
+
+chain::signed_block_ptr block_log_reader::read_block(uint32_t block_num)
+{
+    FC_ASSERT(block_num >= m_first_block_num && block_num <= m_last_block_num,
+              "block ${n} is not in the block log", ("n", block_num));
+
+    uint64_t position = 0;
+    m_index.seekg(static_cast<std::streamoff>(block_num - m_first_block_num) * sizeof(uint64_t));
+    m_index.read(reinterpret_cast<char*>(&position), sizeof(position));
+
+    auto block = std::make_shared<chain::signed_block>();
+    m_log.seekg(position);
+    fc::raw::unpack(m_log, *block);
+    FC_ASSERT(block->block_num() == block_num, "block log index is inconsistent at block ${n}", ("n", block_num));
+    return block;
+}
+
+} // namespace
@@ -0,0 +1,40 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+
+#pragma once
+
+#include <fstream>
+#include <boost/filesystem/path.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <eosio/chain/block.hpp>
+
+namespace eosio {
+
+/**
+ * Read only access to the blocks.log / blocks.index pair written by nodeos.
+ *
+ * Unlike chain::block_log it never opens the files for writing, so several
+ * readers (one per backfill worker) can share the same directory, also while
+ * nodeos is running.
+ */
+class block_log_reader final : public boost::noncopyable
+{
+public:
+    block_log_reader(const boost::filesystem::path& blocks_dir);
+
+    uint32_t first_block_num() const;
+    uint32_t last_block_num() const;
+
+    chain::signed_block_ptr read_block(uint32_t block_num);
+
+private:
+    std::ifstream m_log;
+    std::ifstream m_index;
+    uint32_t m_first_block_num;
+    uint32_t m_last_block_num;
+};
+
+} // namespace
@@ -0,0 +1,193 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ *  @author Alessandro Siniscalchi <asiniscalchi@gmail.com>
+ *
+ *  Fills the SQL DB directly from a blocks.log, splitting the block range among
+ *  parallel workers. Every worker has its own DB connection and block log reader.
+ *  The workers first record the ABI set by every setabi of the range, so that each
+ *  action is decoded with the ABI of its block whichever worker wrote the setabi.
+ *  Every chunk is written in one transaction and recorded in the block_ranges table:
+ *  sql_db_plugin resumes right after the first gap when started with sql_db-block-start = 0.
+ */
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+#include <fc/log/logger.hpp>
+
+#include "database.h"
+#include "block_log_reader.h"
+
+namespace bpo = boost::program_options;
+
+namespace {
+const char* SQL_DB_URI_OPTION = "sql_db-uri";
+const char* SQL_DB_SCHEMA_OPTION = "sql_db-schema";
+const char* BLOCKS_DIR_OPTION = "blocks-dir";
+const char* FIRST_BLOCK_OPTION = "first-block";
+const char* LAST_BLOCK_OPTION = "last-block";
+const char* WORKERS_OPTION = "workers";
+const char* CHUNK_SIZE_OPTION = "chunk-size";
+const char* WIPE_OPTION = "wipe";
+const char* INDEX_PROFILE_OPTION = "index-profile";
+const char* ABI_SCAN_OPTION = "abi-scan";
+}
+
+namespace eosio {
+
+struct backfill_job {
+    std::string uri;
+    std::string schema;
+    std::string blocks_dir;
+    uint32_t last_block;
+    uint32_t chunk_size;
+    std::atomic<uint64_t> next_block;
+    std::atomic<uint32_t> failed_chunks;
+};
+
+// the chunks of [next_block, last_block] to the workers, each one with its own DB connection and log reader
+template<typename Chunk>
+void run_chunks(backfill_job& job, Chunk chunk)
+{
+    database db(job.uri, 0, job.schema);
+    block_log_reader log(job.blocks_dir);
+
+    while (true) {
+        const uint64_t first = job.next_block.fetch_add(job.chunk_size);
+        if (first > job.last_block) {
+            break;
+        }
+        const auto last = static_cast<uint32_t>(std::min<uint64_t>(job.last_block, first + job.chunk_size - 1));
+        if (!chunk(db, log, static_cast<uint32_t>(first), last)) {
+            ++job.failed_chunks;
+        }
+    }
+}
+
+void run_abi_scan(backfill_job& job)
+{
+    run_chunks(job, [](database& db, block_log_reader& log, uint32_t first, uint32_t last) {
+        return db.add_abi_versions(first, last, [&log](uint32_t block_num) { return log.read_block(block_num); });
+    });
+}
+
+void run_worker(backfill_job& job)
+{
+    run_chunks(job, [](database& db, block_log_reader& log, uint32_t first, uint32_t last) {
+        // a failed chunk stays a gap, a rerun writes it over what is left of it
+        if (!db.consume_range(first, last, [&log](uint32_t block_num) { return log.read_block(block_num); })) {
+            return false;
+        }
+        ilog("blocks ${f} - ${l} done", ("f", first)("l", last));
+        return true;
+    });
+}
+
+template<typename Worker>
+void run_workers(backfill_job& job, uint32_t workers, Worker worker)
+{
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < workers; ++i) {
+        threads.emplace_back([&job, worker]{
+            try {
+                worker(job);
+            } catch (const std::exception& ex) {
+                elog("worker stopped: ${e}", ("e", ex.what()));
+                ++job.failed_chunks;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace eosio
+
+int main(int argc, char** argv)
+{
+    bpo::options_description cli("sql_db_backfill");
+    cli.add_options()
+            ("help,h", "Print this help message and exit.")
+            (SQL_DB_URI_OPTION, bpo::value<std::string>()->required(),
+             "Sql DB URI connection string.")
+            (SQL_DB_SCHEMA_OPTION, bpo::value<std::string>()->default_value("public"),
+             "Sql DB Schema setting string"
+             " Enabled for PostgreSQL only. Defaults to 'public'")
+            (BLOCKS_DIR_OPTION, bpo::value<std::string>()->required(),
+             "The directory containing blocks.log and blocks.index.")
+            (FIRST_BLOCK_OPTION, bpo::value<uint32_t>()->default_value(0),
+             "The first block to import. Defaults to the first block of the log.")
+            (LAST_BLOCK_OPTION, bpo::value<uint32_t>()->default_value(0),
+             "The last block to import. Defaults to the last block of the log.")
+            (WORKERS_OPTION, bpo::value<uint32_t>()->default_value(std::max(1u, std::thread::hardware_concurrency())),
+             "The number of parallel workers, each one with its own DB connection.")
+            (CHUNK_SIZE_OPTION, bpo::value<uint32_t>()->default_value(1000),
+             "The number of consecutive blocks a worker takes at a time.")
+            (WIPE_OPTION, bpo::bool_switch()->default_value(false),
+             "Wipe the database before starting.")
+            (INDEX_PROFILE_OPTION, bpo::value<std::string>()->default_value("btree"),
+             "The indexes created by the wipe: btree or append-only, as sql_db-index-profile.")
+            (ABI_SCAN_OPTION, bpo::value<bool>()->default_value(true),
+             "Read the range once first for its setabi actions, so every action is decoded with the ABI of its block."
+             " Without it, an action can be decoded with an older ABI when another worker has not written the setabi yet.")
+            ;
+
+    try {
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, cli), options);
+        if (options.count("help")) {
+            std::cout << cli << std::endl;
+            return 0;
+        }
+        bpo::notify(options);
+
+        eosio::backfill_job job;
+        job.uri = options.at(SQL_DB_URI_OPTION).as<std::string>();
+        job.schema = options.at(SQL_DB_SCHEMA_OPTION).as<std::string>();
+        job.blocks_dir = options.at(BLOCKS_DIR_OPTION).as<std::string>();
+        job.chunk_size = std::max(1u, options.at(CHUNK_SIZE_OPTION).as<uint32_t>());
+        job.failed_chunks = 0;
+
+        eosio::block_log_reader log(job.blocks_dir);
+        const auto first_block = std::max(log.first_block_num(), options.at(FIRST_BLOCK_OPTION).as<uint32_t>());
+        const auto last_block = options.at(LAST_BLOCK_OPTION).as<uint32_t>();
+        job.last_block = last_block > 0 ? std::min(last_block, log.last_block_num()) : log.last_block_num();
+        job.next_block = first_block;
+
+        if (options.at(WIPE_OPTION).as<bool>()) {
+            eosio::database db(job.uri, 0, job.schema);
+            eosio::index_options indexes;
+            indexes.profile = eosio::parse_index_profile(options.at(INDEX_PROFILE_OPTION).as<std::string>());
+            db.set_indexes(indexes);
+            db.wipe();
+        }
+        {
+            eosio::database db(job.uri, 0, job.schema);
+            db.set_backfill_start(first_block);
+        }
+
+        const auto workers = std::max(1u, options.at(WORKERS_OPTION).as<uint32_t>());
+        if (options.at(ABI_SCAN_OPTION).as<bool>()) {
+            ilog("recording the ABIs set in blocks ${f} - ${l} with ${w} workers", ("f", first_block)("l", job.last_block)("w", workers));
+            eosio::run_workers(job, workers, eosio::run_abi_scan);
+            job.next_block = first_block;
+        }
+
+        ilog("backfilling blocks ${f} - ${l} with ${w} workers", ("f", first_block)("l", job.last_block)("w", workers));
+        eosio::run_workers(job, workers, eosio::run_worker);
+
+        eosio::database db(job.uri, 0, job.schema);
+        ilog("history is complete up to block ${b}", ("b", db.backfill_end()));
+        return job.failed_chunks > 0 ? 1 : 0;
+    } catch (const fc::exception& ex) {
+        elog("${e}", ("e", ex.to_detail_string()));
+    } catch (const std::exception& ex) {
+        elog("${e}", ("e", ex.what()));
+    }
+    return 1;
+}
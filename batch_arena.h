@@ -0,0 +1,115 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+namespace eosio {
+
+/**
+ * Monotonic allocator for the rows staged while a batch is written.
+ *
+ * Memory is never freed one allocation at a time: reset() makes every block
+ * available again at the end of the batch. Blocks are kept across batches, so
+ * once the arena has grown to the size of a batch it stops asking the heap.
+ */
+class batch_arena final : public boost::noncopyable
+{
+public:
+    explicit batch_arena(size_t block_size = 1 << 20);
+
+    void* allocate(size_t size, size_t alignment);
+    void reset();
+
+    size_t upstream_allocations() const;
+
+private:
+    struct block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<block> m_blocks;
+    size_t m_block_size;
+    size_t m_current;
+    size_t m_offset;
+    size_t m_upstream_allocations;
+};
+
+template<typename T>
+class arena_allocator
+{
+public:
+    using value_type = T;
+
+    arena_allocator(batch_arena* arena) : m_arena(arena) {}
+
+    template<typename U>
+    arena_allocator(const arena_allocator<U>& other) : m_arena(other.arena()) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    batch_arena* arena() const { return m_arena; }
+
+private:
+    batch_arena* m_arena;
+};
+
+template<typename T, typename U>
+bool operator==(const arena_allocator<T>& a, const arena_allocator<U>& b) { return a.arena() == b.arena(); }
+
+template<typename T, typename U>
+bool operator!=(const arena_allocator<T>& a, const arena_allocator<U>& b) { return a.arena() != b.arena(); }
+
+using arena_string = std::basic_string<char, std::char_traits<char>, arena_allocator<char>>;
+
+inline batch_arena::batch_arena(size_t block_size):
+    m_block_size(block_size),
+    m_current(0),
+    m_offset(0),
+    m_upstream_allocations(0)
+{
+}
+
+inline void* batch_arena::allocate(size_t size, size_t alignment)
+{
+    while (m_current < m_blocks.size()) {
+        auto& current = m_blocks[m_current];
+        const size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= current.size) {
+            m_offset = offset + size;
+            return current.data.get() + offset;
+        }
+        ++m_current;
+        m_offset = 0;
+    }
+
+    const size_t block_size = std::max(m_block_size, size + alignment);
+    m_blocks.push_back(block{std::unique_ptr<char[]>(new char[block_size]), block_size});
+    ++m_upstream_allocations;
+    m_current = m_blocks.size() - 1;
+    m_offset = 0;
+    return this->allocate(size, alignment);
+}
+
+inline void batch_arena::reset()
+{
+    m_current = 0;
+    m_offset = 0;
+}
+
+inline size_t batch_arena::upstream_allocations() const
+{
+    return m_upstream_allocations;
+}
+
+} // namespace
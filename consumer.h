@@ -5,8 +5,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
 #include <vector>
 #include <boost/noncopyable.hpp>
 #include <fc/log/logger.hpp>
@@ -16,32 +20,75 @@
 
 namespace eosio {
 
+/**
+ * How the elements are grouped before being handed to the core.
+ *
+ * Whatever is queued is consumed at once, so the batches grow by themselves when
+ * the core falls behind. At the head of the queue the consumer waits for
+ * min_elements as long as the oldest one is younger than max_delay: the delay is
+ * the upper bound added to the push-to-commit latency. max_bytes bounds the memory
+ * held by a batch with the size estimated at push: a backlog is consumed in
+ * several batches instead of one. push() waits while max_queued elements are
+ * queued, which holds back the producer instead of growing the backlog.
+ */
+struct batch_policy {
+    size_t min_elements = 1;
+    size_t max_elements = 0; // 0: no limit
+    size_t max_bytes = 0; // 0: no limit
+    size_t max_queued = 0; // 0: no limit
+    std::chrono::milliseconds max_delay{0};
+};
+
+// Batches consumed since the last report: latency is from the push of the oldest element to the end of consume()
+struct batch_stats {
+    size_t batches = 0;
+    size_t elements = 0;
+    size_t max_batch = 0;
+    size_t max_batch_bytes = 0;
+    size_t max_queued = 0; // the longest the queue was when a batch was taken from it
+    size_t failures = 0; // batches whose consume() threw: their elements are dropped
+    std::chrono::microseconds total_latency{0};
+    std::chrono::microseconds max_latency{0};
+};
+
 template<typename T>
 class consumer final : public boost::noncopyable
 {
 public:
-    consumer(std::unique_ptr<consumer_core<T>> core);
+    using size_estimator = std::function<size_t(const T&)>;
+
+    consumer(std::unique_ptr<consumer_core<T>> core, const batch_policy& policy = batch_policy(), size_estimator estimator = nullptr);
     ~consumer();
 
     void push(const T& element);
+    batch_stats stats() const;
 
 private:
     void run();
+    void record(size_t elements, size_t queued, size_t bytes, std::chrono::microseconds latency, bool failed);
 
     fifo<T> m_fifo;
     std::unique_ptr<consumer_core<T>> m_core;
+    batch_policy m_policy;
+    size_estimator m_estimator;
+    mutable std::mutex m_stats_mux;
+    batch_stats m_stats;
+    typename fifo<T>::clock::time_point m_last_report;
     std::atomic<bool> m_exit;
     std::unique_ptr<std::thread> m_thread;
 };
 
 template<typename T>
-consumer<T>::consumer(std::unique_ptr<consumer_core<T> > core):
+consumer<T>::consumer(std::unique_ptr<consumer_core<T> > core, const batch_policy& policy, size_estimator estimator):
     m_fifo(fifo<T>::behavior::blocking),
     m_core(std::move(core)),
+    m_policy(policy),
+    m_estimator(std::move(estimator)),
+    m_last_report(fifo<T>::clock::now()),
     m_exit(false),
     m_thread(std::make_unique<std::thread>([&]{this->run();}))
 {
-
+    m_fifo.set_max_size(m_policy.max_queued);
 }
 
 template<typename T>
@@ -55,20 +102,65 @@ consumer<T>::~consumer()
 template<typename T>
 void consumer<T>::push(const T& element)
 {
-    m_fifo.push(element);
+    m_fifo.push(element, m_estimator ? m_estimator(element) : 0);
+}
+
+template<typename T>
+batch_stats consumer<T>::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_stats_mux);
+    return m_stats;
 }
 
 template<typename T>
 void consumer<T>::run()
 {
     dlog("Consumer thread Start");
-    while (!m_exit)
+    while (!m_exit || m_fifo.size() > 0) // what was pushed before the destruction is consumed
     {
-        auto elements = m_fifo.pop_all();
-        m_core->consume(elements);
+        typename fifo<T>::clock::time_point oldest_push;
+        size_t bytes = 0;
+        auto elements = m_fifo.pop(m_policy.min_elements, m_policy.max_elements, m_policy.max_bytes, m_policy.max_delay, &oldest_push, &bytes);
+        if (elements.empty()) {
+            continue;
+        }
+        const auto queued = elements.size() + m_fifo.size();
+
+        bool failed = false;
+        try {
+            m_core->consume(elements);
+        } catch (const std::exception& ex) { // the next batches may still go through
+            elog("dropping a batch of ${n}: ${e}", ("n", elements.size())("e", ex.what()));
+            failed = true;
+        }
+        this->record(elements.size(), queued, bytes, std::chrono::duration_cast<std::chrono::microseconds>(fifo<T>::clock::now() - oldest_push), failed);
     }
     dlog("Consumer thread End");
 }
 
-} // namespace
+template<typename T>
+void consumer<T>::record(size_t elements, size_t queued, size_t bytes, std::chrono::microseconds latency, bool failed)
+{
+    std::lock_guard<std::mutex> lock(m_stats_mux);
+    m_stats.batches++;
+    m_stats.elements += elements;
+    m_stats.max_batch = std::max(m_stats.max_batch, elements);
+    m_stats.max_batch_bytes = std::max(m_stats.max_batch_bytes, bytes);
+    m_stats.max_queued = std::max(m_stats.max_queued, queued);
+    m_stats.failures += failed ? 1 : 0;
+    m_stats.total_latency += latency;
+    m_stats.max_latency = std::max(m_stats.max_latency, latency);
 
+    const auto now = fifo<T>::clock::now();
+    if (now - m_last_report < std::chrono::minutes(1)) {
+        return;
+    }
+    ilog("batches: ${b}, elements: ${e} (max ${m} per batch, ${mb} KiB), latency avg ${a} ms, max ${x} ms, max queued ${q}, failed ${f}",
+         ("b", m_stats.batches)("e", m_stats.elements)("m", m_stats.max_batch)("mb", m_stats.max_batch_bytes / 1024)
+         ("a", m_stats.total_latency.count() / 1000 / m_stats.batches)("x", m_stats.max_latency.count() / 1000)
+         ("q", m_stats.max_queued)("f", m_stats.failures));
+    m_stats = batch_stats();
+    m_last_report = now;
+}
+
+} // namespace
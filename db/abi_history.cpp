@@ -0,0 +1,136 @@
+#include "abi_history.h"
+
+#include <algorithm>
+#include <fc/crypto/city.hpp>
+#include <fc/log/logger.hpp>
+
+namespace eosio {
+
+namespace {
+
+template<typename Version>
+bool before(const Version& version, uint32_t block_num)
+{
+    return version.block_num < block_num;
+}
+
+}
+
+template<typename Dialect>
+abi_history<Dialect>::abi_history(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer):
+    m_session(session),
+    m_writer(writer)
+{
+}
+
+template<typename Dialect>
+void abi_history<Dialect>::drop()
+{
+    try {
+        *m_session << "DROP TABLE IF EXISTS abi_history" << Dialect::cascade();
+    }
+    catch(std::exception& e){
+        wlog(e.what());
+    }
+    m_versions.clear();
+    m_read.clear();
+}
+
+template<typename Dialect>
+void abi_history<Dialect>::create()
+{
+    Dialect::abi_history::create(*m_session);
+}
+
+template<typename Dialect>
+uint64_t abi_history<Dialect>::add(chain::account_name account, uint32_t block_num, const std::string& abi)
+{
+    const uint64_t hash = fc::city_hash64(abi.data(), abi.size());
+
+    auto& versions = this->versions(account);
+    auto it = std::lower_bound(versions.begin(), versions.end(), block_num, before<version>);
+    if (it != versions.end() && it->block_num == block_num) {
+        it->hash = hash;
+    } else {
+        versions.insert(it, version{block_num, hash});
+    }
+
+    m_writer->exec(m_upsert,
+            account.to_string(),
+            block_num,
+            static_cast<long long>(hash), // BIGINT: the same bits
+            abi);
+    return hash;
+}
+
+template<typename Dialect>
+const typename abi_history<Dialect>::version* abi_history<Dialect>::find(chain::account_name account, uint32_t block_num)
+{
+    const auto* found = latest(this->versions(account), block_num);
+    if (!found && m_read.insert(account.value).second) {
+        m_versions.erase(account.value);
+        found = latest(this->versions(account), block_num);
+    }
+    return found;
+}
+
+template<typename Dialect>
+std::string abi_history<Dialect>::get(chain::account_name account, uint32_t block_num)
+{
+    m_writer->sync(); // the session is used directly
+    std::string abi;
+    soci::indicator ind;
+    *m_session << "SELECT abi FROM abi_history WHERE account = :ac AND block_number = :bn",
+            soci::into(abi, ind), soci::use(account.to_string(), "ac"), soci::use(block_num, "bn");
+    return abi;
+}
+
+template<typename Dialect>
+void abi_history<Dialect>::reload()
+{
+    m_read.clear();
+}
+
+template<typename Dialect>
+void abi_history<Dialect>::rollback()
+{
+    m_versions.clear();
+    m_read.clear();
+}
+
+// private
+
+template<typename Dialect>
+std::vector<typename abi_history<Dialect>::version>& abi_history<Dialect>::versions(chain::account_name account)
+{
+    auto it = m_versions.find(account.value);
+    if (it != m_versions.end()) {
+        return it->second;
+    }
+
+    auto& versions = m_versions[account.value];
+    m_read.insert(account.value);
+    m_writer->sync(); // the session is used directly
+    const std::string name = account.to_string();
+    long long block_num = 0;
+    long long hash = 0;
+    soci::statement statement = (m_session->prepare << "SELECT block_number, abi_hash FROM abi_history WHERE account = :ac ORDER BY block_number",
+            soci::into(block_num), soci::into(hash), soci::use(name, "ac"));
+    statement.execute();
+    while (statement.fetch()) {
+        versions.push_back(version{static_cast<uint32_t>(block_num), static_cast<uint64_t>(hash)});
+    }
+    return versions;
+}
+
+template<typename Dialect>
+const typename abi_history<Dialect>::version* abi_history<Dialect>::latest(const std::vector<version>& versions, uint32_t block_num)
+{
+    auto it = std::upper_bound(versions.begin(), versions.end(), block_num,
+                               [](uint32_t block, const version& v) { return block < v.block_num; });
+    return it != versions.begin() ? &*(it - 1) : nullptr;
+}
+
+SQL_DB_INSTANTIATE_DIALECTS(abi_history)
+
+} // namespace
@@ -0,0 +1,63 @@
+#ifndef ABI_HISTORY_H
+#define ABI_HISTORY_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <soci/soci.h>
+#include <eosio/chain/types.hpp>
+
+#include "sql_dialect.h"
+#include "sql_writer.h"
+
+namespace eosio {
+
+// Every ABI set by an account, by the block of its setabi, so that an action is
+// decoded with the ABI in effect at its block: a replay or blocks written out of
+// order are not decoded with an ABI set after them. The versions of an account
+// are read on its first lookup and kept sorted by block. A lookup without a version
+// is not read again until reload(): in the plugin every setabi goes through add(),
+// only another writer, a backfill worker, adds versions behind its back.
+template<typename Dialect>
+class abi_history
+{
+public:
+    struct version {
+        uint32_t block_num; // first block decoded with it
+        uint64_t hash;      // of its JSON
+    };
+
+    abi_history(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer);
+
+    void drop();
+    void create();
+
+    // the ABI set at block_num, replacing the one set earlier in the same block. Returns its hash.
+    uint64_t add(chain::account_name account, uint32_t block_num, const std::string& abi);
+    // the latest version set at block_num or before, null when there is none
+    const version* find(chain::account_name account, uint32_t block_num);
+    // the JSON of the version set at block_num
+    std::string get(chain::account_name account, uint32_t block_num);
+
+    // the versions added by another writer: the lookups without one read them again, once
+    void reload();
+    // the batch was not written: the versions it added are read again
+    void rollback();
+
+private:
+    std::vector<version>& versions(chain::account_name account);
+    static const version* latest(const std::vector<version>& versions, uint32_t block_num);
+
+    std::shared_ptr<soci::session> m_session;
+    std::shared_ptr<sql_writer> m_writer;
+    std::unordered_map<uint64_t, std::vector<version>> m_versions; // by account
+    std::unordered_set<uint64_t> m_read; // the accounts whose versions were read since the last reload()
+    const std::string m_upsert = Dialect::abi_history::upsert();
+};
+
+} // namespace
+
+#endif // ABI_HISTORY_H
@@ -0,0 +1,467 @@
+#include "abi_json_writer.h"
+#include "chain_strings.h"
+
+#include <cstdio>
+#include <cstring>
+#include <set>
+#include <type_traits>
+
+#include <fc/crypto/hex.hpp>
+
+namespace eosio {
+
+namespace {
+
+// same limit as abi_serializer: deeper payloads take the generic path, which rejects them
+const size_t max_recursion_depth = 32;
+
+// thrown when the payload must be decoded by the generic abi_serializer path
+struct decode_fallback {};
+
+const std::string name_type = "name";
+
+const std::set<std::string> native_types = {
+    "bool", "int8", "uint8", "int16", "uint16", "int32", "uint32", "int64", "uint64", "varuint32",
+    "name", "account_name", "permission_name", "action_name", "table_name", "scope_name",
+    "asset", "string", "bytes", "checksum160", "checksum256", "checksum512"
+};
+
+const std::set<std::string> name_aliases = {
+    "account_name", "permission_name", "action_name", "table_name", "scope_name"
+};
+
+// characters fc::json writes as they are
+bool plain_json(const char* data, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        const auto c = static_cast<unsigned char>(data[i]);
+        if (c < 0x20 || c > 0x7e || c == '"' || c == '\\') {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ends_with(const std::string& value, const char* suffix, size_t size)
+{
+    return value.size() > size && value.compare(value.size() - size, size, suffix) == 0;
+}
+
+template<typename T>
+T read(const char*& pos, const char* end)
+{
+    if (static_cast<size_t>(end - pos) < sizeof(T)) {
+        throw decode_fallback();
+    }
+    T value;
+    std::memcpy(&value, pos, sizeof(T));
+    pos += sizeof(T);
+    return value;
+}
+
+// as fc::raw::unpack(fc::unsigned_int)
+uint32_t read_varuint32(const char*& pos, const char* end)
+{
+    uint64_t value = 0;
+    uint8_t by = 0;
+    uint8_t b = 0;
+    do {
+        b = read<uint8_t>(pos, end);
+        value |= uint32_t(b & 0x7f) << by;
+        by += 7;
+    } while ((b & 0x80) && by < 32);
+    return static_cast<uint32_t>(value);
+}
+
+template<typename T>
+void append_number(T value, std::string& out)
+{
+    char buffer[24];
+    const int size = std::is_signed<T>::value ?
+                std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value)) :
+                std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+    out.append(buffer, size);
+}
+
+// fc::json writes the 64 bit integers out of [-0xffffffff, 0xffffffff] as strings
+void append_large_number(uint64_t value, std::string& out)
+{
+    if (value > 0xffffffff) {
+        out += '"';
+        append_number(value, out);
+        out += '"';
+    } else {
+        append_number(value, out);
+    }
+}
+
+void append_large_number(int64_t value, std::string& out)
+{
+    if (value > 0xffffffffll || value < -0xffffffffll) {
+        out += '"';
+        append_number(value, out);
+        out += '"';
+    } else {
+        append_number(value, out);
+    }
+}
+
+void append_quoted(const std::string& value, std::string& out)
+{
+    out += '"';
+    out += value;
+    out += '"';
+}
+
+} // namespace
+
+void decoded_action::clear()
+{
+    json.clear();
+    fields.clear();
+    variant.reset();
+}
+
+std::string decoded_action::json_of(const std::string& name) const
+{
+    if (variant) {
+        return fc::json::to_string((*variant)[name]);
+    }
+
+    const auto& field = this->find(name);
+    return json.substr(field.json_begin, field.json_end - field.json_begin);
+}
+
+bool decoded_action::has(const std::string& name) const
+{
+    if (variant) {
+        return variant->is_object() && variant->get_object().contains(name.c_str());
+    }
+
+    for (const auto& field : fields) {
+        if (*field.name == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const decoded_field& decoded_action::find(const std::string& name) const
+{
+    for (const auto& field : fields) {
+        if (*field.name == name) {
+            return field;
+        }
+    }
+    FC_THROW_EXCEPTION(fc::key_not_found_exception, "Key ${key}", ("key", name));
+}
+
+abi_json_writer::abi_json_writer(const chain::abi_def& abi, const chain::abi_serializer& serializer, const fc::microseconds& max_serialization_time):
+    m_serializer(serializer),
+    m_max_serialization_time(max_serialization_time)
+{
+    for (const auto& type : abi.types) {
+        m_typedefs[type.new_type_name] = type.type;
+    }
+    for (const auto& action : abi.actions) {
+        m_actions[action.name.value] = action.type;
+    }
+
+    std::unordered_map<std::string, const chain::struct_def*> structs;
+    for (const auto& st : abi.structs) {
+        structs[st.name] = &st;
+    }
+
+    for (const auto& st : abi.structs) {
+        std::vector<chain::field_def> fields;
+        const chain::struct_def* current = &st;
+        std::vector<const chain::struct_def*> chain_of_bases;
+        while (current && chain_of_bases.size() <= max_recursion_depth) {
+            chain_of_bases.push_back(current);
+            if (current->base.empty()) {
+                break;
+            }
+            auto base = structs.find(this->resolve(current->base));
+            current = base != structs.end() ? base->second : nullptr;
+        }
+        if (!current || chain_of_bases.size() > max_recursion_depth) {
+            continue; // broken base: left to the abi_serializer
+        }
+
+        std::set<std::string> names;
+        bool plain = true;
+        for (auto it = chain_of_bases.rbegin(); it != chain_of_bases.rend(); ++it) {
+            for (const auto& field : (*it)->fields) {
+                plain = plain && names.insert(field.name).second && plain_json(field.name.data(), field.name.size());
+                fields.push_back(field);
+            }
+        }
+        if (plain) { // a field shadowing a base one keeps the base position in the variant: not worth mirroring
+            m_structs[st.name] = std::move(fields);
+        }
+    }
+}
+
+void abi_json_writer::write(chain::action_name action, const chain::bytes& data, decoded_action& result) const
+{
+    result.clear();
+
+    auto it = m_actions.find(action.value);
+    if (it != m_actions.end()) {
+        const auto& type = this->resolve(it->second);
+        const auto* fields = m_serializer.is_builtin_type(type) ? nullptr : this->get_struct(type);
+        if (fields) {
+            try {
+                cursor in{data.data(), data.data() + data.size(), fc::time_point::now() + m_max_serialization_time};
+                this->write_struct(*fields, in, result.json, 1, &result);
+                return;
+            } catch (const decode_fallback&) {
+                result.clear();
+            }
+        }
+    }
+
+    result.variant = m_serializer.binary_to_variant(m_serializer.get_action_type(action), data, m_max_serialization_time);
+    result.json = fc::json::to_string(*result.variant);
+}
+
+std::string abi_json_writer::layout(chain::action_name action) const
+{
+    auto it = m_actions.find(action.value);
+    const auto* fields = it != m_actions.end() ? this->get_struct(this->resolve(it->second)) : nullptr;
+    if (!fields) {
+        return std::string();
+    }
+
+    std::string result;
+    for (const auto& field : *fields) {
+        auto type = this->resolve(field.type);
+        const bool array = ends_with(type, "[]", 2);
+        if (array) {
+            type = this->resolve(type.substr(0, type.size() - 2));
+        }
+        if (name_aliases.count(type)) {
+            type = name_type;
+        }
+
+        if (!result.empty()) {
+            result += ',';
+        }
+        result += field.name;
+        result += ':';
+        result += type;
+        if (array) {
+            result += "[]";
+        }
+    }
+    return result;
+}
+
+// private
+
+// same resolution as abi_serializer::resolve_type()
+const std::string& abi_json_writer::resolve(const std::string& type) const
+{
+    auto it = m_typedefs.find(type);
+    if (it != m_typedefs.end()) {
+        for (auto i = m_typedefs.size(); i > 0; --i) {
+            const auto& t = it->second;
+            it = m_typedefs.find(t);
+            if (it == m_typedefs.end()) {
+                return t;
+            }
+        }
+    }
+    return type;
+}
+
+const std::vector<chain::field_def>* abi_json_writer::get_struct(const std::string& type) const
+{
+    auto it = m_structs.find(type);
+    return it != m_structs.end() ? &it->second : nullptr;
+}
+
+void abi_json_writer::write_value(const std::string& type, cursor& in, std::string& out, size_t depth) const
+{
+    if (depth > max_recursion_depth) {
+        throw decode_fallback();
+    }
+
+    const auto& rtype = this->resolve(type);
+    const bool array = ends_with(rtype, "[]", 2);
+    const bool optional = !array && ends_with(rtype, "?", 1);
+    const std::string ftype = array || optional ? rtype.substr(0, rtype.size() - (array ? 2 : 1)) : std::string();
+    const auto& fundamental = array || optional ? ftype : rtype;
+
+    if (m_serializer.is_builtin_type(fundamental)) {
+        // vectors of 8 bit integers have their own fc::variant conversion
+        if (!native_types.count(fundamental) || ((array || optional) && (fundamental == "int8" || fundamental == "uint8"))) {
+            this->write_serialized(rtype, in, out);
+        } else if (array) {
+            const auto size = read_varuint32(in.pos, in.end);
+            EOS_ASSERT(fc::time_point::now() < in.deadline, chain::abi_serialization_deadline_exception,
+                       "serialization time limit ${t}us exceeded", ("t", m_max_serialization_time));
+            out += '[';
+            for (uint32_t i = 0; i < size; ++i) {
+                if (i > 0) {
+                    out += ',';
+                }
+                this->write_builtin(fundamental, in, out);
+            }
+            out += ']';
+        } else if (optional) {
+            const auto flag = read<uint8_t>(in.pos, in.end);
+            if (flag & ~1) {
+                throw decode_fallback();
+            }
+            if (flag) {
+                this->write_builtin(fundamental, in, out);
+            } else {
+                out += "null";
+            }
+        } else {
+            this->write_builtin(fundamental, in, out);
+        }
+        return;
+    }
+
+    if (array) {
+        const auto size = read_varuint32(in.pos, in.end);
+        out += '[';
+        for (uint32_t i = 0; i < size; ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            this->write_value(fundamental, in, out, depth + 1);
+        }
+        out += ']';
+    } else if (optional) {
+        if (read<char>(in.pos, in.end)) {
+            this->write_value(fundamental, in, out, depth + 1);
+        } else {
+            out += "null";
+        }
+    } else if (const auto* fields = this->get_struct(rtype)) {
+        this->write_struct(*fields, in, out, depth + 1, nullptr);
+    } else {
+        this->write_serialized(rtype, in, out);
+    }
+}
+
+void abi_json_writer::write_builtin(const std::string& type, cursor& in, std::string& out) const
+{
+    if (type == "name" || name_aliases.count(type)) {
+        append_quoted(name_string(read<uint64_t>(in.pos, in.end)), out);
+    } else if (type == "asset") {
+        fc::datastream<const char*> stream(in.pos, in.end - in.pos);
+        chain::asset value;
+        try {
+            fc::raw::unpack(stream, value);
+        } catch (const fc::exception&) {
+            throw decode_fallback();
+        }
+        in.pos = in.end - stream.remaining();
+        append_quoted(value.to_string(), out);
+    } else if (type == "string") {
+        const auto size = read_varuint32(in.pos, in.end);
+        if (static_cast<size_t>(in.end - in.pos) < size) {
+            throw decode_fallback();
+        }
+        if (plain_json(in.pos, size)) {
+            out += '"';
+            out.append(in.pos, size);
+            out += '"';
+        } else {
+            out += fc::json::to_string(fc::variant(std::string(in.pos, size)));
+        }
+        in.pos += size;
+    } else if (type == "bytes") {
+        const auto size = read_varuint32(in.pos, in.end);
+        if (static_cast<size_t>(in.end - in.pos) < size) {
+            throw decode_fallback();
+        }
+        out += '"';
+        out += fc::to_hex(in.pos, size);
+        out += '"';
+        in.pos += size;
+    } else if (type == "checksum160" || type == "checksum256" || type == "checksum512") {
+        const size_t size = type == "checksum160" ? 20 : type == "checksum256" ? 32 : 64;
+        if (static_cast<size_t>(in.end - in.pos) < size) {
+            throw decode_fallback();
+        }
+        out += '"';
+        out += fc::to_hex(in.pos, size);
+        out += '"';
+        in.pos += size;
+    } else if (type == "bool") {
+        const auto value = read<uint8_t>(in.pos, in.end);
+        if (value & ~1) {
+            throw decode_fallback();
+        }
+        out += value ? "true" : "false";
+    } else if (type == "uint64") {
+        append_large_number(read<uint64_t>(in.pos, in.end), out);
+    } else if (type == "int64") {
+        append_large_number(read<int64_t>(in.pos, in.end), out);
+    } else if (type == "uint32") {
+        append_number(read<uint32_t>(in.pos, in.end), out);
+    } else if (type == "int32") {
+        append_number(read<int32_t>(in.pos, in.end), out);
+    } else if (type == "uint16") {
+        append_number(read<uint16_t>(in.pos, in.end), out);
+    } else if (type == "int16") {
+        append_number(read<int16_t>(in.pos, in.end), out);
+    } else if (type == "uint8") {
+        append_number(read<uint8_t>(in.pos, in.end), out);
+    } else if (type == "int8") {
+        append_number(read<int8_t>(in.pos, in.end), out);
+    } else if (type == "varuint32") {
+        append_number(read_varuint32(in.pos, in.end), out);
+    } else {
+        throw decode_fallback();
+    }
+}
+
+// one value through the abi_serializer: the types without a native writer
+void abi_json_writer::write_serialized(const std::string& type, cursor& in, std::string& out) const
+{
+    fc::datastream<const char*> stream(in.pos, in.end - in.pos);
+    fc::variant value;
+    try {
+        value = m_serializer.binary_to_variant(type, stream, m_max_serialization_time);
+    } catch (const fc::exception&) {
+        throw decode_fallback(); // the generic path reports the error
+    }
+    in.pos = in.end - stream.remaining();
+    out += fc::json::to_string(value);
+}
+
+void abi_json_writer::write_struct(const std::vector<chain::field_def>& fields, cursor& in, std::string& out, size_t depth, decoded_action* top) const
+{
+    EOS_ASSERT(fc::time_point::now() < in.deadline, chain::abi_serialization_deadline_exception,
+               "serialization time limit ${t}us exceeded", ("t", m_max_serialization_time));
+
+    out += '{';
+    for (size_t i = 0; i < fields.size(); ++i) {
+        const auto& field = fields[i];
+        if (i > 0) {
+            out += ',';
+        }
+        out += '"';
+        out += field.name;
+        out += "\":";
+
+        const char* data = in.pos;
+        const size_t json_begin = out.size();
+        this->write_value(field.type, in, out, depth);
+
+        if (top) {
+            const auto& type = this->resolve(field.type);
+            top->fields.push_back(decoded_field{&field.name, name_aliases.count(type) ? &name_type : &type,
+                                                data, static_cast<size_t>(in.pos - data), json_begin, out.size()});
+        }
+    }
+    out += '}';
+}
+
+} // namespace
@@ -0,0 +1,107 @@
+#ifndef ABI_JSON_WRITER_H
+#define ABI_JSON_WRITER_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fc/io/json.hpp>
+#include <fc/io/raw.hpp>
+#include <fc/variant.hpp>
+
+#include <eosio/chain/abi_def.hpp>
+#include <eosio/chain/abi_serializer.hpp>
+#include <eosio/chain/asset.hpp>
+
+namespace eosio {
+
+// a top level field of a decoded action: where it is in the payload and in the JSON text
+struct decoded_field {
+    const std::string* name;
+    const std::string* type; // resolved, builtin aliases mapped to their canonical name
+    const char* data;
+    size_t size;
+    size_t json_begin;
+    size_t json_end;
+};
+
+// The JSON text of an action payload and the access to its top level fields.
+// Reused from action to action: clear() keeps the buffers.
+class decoded_action
+{
+public:
+    std::string json;
+    std::vector<decoded_field> fields;
+    fc::optional<fc::variant> variant; // only set by the generic abi_serializer path
+
+    void clear();
+
+    template<typename T>
+    T as(const std::string& name) const;
+    std::string json_of(const std::string& name) const;
+    bool has(const std::string& name) const;
+
+private:
+    const decoded_field& find(const std::string& name) const;
+};
+
+template<typename T> struct abi_builtin { static const char* name() { return ""; } }; // read from the JSON
+template<> struct abi_builtin<chain::name> { static const char* name() { return "name"; } };
+template<> struct abi_builtin<chain::asset> { static const char* name() { return "asset"; } };
+
+template<typename T>
+T decoded_action::as(const std::string& name) const
+{
+    if (variant) {
+        return (*variant)[name].template as<T>();
+    }
+
+    const auto& field = this->find(name);
+    if (*field.type == abi_builtin<T>::name()) {
+        fc::datastream<const char*> stream(field.data, field.size);
+        T value;
+        fc::raw::unpack(stream, value);
+        return value;
+    }
+    return fc::json::from_string(this->json_of(name)).template as<T>();
+}
+
+// Decodes action payloads straight from the ABI description to JSON text, without
+// building the fc::variant tree. The output is the same as fc::json::to_string() of
+// abi_serializer::binary_to_variant(): the types it does not write natively are
+// delegated to the abi_serializer one value at a time.
+class abi_json_writer
+{
+public:
+    abi_json_writer(const chain::abi_def& abi, const chain::abi_serializer& serializer, const fc::microseconds& max_serialization_time);
+
+    void write(chain::action_name action, const chain::bytes& data, decoded_action& result) const;
+    // The fields of the action's payload as "name:type,...", the types resolved and the
+    // name aliases written "name". Empty when the ABI does not describe it as a struct.
+    std::string layout(chain::action_name action) const;
+
+private:
+    struct cursor {
+        const char* pos;
+        const char* end;
+        fc::time_point deadline; // of the whole payload, as abi_serializer
+    };
+
+    const std::string& resolve(const std::string& type) const;
+    const std::vector<chain::field_def>* get_struct(const std::string& type) const;
+
+    void write_value(const std::string& type, cursor& in, std::string& out, size_t depth) const;
+    void write_builtin(const std::string& type, cursor& in, std::string& out) const;
+    void write_serialized(const std::string& type, cursor& in, std::string& out) const;
+    void write_struct(const std::vector<chain::field_def>& fields, cursor& in, std::string& out, size_t depth, decoded_action* top) const;
+
+    const chain::abi_serializer& m_serializer;
+    fc::microseconds m_max_serialization_time;
+    std::unordered_map<std::string, std::string> m_typedefs;
+    std::unordered_map<std::string, std::vector<chain::field_def>> m_structs; // fields flattened with the base ones first
+    std::unordered_map<uint64_t, std::string> m_actions;
+};
+
+} // namespace
+
+#endif // ABI_JSON_WRITER_H
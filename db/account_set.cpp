@@ -0,0 +1,89 @@
+#include "account_set.h"
+
+#include <fc/log/logger.hpp>
+
+namespace eosio {
+
+template<typename Dialect>
+account_set<Dialect>::account_set(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer):
+    m_session(session),
+    m_writer(writer)
+{
+}
+
+template<typename Dialect>
+void account_set<Dialect>::add(chain::account_name account)
+{
+    if (!m_loaded) {
+        this->load();
+    }
+    if (m_accounts.insert(account.value).second) {
+        m_added.push_back(account.value);
+        m_writer->exec(m_insert, account.to_string());
+    }
+}
+
+template<typename Dialect>
+bool account_set<Dialect>::contains(chain::account_name account)
+{
+    if (!m_loaded) {
+        this->load();
+    }
+    return m_accounts.count(account.value) > 0;
+}
+
+template<typename Dialect>
+void account_set<Dialect>::reset()
+{
+    m_accounts.clear();
+    m_added.clear();
+    m_loaded = false;
+}
+
+template<typename Dialect>
+void account_set<Dialect>::commit()
+{
+    m_added.clear();
+}
+
+template<typename Dialect>
+void account_set<Dialect>::rollback()
+{
+    for (const auto account : m_added) {
+        m_accounts.erase(account);
+    }
+    m_added.clear();
+}
+
+template<typename Dialect>
+size_t account_set<Dialect>::size()
+{
+    if (!m_loaded) {
+        this->load();
+    }
+    return m_accounts.size();
+}
+
+// private
+
+template<typename Dialect>
+void account_set<Dialect>::load()
+{
+    m_writer->sync(); // the session is used directly
+    long long count = 0;
+    *m_session << "SELECT COUNT(*) FROM accounts", soci::into(count);
+    m_accounts.reserve(static_cast<size_t>(count));
+
+    std::string name;
+    soci::statement statement = (m_session->prepare << "SELECT name FROM accounts", soci::into(name));
+    statement.execute();
+    while (statement.fetch()) {
+        m_accounts.insert(chain::name(name).value);
+    }
+    m_loaded = true;
+    ilog("${n} accounts loaded", ("n", m_accounts.size()));
+}
+
+SQL_DB_INSTANTIATE_DIALECTS(account_set)
+
+} // namespace
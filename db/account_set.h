@@ -0,0 +1,51 @@
+#ifndef ACCOUNT_SET_H
+#define ACCOUNT_SET_H
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include <soci/soci.h>
+#include <eosio/chain/types.hpp>
+
+#include "sql_dialect.h"
+#include "sql_writer.h"
+
+namespace eosio {
+
+// The names in the accounts table, in memory, instead of a foreign key to it on
+// every table that names an account: a hash lookup per row instead of an index
+// probe on the server. An account the plugin has not seen created (before
+// sql_db-block-start, or before the start of a backfill chunk) is added to the
+// table when it is first named, so the rows still join with accounts.
+template<typename Dialect>
+class account_set
+{
+public:
+    account_set(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer);
+
+    // adds the account to the table if it is not there yet
+    void add(chain::account_name account);
+    bool contains(chain::account_name account);
+    // the table was wiped: read it again on the next use
+    void reset();
+    // the outcome of the batch: the accounts it added are added again after a rollback
+    void commit();
+    void rollback();
+
+    size_t size();
+
+private:
+    void load();
+
+    std::shared_ptr<soci::session> m_session;
+    std::shared_ptr<sql_writer> m_writer;
+    std::unordered_set<uint64_t> m_accounts;
+    std::vector<uint64_t> m_added; // in this batch
+    bool m_loaded = false;
+    const std::string m_insert = Dialect::accounts::insert();
+};
+
+} // namespace
+
+#endif // ACCOUNT_SET_H
@@ -4,10 +4,13 @@
 #include <memory>
 #include <soci/soci.h>
 
+#include "sql_dialect.h"
+
 namespace eosio {
 
 using std::string;
 
+template<typename Dialect>
 class accounts_table
 {
 public:
@@ -20,10 +23,6 @@ public:
 
 private:
     std::shared_ptr<soci::session> m_session;
-    std::string backend;
-
-    void create_mysql();
-    void create_postgresql();
 };
 
 } // namespace
@@ -0,0 +1,94 @@
+#include "action_costs_table.h"
+
+#include <fc/log/logger.hpp>
+
+#include "chain_strings.h"
+
+namespace eosio {
+
+template<typename Dialect>
+action_costs_table<Dialect>::action_costs_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer):
+    m_session(session),
+    m_writer(writer),
+    m_last_flush(std::chrono::steady_clock::now())
+{
+}
+
+template<typename Dialect>
+void action_costs_table<Dialect>::drop()
+{
+    try {
+        *m_session << "DROP TABLE IF EXISTS action_costs";
+    }
+    catch(std::exception& e){
+        wlog(e.what());
+    }
+    m_costs.clear();
+}
+
+template<typename Dialect>
+void action_costs_table<Dialect>::create()
+{
+    Dialect::action_costs::create(*m_session);
+}
+
+template<typename Dialect>
+void action_costs_table<Dialect>::set_refresh(std::chrono::seconds refresh)
+{
+    m_refresh = refresh;
+}
+
+template<typename Dialect>
+void action_costs_table<Dialect>::add(chain::account_name account, chain::action_name name, size_t bytes,
+                                      std::chrono::microseconds abi, std::chrono::microseconds decode, std::chrono::microseconds sql)
+{
+    auto& costs = m_costs[{account.value, name.value}];
+    costs.actions++;
+    costs.bytes += bytes;
+    costs.abi_us += abi.count();
+    costs.decode_us += decode.count();
+    costs.sql_us += sql.count();
+}
+
+template<typename Dialect>
+void action_costs_table<Dialect>::add_skipped(chain::account_name account, chain::action_name name, std::chrono::microseconds abi)
+{
+    auto& costs = m_costs[{account.value, name.value}];
+    costs.skipped++;
+    costs.abi_us += abi.count();
+}
+
+template<typename Dialect>
+const std::map<std::pair<uint64_t, uint64_t>, typename action_costs_table<Dialect>::costs>& action_costs_table<Dialect>::pending() const
+{
+    return m_costs;
+}
+
+template<typename Dialect>
+void action_costs_table<Dialect>::flush(bool now)
+{
+    const auto time = std::chrono::steady_clock::now();
+    if (!now && time - m_last_flush < m_refresh) {
+        return;
+    }
+
+    for (const auto& action : m_costs) {
+        const auto& costs = action.second;
+        m_writer->exec(m_add,
+                name_string(action.first.first),
+                name_string(action.first.second),
+                costs.actions,
+                costs.skipped,
+                costs.bytes,
+                costs.abi_us,
+                costs.decode_us,
+                costs.sql_us,
+                costs.abi_us + costs.decode_us + costs.sql_us);
+    }
+    m_costs.clear();
+    m_last_flush = time;
+}
+
+SQL_DB_INSTANTIATE_DIALECTS(action_costs_table)
+
+} // namespace
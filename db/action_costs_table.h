@@ -0,0 +1,64 @@
+#ifndef ACTION_COSTS_TABLE_H
+#define ACTION_COSTS_TABLE_H
+
+#include <chrono>
+#include <map>
+#include <memory>
+
+#include <soci/soci.h>
+
+#include <eosio/chain/types.hpp>
+
+#include "sql_dialect.h"
+#include "sql_writer.h"
+
+namespace eosio {
+
+// What the actions of each contract action cost to ingest, in action_costs: their
+// number, the bytes of their raw data and the microseconds spent finding the ABI,
+// decoding and executing the SQL (queuing it only, with sql_db-pipeline), and the
+// actions skipped for want of an ABI with the time spent looking for it, so the
+// contracts that dominate the decode can be found with
+//   SELECT * FROM action_costs ORDER BY total_us DESC
+//
+// The costs are summed in memory and added to the table every refresh interval.
+template<typename Dialect>
+class action_costs_table
+{
+public:
+    struct costs {
+        int64_t actions = 0;
+        int64_t skipped = 0; // without an ABI: not written
+        int64_t bytes = 0;
+        int64_t abi_us = 0;
+        int64_t decode_us = 0;
+        int64_t sql_us = 0;
+    };
+
+    action_costs_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer);
+
+    void drop();
+    void create();
+    void set_refresh(std::chrono::seconds refresh);
+
+    void add(chain::account_name account, chain::action_name name, size_t bytes,
+             std::chrono::microseconds abi, std::chrono::microseconds decode, std::chrono::microseconds sql);
+    void add_skipped(chain::account_name account, chain::action_name name, std::chrono::microseconds abi);
+    // the costs not written yet
+    const std::map<std::pair<uint64_t, uint64_t>, costs>& pending() const;
+
+    // writes the costs if the refresh interval elapsed since the last time, or now
+    void flush(bool now = false);
+
+private:
+    std::shared_ptr<soci::session> m_session;
+    std::shared_ptr<sql_writer> m_writer;
+    std::chrono::seconds m_refresh{60};
+    std::chrono::steady_clock::time_point m_last_flush;
+    std::map<std::pair<uint64_t, uint64_t>, costs> m_costs;
+    const std::string m_add = Dialect::action_costs::add();
+};
+
+} // namespace
+
+#endif // ACTION_COSTS_TABLE_H
@@ -0,0 +1,37 @@
+#include "action_handlers.h"
+
+namespace eosio {
+
+constexpr uint64_t action_handlers::any_contract;
+
+void action_handlers::add(chain::account_name contract, chain::action_name action, handler h)
+{
+    auto& registered = m_handlers[{contract.value, action.value}];
+    if (!registered.run && contract.value == any_contract) {
+        m_any_contract++;
+    }
+    registered = std::move(h); // replaces the previous one
+}
+
+void action_handlers::remove(chain::account_name contract, chain::action_name action)
+{
+    if (m_handlers.erase({contract.value, action.value}) > 0 && contract.value == any_contract) {
+        m_any_contract--;
+    }
+}
+
+const action_handlers::handler* action_handlers::find(chain::account_name contract, chain::action_name action) const
+{
+    auto it = m_handlers.find({contract.value, action.value});
+    if (it == m_handlers.end() && m_any_contract > 0) {
+        it = m_handlers.find({any_contract, action.value});
+    }
+    return it != m_handlers.end() ? &it->second : nullptr;
+}
+
+bool action_handlers::empty() const
+{
+    return m_handlers.empty();
+}
+
+} // namespace
@@ -0,0 +1,60 @@
+#ifndef ACTION_HANDLERS_H
+#define ACTION_HANDLERS_H
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <eosio/chain/action.hpp>
+
+#include "abi_json_writer.h"
+
+namespace eosio {
+
+// What to do with an action besides storing it (balances, stakes, votes...),
+// by contract and action name. Run for the contract's own action only, not for
+// its notifications. A handler registered for any contract serves the
+// contracts without one of their own.
+class action_handlers
+{
+public:
+    using function = std::function<void(const chain::action& action, const decoded_action& decoded)>;
+
+    struct handler {
+        // the top level fields of the payload it reads: the action is skipped when one is missing
+        std::vector<std::string> fields;
+        // false: it reads action.data itself, decoded is empty
+        bool needs_decoded;
+        function run;
+        // Run instead when the contract's ABI describes the payload with this layout
+        // (abi_json_writer::layout()): it unpacks action.data into its own struct.
+        std::string layout;
+        std::function<void(const chain::action& action)> run_native;
+    };
+
+    static constexpr uint64_t any_contract = 0;
+
+    void add(chain::account_name contract, chain::action_name action, handler h);
+    void remove(chain::account_name contract, chain::action_name action);
+
+    // null when there is none
+    const handler* find(chain::account_name contract, chain::action_name action) const;
+
+    bool empty() const;
+
+private:
+    struct key_hash {
+        size_t operator()(const std::pair<uint64_t, uint64_t>& key) const
+        {
+            return std::hash<uint64_t>()(key.first * 0x9e3779b97f4a7c15ULL ^ key.second);
+        }
+    };
+
+    std::unordered_map<std::pair<uint64_t, uint64_t>, handler, key_hash> m_handlers;
+    size_t m_any_contract = 0; // handlers registered for any contract
+};
+
+} // namespace
+
+#endif // ACTION_HANDLERS_H
@@ -1,322 +1,585 @@
 #include "actions_table.h"
 
+#include <limits>
+
+#include <fc/crypto/city.hpp>
+
+#include "block_tracer.h"
+
 namespace eosio {
 
-actions_table::actions_table(std::shared_ptr<soci::session> session):
-    m_session(session)
+namespace {
+const fc::microseconds abi_serializer_max_time(1000000); // 1 second
+const size_t max_abi_versions = 256; // parsed, with their serializer and layouts
+const decoded_action not_decoded;
+}
+
+template<typename Dialect>
+actions_table<Dialect>::actions_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer, std::shared_ptr<name_cache> names, std::shared_ptr<account_set<Dialect>> accounts, std::shared_ptr<rollups_table<Dialect>> rollups):
+    m_session(session),
+    m_writer(writer),
+    m_names(names),
+    m_accounts(accounts),
+    m_rollups(rollups),
+    m_abi_history(session, writer)
 {
-    backend = m_session->get_backend_name();
+    using namespace std::placeholders;
+    const chain::account_name system = chain::config::system_account_name;
+
+    this->add_handler(system, &actions_table::on_voteproducer);
+    this->add_handler(system, &actions_table::on_delegatebw);
+    m_handlers.add(system, chain::setabi::get_name(), {{}, false, std::bind(&actions_table::on_setabi, this, _1, _2)});
+    m_handlers.add(system, chain::newaccount::get_name(), {{}, false, std::bind(&actions_table::on_newaccount, this, _1, _2)});
+    this->set_token_contracts({N(eosio.token)});
 }
 
-void actions_table::drop()
+template<typename Dialect>
+void actions_table<Dialect>::drop()
 {
+    const char* cascade = Dialect::cascade();
+
     try {
-        *m_session << "drop table IF EXISTS actions_accounts CASCADE";
-        *m_session << "drop table IF EXISTS stakes CASCADE";
-        *m_session << "drop table IF EXISTS votes CASCADE";
-        *m_session << "drop table IF EXISTS tokens CASCADE";
-        *m_session << "drop table IF EXISTS actions CASCADE";
+        *m_session << "drop table IF EXISTS actions_accounts" << cascade;
+        *m_session << "drop table IF EXISTS stakes" << cascade;
+        *m_session << "drop table IF EXISTS votes" << cascade;
+        *m_session << "drop table IF EXISTS tokens" << cascade;
+        *m_session << "drop table IF EXISTS actions" << cascade;
+        *m_session << "drop table IF EXISTS payloads" << cascade;
     }
     catch(std::exception& e){
         wlog(e.what());
     }
+    payload_compressor::drop(*m_session);
+    m_abi_history.drop();
+    this->clear_rows();
+    if (m_payloads) {
+        m_payloads->clear();
+    }
 }
 
-void actions_table::create()
+template<typename Dialect>
+void actions_table<Dialect>::create(const index_options& indexes)
 {
-    if (backend == "postgresql") {
-        this->create_postgresql();
-    }
-    else if (backend == "mysql") {
-        this->create_mysql();
-    }
+    Dialect::actions::create(*m_session);
+    payload_compressor::create(*m_session);
+    m_abi_history.create();
 
     // indices
 
-    *m_session << "CREATE INDEX idx_actions_account ON actions (account);";
-    *m_session << "CREATE INDEX idx_actions_tx_id ON actions (transaction_id);";
-    *m_session << "CREATE INDEX idx_actions_created ON actions (created_at);";
+    const bool append_only = indexes.append_only();
+    const char* monotonic = append_only ? Dialect::monotonic_index() : "";
+    const char* equality = append_only ? Dialect::equality_index() : "";
 
-    *m_session << "CREATE INDEX idx_actions_actor ON actions_accounts (actor);";
-    *m_session << "CREATE INDEX idx_actions_action_id ON actions_accounts (action_id);";
+    if (!append_only) { // else the history indexes serve the same searches
+        *m_session << "CREATE INDEX idx_actions_account ON actions (account);";
+        *m_session << "CREATE INDEX idx_actions_actor ON actions_accounts (actor);";
+    }
+    *m_session << "CREATE INDEX idx_actions_tx_id ON actions" << equality << " (transaction_id);";
+    *m_session << "CREATE INDEX idx_actions_created ON actions" << monotonic << " (created_at);";
+
+    // keyset pagination of the histories (history_query): newest first by (block_number, id).
+    // They cover the search of a page, only its rows are read from the table.
+    *m_session << "CREATE INDEX idx_actions_account_history ON actions (account, block_number, id);";
+    *m_session << "CREATE INDEX idx_actions_actor_history ON actions_accounts (actor, block_number, action_id);";
+    *m_session << "CREATE INDEX idx_actions_action_id ON actions_accounts" << monotonic << " (action_id);";
+
+    for (const auto& contract : indexes.hot_contracts) {
+        if (!Dialect::partial_indexes()) {
+            wlog("no index for the actions of ${c}: ${d} has no partial indexes", ("c", contract)("d", Dialect::name()));
+            continue;
+        }
+        *m_session << "CREATE INDEX idx_actions_hot_" << index_suffix(contract) << " ON actions (name, block_number, id)"
+                      " WHERE account = '" << contract << "';"; // a valid account name: nothing to escape
+    }
 
     *m_session << "CREATE INDEX idx_tokens_account ON tokens (account);";
 }
 
-void actions_table::add(chain::action action, chain::transaction_id_type transaction_id, fc::time_point_sec transaction_time, uint8_t seq)
+template<typename Dialect>
+void actions_table<Dialect>::set_compressed_payloads(bool enabled)
 {
+    if (enabled && !payload_compressor::supported()) {
+        throw std::runtime_error("compressed payloads need the plugin built with zstd");
+    }
+    m_writer->sync(); // the compressor reads its dictionaries
+    m_compressor.reset(enabled ? new payload_compressor(m_session, m_writer) : nullptr);
+}
 
-    chain::abi_def abi;
-    std::string abi_def_account;
-    chain::abi_serializer abis;
-    soci::indicator ind;
-    const auto transaction_id_str = transaction_id.str();
-    const auto expiration = boost::chrono::seconds{transaction_time.sec_since_epoch()}.count();
+template<typename Dialect>
+void actions_table<Dialect>::set_deduplicated_payloads(size_t cache_size)
+{
+    m_payloads.reset(cache_size > 0 ? new payload_store<Dialect>(m_writer, cache_size) : nullptr);
+}
 
-    *m_session << "SELECT abi FROM accounts WHERE name = :name", soci::into(abi_def_account, ind), soci::use(action.account.to_string(), "name");
+template<typename Dialect>
+void actions_table<Dialect>::set_token_contracts(const std::vector<chain::account_name>& contracts)
+{
+    for (const auto contract : m_token_contracts) {
+        m_handlers.remove(contract, token_issue::name());
+        m_handlers.remove(contract, token_transfer::name());
+    }
+    for (const auto contract : contracts) {
+        this->add_handler(contract, &actions_table::on_issue);
+        this->add_handler(contract, &actions_table::on_transfer);
+    }
+    m_token_contracts = contracts;
+}
 
-    if (!abi_def_account.empty()) {
-        abi = fc::json::from_string(abi_def_account).as<chain::abi_def>();
-    } else if (action.account == chain::config::system_account_name) {
-        abi = chain::eosio_contract_abi(abi);
-    } else {
+template<typename Dialect>
+action_handlers& actions_table<Dialect>::handlers()
+{
+    return m_handlers;
+}
+
+template<typename Dialect>
+void actions_table<Dialect>::set_costs(std::shared_ptr<action_costs_table<Dialect>> costs)
+{
+    m_costs = costs;
+}
+
+template<typename Dialect>
+void actions_table<Dialect>::add(uint32_t block_num, chain::action action, chain::account_name receiver, chain::transaction_id_type transaction_id, fc::time_point_sec transaction_time, int seq, int parent)
+{
+    using clock = std::chrono::steady_clock;
+    const auto start = m_costs ? clock::now() : clock::time_point();
+
+    m_block_num = block_num;
+    std::shared_ptr<contract_abi> abi;
+    {
+        trace_scope span("abi", block_num);
+        abi = this->get_abi(action.account, block_num);
+    }
+    if (!abi) {
+        if (m_costs) {
+            m_costs->add_skipped(action.account, action.name, std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start));
+        }
         return; // no ABI no party. Should we still store it?
     }
+    const auto found = m_costs ? clock::now() : clock::time_point();
+
+    hex_string(transaction_id.data(), transaction_id.data_size(), m_transaction_id);
+    const auto expiration = boost::chrono::seconds{transaction_time.sec_since_epoch()}.count();
 
-    static const fc::microseconds abi_serializer_max_time(1000000); // 1 second
-    abis.set_abi(abi, abi_serializer_max_time);
+    uint64_t payload_id = 0;
+    bool stored = false;
+    if (m_payloads) {
+        payload_id = payload_store<Dialect>::id(action, abi->hash);
+        stored = m_payloads->contains(payload_id);
+    }
+    // a notification runs no handler: the state changes are tracked on the contract's own action
+    const auto* handler = receiver == action.account ? m_handlers.find(action.account, action.name) : nullptr;
+    const bool native = handler && this->native_layout(*handler, action.name, *abi);
+
+    if (!stored || (handler && !native && handler->needs_decoded)) { // a native handler unpacks action.data itself
+        trace_scope span("decode", block_num);
+        abi->writer.write(action.name, action.data, m_decoded);
+        if (m_compressor && !stored) {
+            m_compressor->compress(action.account, action.name, m_decoded.json, m_payload);
+        }
+    }
+    const auto decoded = m_costs ? clock::now() : clock::time_point();
+    if (m_payloads && !stored) {
+        m_payloads->add(payload_id, m_compressor ? m_payload : m_decoded.json, m_compressor != nullptr);
+    }
 
-    auto abi_data = abis.binary_to_variant(abis.get_action_type(action.name), action.data, abi_serializer_max_time);
-    string json = fc::json::to_string(abi_data);
+    trace_scope span("actions", block_num);
 
-    boost::uuids::random_generator gen;
-    boost::uuids::uuid id = gen();
-    std::string action_id = boost::uuids::to_string(id);
+    m_accounts->add(action.account);
+    m_accounts->add(receiver);
+    for (const auto& auth : action.authorization) {
+        m_accounts->add(auth.actor);
+    }
 
-    *m_session << this->add_action(),
-            soci::use(action.account.to_string(), "ac"),
-            soci::use(seq, "se"),
-            soci::use(expiration, "ca"),
-            soci::use(action.name.to_string(), "na"),
-            soci::use(json, "da"),
-            soci::use(transaction_id_str, "ti");
+    bool full = false;
+    if (m_payloads) {
+        full = m_deduplicated_rows.add(
+                block_num,
+                m_names->get(action.account),
+                m_names->get(receiver),
+                seq,
+                parent < 0 ? boost::optional<int>() : boost::optional<int>(parent),
+                expiration,
+                m_names->get(action.name),
+                static_cast<long long>(payload_id),
+                m_transaction_id);
+    } else {
+        full = (m_compressor ? m_compressed_rows : m_action_rows).add(
+                block_num,
+                m_names->get(action.account),
+                m_names->get(receiver),
+                seq,
+                parent < 0 ? boost::optional<int>() : boost::optional<int>(parent),
+                expiration,
+                m_names->get(action.name),
+                m_compressor ? m_payload : m_decoded.json,
+                m_transaction_id);
+    }
 
+    if (full) {
+        this->flush();
+    }
     for (const auto& auth : action.authorization) {
-        *m_session << this->add_action_account(),
-                soci::use(auth.actor.to_string(), "ac"),
-                soci::use(auth.permission.to_string(), "pe");
+        if (m_account_rows.add(
+                block_num,
+                m_transaction_id,
+                seq,
+                block_num,
+                m_names->get(auth.actor),
+                m_names->get(auth.permission))) {
+            this->flush();
+        }
     }
-    try {
-        parse_actions(action, abi_data);
-    } catch(std::exception& e){
-        wlog(e.what());
+    if (handler) {
+        this->run_handler(action, *handler, native);
+    }
+
+    if (m_costs) {
+        using std::chrono::duration_cast;
+        using std::chrono::microseconds;
+        m_costs->add(action.account, action.name, action.data.size(),
+                     duration_cast<microseconds>(found - start),
+                     duration_cast<microseconds>(decoded - found),
+                     duration_cast<microseconds>(clock::now() - decoded));
     }
 }
 
-void actions_table::parse_actions(chain::action action, fc::variant abi_data)
+template<typename Dialect>
+void actions_table<Dialect>::remove(uint32_t first_block, uint32_t last_block)
 {
-    // TODO: move all  + catch // public keys update // stake / voting
-    if (action.name == N(issue)) {
-        auto to_name = abi_data["to"].as<chain::name>().to_string();
-        auto asset_quantity = abi_data["quantity"].as<chain::asset>();
-        int exist;
-
-        *m_session << "SELECT COUNT(*) FROM tokens WHERE account = :ac AND symbol = :sy",
-                soci::into(exist),
-                soci::use(to_name, "ac"),
-                soci::use(asset_quantity.get_symbol().name(), "sy");
-        if (exist > 0) {
-            *m_session << "UPDATE tokens SET amount = amount + :am WHERE account = :ac AND symbol = :sy",
-                    soci::use(asset_quantity.to_real(), "am"),
-                    soci::use(to_name, "ac"),
-                    soci::use(asset_quantity.get_symbol().name(), "sy");
-        } else {
-            *m_session << "INSERT INTO tokens (account, amount, symbol) VALUES (:ac, :am, :sy)",
-                    soci::use(to_name, "ac"),
-                    soci::use(asset_quantity.to_real(), "am"),
-                    soci::use(asset_quantity.get_symbol().name(), "sy");
-        }
-    }
+    this->flush();
+    m_writer->exec("DELETE FROM actions_accounts WHERE block_number BETWEEN :fi AND :la",
+            first_block,
+            last_block);
+    m_writer->exec("DELETE FROM actions WHERE block_number BETWEEN :fi AND :la",
+            first_block,
+            last_block);
+}
 
-    if (action.name == N(transfer)) {
-        auto from_name = abi_data["from"].as<chain::name>().to_string();
-        auto to_name = abi_data["to"].as<chain::name>().to_string();
-        auto asset_quantity = abi_data["quantity"].as<chain::asset>();
-        int exist;
-
-        *m_session << "SELECT COUNT(*) FROM tokens WHERE account = :ac AND symbol = :sy",
-                soci::into(exist),
-                soci::use(to_name, "ac"),
-                soci::use(asset_quantity.get_symbol().name(), "sy");
-        if (exist > 0) {
-            *m_session << "UPDATE tokens SET amount = amount + :am WHERE account = :ac AND symbol = :sy",
-                    soci::use(asset_quantity.to_real(), "am"),
-                    soci::use(to_name, "ac"),
-                    soci::use(asset_quantity.get_symbol().name(), "sy");
-        } else {
-            *m_session << "INSERT INTO tokens (account, amount, symbol) VALUES (:ac, :am, :sy) ",
-                    soci::use(to_name, "ac"),
-                    soci::use(asset_quantity.to_real(), "am"),
-                    soci::use(asset_quantity.get_symbol().name(), "sy");
-        }
+template<typename Dialect>
+void actions_table<Dialect>::flush()
+{
+    // the actions first: the actions_accounts rows look them up
+    m_writer->exec(m_action_rows);
+    m_writer->exec(m_compressed_rows);
+    m_writer->exec(m_deduplicated_rows);
+    m_writer->exec(m_account_rows);
+}
 
-        *m_session << "UPDATE tokens SET amount = amount - :am WHERE account = :ac AND symbol = :sy",
-                soci::use(asset_quantity.to_real(), "am"),
-                soci::use(from_name, "ac"),
-                soci::use(asset_quantity.get_symbol().name(), "sy");
+template<typename Dialect>
+void actions_table<Dialect>::commit()
+{
+    m_missing_abis.clear();
+    if (m_payloads) {
+        m_payloads->commit();
     }
+    if (m_compressor) {
+        m_compressor->commit();
+    }
+}
 
-    if (action.account != chain::name(chain::config::system_account_name)) {
-        return;
+template<typename Dialect>
+void actions_table<Dialect>::rollback()
+{
+    this->clear_rows();
+    m_abi_cache.clear(); // the setabi of the batch are not written
+    m_missing_abis.clear();
+    m_abi_history.rollback();
+    if (m_payloads) {
+        m_payloads->rollback();
+    }
+    if (m_compressor) {
+        m_compressor->rollback(); // the dictionaries trained by the batch are not written
     }
+}
 
-    if (action.name == N(voteproducer)) {
-        auto voter = abi_data["voter"].as<chain::name>().to_string();
-        string votes = fc::json::to_string(abi_data["producers"]);
+template<typename Dialect>
+void actions_table<Dialect>::reload_abi_versions()
+{
+    m_abi_history.reload();
+}
 
-        *m_session << this->upsert_votes(),
-                soci::use(voter, "ac"),
-                soci::use(votes, "vo");
+template<typename Dialect>
+bool actions_table<Dialect>::native_layout(const action_handlers::handler& handler, chain::action_name action, contract_abi& abi)
+{
+    if (!handler.run_native) {
+        return false;
     }
+    auto layout = abi.layouts.find(action.value);
+    if (layout == abi.layouts.end()) {
+        layout = abi.layouts.emplace(action.value, abi.writer.layout(action)).first;
+    }
+    return layout->second == handler.layout;
+}
 
+template<typename Dialect>
+void actions_table<Dialect>::run_handler(const chain::action& action, const action_handlers::handler& handler, bool native)
+{
+    if (native) {
+        try {
+            handler.run_native(action);
+        } catch(std::exception& e){
+            wlog(e.what());
+        }
+        return;
+    }
 
-    if (action.name == N(delegatebw)) {
-        auto account = abi_data["receiver"].as<chain::name>().to_string();
-        auto cpu = abi_data["stake_cpu_quantity"].as<chain::asset>();
-        auto net = abi_data["stake_net_quantity"].as<chain::asset>();
+    if (handler.needs_decoded) {
+        for (const auto& field : handler.fields) {
+            if (!m_decoded.has(field)) {
+                return; // another action under the same name: not the one the handler knows
+            }
+        }
+    }
 
-        *m_session << this->upsert_stakes(),
-                soci::use(account, "ac"),
-                soci::use(cpu.to_real(), "cp"),
-                soci::use(net.to_real(), "ne");
+    try {
+        handler.run(action, handler.needs_decoded ? m_decoded : not_decoded);
+    } catch(std::exception& e){
+        wlog(e.what());
     }
+}
 
-    if (action.name == chain::setabi::get_name()) {
-        chain::abi_def abi_setabi;
-        chain::setabi action_data = action.data_as<chain::setabi>();
-        chain::abi_serializer::to_abi(action_data.abi, abi_setabi);
-        string abi_string = fc::json::to_string(abi_setabi);
+template<typename Dialect>
+template<typename Payload>
+void actions_table<Dialect>::add_handler(chain::account_name contract, void (actions_table::*method)(const chain::action&, const Payload&))
+{
+    m_handlers.add(contract, Payload::name(), {
+        Payload::fields(),
+        true,
+        [this, method](const chain::action& action, const decoded_action& decoded) {
+            (this->*method)(action, Payload::from_decoded(decoded));
+        },
+        Payload::layout(),
+        [this, method](const chain::action& action) {
+            (this->*method)(action, fc::raw::unpack<Payload>(action.data));
+        }});
+}
 
-        *m_session << "UPDATE accounts SET abi = :abi, updated_at = NOW() WHERE name = :name",
-                soci::use(abi_string, "abi"),
-                soci::use(action_data.account.to_string(), "name");
+template<typename Dialect>
+void actions_table<Dialect>::on_issue(const chain::action&, const token_issue& payload)
+{
+    m_accounts->add(payload.to);
+    this->add_tokens(m_names->get(payload.to), payload.quantity);
+}
 
-    } else if (action.name == chain::newaccount::get_name()) {
-        auto action_data = action.data_as<chain::newaccount>();
-        *m_session << "INSERT INTO accounts (name) VALUES (:name)",
-                soci::use(action_data.name.to_string(), "name");
+template<typename Dialect>
+void actions_table<Dialect>::on_transfer(const chain::action& action, const token_transfer& payload)
+{
+    m_accounts->add(payload.from);
+    m_accounts->add(payload.to);
+    this->add_tokens(m_names->get(payload.to), payload.quantity);
 
-        for (const auto& key_owner : action_data.owner.keys) {
-            string permission_owner = "owner";
-            string public_key_owner = static_cast<string>(key_owner.key);
-            *m_session << "INSERT INTO accounts_keys (account, public_key, permission) VALUES (:ac, :ke, :pe)",
-                    soci::use(action_data.name.to_string(), "ac"),
-                    soci::use(public_key_owner, "ke"),
-                    soci::use(permission_owner, "pe");
-        }
+    m_writer->exec("UPDATE tokens SET amount = amount - :am WHERE account = :ac AND symbol = :sy",
+            payload.quantity.to_real(),
+            m_names->get(payload.from),
+            payload.quantity.get_symbol().name());
 
-        for (const auto& key_active : action_data.active.keys) {
-            string permission_active = "active";
-            string public_key_active = static_cast<string>(key_active.key);
-            *m_session << "INSERT INTO accounts_keys (account, public_key, permission) VALUES (:ac, :ke, :pe)",
-                    soci::use(action_data.name.to_string(), "ac"),
-                    soci::use(public_key_active, "ke"),
-                    soci::use(permission_active, "pe");
-        }
+    if (m_rollups) {
+        m_rollups->add_transfer(action.account, payload.quantity);
+    }
+}
 
+template<typename Dialect>
+void actions_table<Dialect>::on_voteproducer(const chain::action&, const system_voteproducer& payload)
+{
+    std::string votes = "[";
+    for (const auto& producer : payload.producers) {
+        if (votes.size() > 1) {
+            votes += ',';
+        }
+        votes += '"';
+        votes += m_names->get(producer); // [a-z1-5.]: nothing to escape
+        votes += '"';
     }
+    votes += ']';
+
+    m_accounts->add(payload.voter);
+    m_writer->exec(m_upsert_votes,
+            m_names->get(payload.voter),
+            votes);
 }
 
-// private
+template<typename Dialect>
+void actions_table<Dialect>::on_delegatebw(const chain::action&, const system_delegatebw& payload)
+{
+    m_accounts->add(payload.receiver);
+    m_writer->exec(m_upsert_stakes,
+            m_names->get(payload.receiver),
+            payload.stake_cpu_quantity.to_real(),
+            payload.stake_net_quantity.to_real());
+}
 
-void actions_table::create_mysql()
+template<typename Dialect>
+void actions_table<Dialect>::add_abi_version(uint32_t block_num, const chain::action& action)
 {
-   *m_session << "CREATE TABLE actions("
-            "id INT NOT NULL AUTO_INCREMENT PRIMARY KEY,"
-            "account VARCHAR(12),"
-            "transaction_id VARCHAR(64),"
-            "seq SMALLINT,"
-            "parent INT DEFAULT NULL,"
-            "name VARCHAR(12),"
-            "created_at DATETIME DEFAULT NOW(),"
-            "data JSON, FOREIGN KEY (transaction_id) REFERENCES transactions(id) ON DELETE CASCADE,"
-            "FOREIGN KEY (account) REFERENCES accounts(name)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
-
-    *m_session << "CREATE TABLE actions_accounts("
-            "actor VARCHAR(12),"
-            "permission VARCHAR(12),"
-            "action_id INT NOT NULL, FOREIGN KEY (action_id) REFERENCES actions(id) ON DELETE CASCADE,"
-            "FOREIGN KEY (actor) REFERENCES accounts(name)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
-
-    *m_session << "CREATE TABLE tokens("
-            "account VARCHAR(13),"
-            "symbol VARCHAR(10),"
-            "amount DOUBLE(64,4),"
-            "FOREIGN KEY (account) REFERENCES accounts(name)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;"; // TODO: other tokens could have diff format.
-
-    *m_session << "CREATE TABLE stakes("
-            "account VARCHAR(13) PRIMARY KEY,"
-            "cpu REAL(14,4),"
-            "net REAL(14,4),"
-            "FOREIGN KEY (account) REFERENCES accounts(name)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
-
-    *m_session << "CREATE TABLE votes("
-            "account VARCHAR(13) PRIMARY KEY,"
-            "votes JSON"
-            ", FOREIGN KEY (account) REFERENCES accounts(name), UNIQUE KEY account (account)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+    chain::abi_def abi_setabi;
+    chain::setabi action_data = action.data_as<chain::setabi>();
+    chain::abi_serializer::to_abi(action_data.abi, abi_setabi);
+    m_abi_history.add(action_data.account, block_num, fc::json::to_string(abi_setabi));
 }
 
-void actions_table::create_postgresql()
+template<typename Dialect>
+void actions_table<Dialect>::on_setabi(const chain::action& action, const decoded_action&)
 {
-    *m_session << "CREATE TABLE actions ("
-            "id SERIAL PRIMARY KEY,"
-            "account TEXT REFERENCES accounts (name),"
-            "transaction_id TEXT REFERENCES transactions (id) ON DELETE CASCADE,"
-            "seq INT,"
-            "parent INT DEFAULT NULL,"
-            "name TEXT,"
-            "created_at TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP,"
-            "data JSONB);";
-
-    *m_session << "CREATE TABLE actions_accounts ("
-            "actor TEXT REFERENCES accounts (name),"
-            "permission TEXT,"
-            "action_id INT NOT NULL REFERENCES actions (id) ON DELETE CASCADE)";
-
-    *m_session << "CREATE TABLE tokens ("
-            "account TEXT REFERENCES accounts (name),"
-            "symbol TEXT,"
-            "amount DOUBLE PRECISION);"; // TODO: other tokens could have diff format.
-
-    *m_session << "CREATE TABLE stakes("
-            "account text PRIMARY KEY REFERENCES accounts (name),"
-            "cpu REAL,"
-            "net REAL);";
-
-    *m_session << "CREATE TABLE votes ("
-            "account text PRIMARY KEY REFERENCES accounts (name),"
-            "votes JSONB);";
+    chain::abi_def abi_setabi;
+    chain::setabi action_data = action.data_as<chain::setabi>();
+    chain::abi_serializer::to_abi(action_data.abi, abi_setabi);
+    string abi_string = fc::json::to_string(abi_setabi);
 
+    const auto hash = m_abi_history.add(action_data.account, m_block_num, abi_string);
+    auto abi = std::make_shared<contract_abi>(abi_setabi, abi_serializer_max_time);
+    this->keep_abi_version(hash, abi);
+
+    if (m_abi_history.find(action_data.account, std::numeric_limits<uint32_t>::max())->block_num != m_block_num) {
+        return; // an older block written after a newer setabi: not the current ABI
+    }
+    m_abi_cache[action_data.account] = abi;
+    m_missing_abis.erase(action_data.account);
+
+    m_accounts->add(action_data.account);
+    m_writer->exec("UPDATE accounts SET abi = :abi, updated_at = CURRENT_TIMESTAMP WHERE name = :name",
+            abi_string,
+            action_data.account.to_string());
 }
 
-// actions_table::add_action() defaults to MySQL syntax
-std::string actions_table::add_action()
+template<typename Dialect>
+void actions_table<Dialect>::on_newaccount(const chain::action& action, const decoded_action&)
 {
-    if (backend == "postgresql") {
-        return "INSERT INTO actions (account, seq, created_at, name, data, transaction_id) VALUES (:ac, :se, TO_TIMESTAMP(:ca), :na, :da, :ti)";
+    auto action_data = action.data_as<chain::newaccount>();
+    const auto account_name = action_data.name.to_string();
+    m_accounts->add(action_data.name); // already there if a backfill wrote a later action naming it
+
+    for (const auto& key_owner : action_data.owner.keys) {
+        string permission_owner = "owner";
+        string public_key_owner = static_cast<string>(key_owner.key);
+        m_writer->exec("INSERT INTO accounts_keys (account, public_key, permission) VALUES (:ac, :ke, :pe)",
+                account_name,
+                public_key_owner,
+                permission_owner);
     }
 
-    return "INSERT INTO actions (account, seq, created_at, name, data, transaction_id) VALUES (:ac, :se, FROM_UNIXTIME(:ca), :na, :da, :ti)";
+    for (const auto& key_active : action_data.active.keys) {
+        string permission_active = "active";
+        string public_key_active = static_cast<string>(key_active.key);
+        m_writer->exec("INSERT INTO accounts_keys (account, public_key, permission) VALUES (:ac, :ke, :pe)",
+                account_name,
+                public_key_active,
+                permission_active);
+    }
 }
 
-// actions_table::add_action_account() defaults to MySQL syntax
-std::string actions_table::add_action_account()
+// private
+
+template<typename Dialect>
+void actions_table<Dialect>::clear_rows()
 {
-    if (backend == "postgresql") {
-        return "INSERT INTO actions_accounts (action_id, actor, permission) VALUES (currval('actions_id_seq'), :ac, :pe)";
-    }
+    m_action_rows.clear();
+    m_compressed_rows.clear();
+    m_deduplicated_rows.clear();
+    m_account_rows.clear();
+}
 
-   return "INSERT INTO actions_accounts (action_id, actor, permission) VALUES (LAST_INSERT_ID(), :ac, :pe)";
+template<typename Dialect>
+actions_table<Dialect>::contract_abi::contract_abi(const chain::abi_def& abi, const fc::microseconds& max_serialization_time):
+    serializer(abi, max_serialization_time),
+    writer(abi, serializer, max_serialization_time)
+{
+    const auto packed = fc::raw::pack(abi);
+    hash = fc::city_hash64(packed.data(), packed.size());
 }
 
-// actions_table::upsert_stakes() defaults to MySQL syntax
-std::string actions_table::upsert_stakes()
+// The ABI set by the account at block_num or before. Without one in the history (set
+// before the plugin started writing), the current one: ABIs are parsed once per
+// account and cached, setabi replaces the entry. An account without one is not
+// looked up again until the end of the batch.
+template<typename Dialect>
+std::shared_ptr<typename actions_table<Dialect>::contract_abi> actions_table<Dialect>::get_abi(chain::account_name account, uint32_t block_num)
 {
-    if (backend == "postgresql") {
-        return "INSERT INTO stakes (account, cpu, net) VALUES (:ac, :cp, :ne) ON CONFLICT (account) DO UPDATE SET cpu=EXCLUDED.cpu, net=EXCLUDED.net";
+    const auto version = m_abi_history.find(account, block_num);
+    if (version) {
+        auto abi = this->find_abi_version(version->hash);
+        if (!abi) {
+            const auto abi_json = m_abi_history.get(account, version->block_num);
+            abi = std::make_shared<contract_abi>(fc::json::from_string(abi_json).as<chain::abi_def>(), abi_serializer_max_time);
+            this->keep_abi_version(version->hash, abi);
+        }
+        return abi;
+    }
+
+    auto it = m_abi_cache.find(account);
+    if (it != m_abi_cache.end()) {
+        return it->second;
     }
+    if (m_missing_abis.count(account)) {
+        return nullptr;
+    }
+
+    m_writer->sync(); // the session is used directly
+    std::string abi_def_account;
+    soci::indicator ind;
+    *m_session << "SELECT abi FROM accounts WHERE name = :name", soci::into(abi_def_account, ind), soci::use(account.to_string(), "name");
 
-    return "REPLACE INTO stakes(account, cpu, net) VALUES (:ac, :cp, :ne)";
+    std::shared_ptr<contract_abi> abi;
+    if (!abi_def_account.empty()) {
+        abi = std::make_shared<contract_abi>(fc::json::from_string(abi_def_account).as<chain::abi_def>(), abi_serializer_max_time);
+    } else if (account == chain::config::system_account_name) {
+        chain::abi_def system_abi;
+        abi = std::make_shared<contract_abi>(chain::eosio_contract_abi(system_abi), abi_serializer_max_time);
+    }
+
+    if (abi) {
+        m_abi_cache[account] = abi;
+    } else {
+        m_missing_abis.insert(account);
+    }
+    return abi;
+}
+
+template<typename Dialect>
+void actions_table<Dialect>::add_tokens(const std::string& account, const chain::asset& quantity)
+{
+    const auto symbol = quantity.get_symbol().name();
+
+    m_writer->exec("UPDATE tokens SET amount = amount + :am WHERE account = :ac AND symbol = :sy",
+            quantity.to_real(),
+            account,
+            symbol);
+    m_writer->exec(m_insert_tokens,
+            account,
+            quantity.to_real(),
+            symbol,
+            account,
+            symbol);
 }
 
-// actions_table::upsert_votes() defaults to MySQL syntax
-std::string actions_table::upsert_votes()
+template<typename Dialect>
+std::shared_ptr<typename actions_table<Dialect>::contract_abi> actions_table<Dialect>::find_abi_version(uint64_t hash)
 {
-    if (backend == "postgresql") {
-        return "INSERT INTO votes (account, votes) VALUES (:ac, :vo) ON CONFLICT (account) DO UPDATE SET votes=EXCLUDED.votes";
+    auto it = m_abi_versions.find(hash);
+    if (it == m_abi_versions.end()) {
+        return nullptr;
     }
+    m_recent_abi_versions.splice(m_recent_abi_versions.begin(), m_recent_abi_versions, it->second.recent);
+    return it->second.abi;
+}
 
-    return "REPLACE INTO votes(account, votes) VALUES (:ac, :vo)";
+template<typename Dialect>
+void actions_table<Dialect>::keep_abi_version(uint64_t hash, std::shared_ptr<contract_abi> abi)
+{
+    auto it = m_abi_versions.find(hash);
+    if (it != m_abi_versions.end()) {
+        it->second.abi = abi;
+        m_recent_abi_versions.splice(m_recent_abi_versions.begin(), m_recent_abi_versions, it->second.recent);
+        return;
+    }
+
+    m_recent_abi_versions.push_front(hash);
+    m_abi_versions[hash] = abi_version{abi, m_recent_abi_versions.begin()};
+    if (m_recent_abi_versions.size() > max_abi_versions) {
+        m_abi_versions.erase(m_recent_abi_versions.back());
+        m_recent_abi_versions.pop_back();
+    }
 }
 
+SQL_DB_INSTANTIATE_DIALECTS(actions_table)
+
 } // namespace
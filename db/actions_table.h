@@ -1,49 +1,141 @@
 #ifndef ACTIONS_TABLE_H
 #define ACTIONS_TABLE_H
 
+#include <list>
+#include <map>
 #include <memory>
+#include <set>
+#include <unordered_map>
 
 #include <soci/soci.h>
 
 #include <fc/io/json.hpp>
 #include <fc/variant.hpp>
 
-#include <boost/uuid/uuid.hpp>
-#include <boost/uuid/uuid_io.hpp>
-#include <boost/uuid/uuid_generators.hpp>
-
 #include <eosio/chain/block_state.hpp>
 #include <eosio/chain/eosio_contract.hpp>
 #include <eosio/chain/abi_def.hpp>
 #include <eosio/chain/asset.hpp>
 #include <eosio/chain/abi_serializer.hpp>
 
+#include "abi_history.h"
+#include "action_costs_table.h"
+#include "abi_json_writer.h"
+#include "account_set.h"
+#include "action_handlers.h"
+#include "chain_strings.h"
+#include "index_options.h"
+#include "native_actions.h"
+#include "payload_codec.h"
+#include "payload_store.h"
+#include "rollups_table.h"
+#include "sql_dialect.h"
+#include "sql_writer.h"
+
 namespace eosio {
 
 using std::string;
 
+template<typename Dialect>
 class actions_table
 {
 public:
-    actions_table(std::shared_ptr<soci::session> session);
+    actions_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer, std::shared_ptr<name_cache> names, std::shared_ptr<account_set<Dialect>> accounts, std::shared_ptr<rollups_table<Dialect>> rollups = nullptr);
 
     void drop();
-    void create();
-    void add(chain::action action, chain::transaction_id_type transaction_id, fc::time_point_sec transaction_time, uint8_t seq);
+    void create(const index_options& indexes = index_options());
+    // data_zstd instead of data
+    void set_compressed_payloads(bool enabled);
+    // payload_id instead of data, remembering the ids of cache_size payloads. 0 disables it
+    void set_deduplicated_payloads(size_t cache_size);
+    // the contracts whose issue and transfer actions move tokens, chain::name(action_handlers::any_contract) for all of them
+    void set_token_contracts(const std::vector<chain::account_name>& contracts);
+    action_handlers& handlers();
+    // where the cost of each action is counted, null for none
+    void set_costs(std::shared_ptr<action_costs_table<Dialect>> costs);
+
+    // the actions of the blocks first_block - last_block. The tokens, stakes and votes they changed stay as they are.
+    void remove(uint32_t first_block, uint32_t last_block);
+    void add(uint32_t block_num, chain::action action, chain::account_name receiver, chain::transaction_id_type transaction_id, fc::time_point_sec transaction_time, int seq, int parent);
+    // only the ABI version set by a setabi action, for the backfill to know them all before decoding
+    void add_abi_version(uint32_t block_num, const chain::action& action);
+    // writes the rows staged by add(), at the latest before the batch commits
+    void flush();
+    // the outcome of the batch written since the last call
+    void commit();
+    void rollback();
+    // the ABI versions recorded by another writer, a backfill, are read again
+    void reload_abi_versions();
 
 private:
+    struct contract_abi {
+        contract_abi(const chain::abi_def& abi, const fc::microseconds& max_serialization_time);
+
+        uint64_t hash; // of the packed ABI
+        chain::abi_serializer serializer;
+        abi_json_writer writer;
+        std::unordered_map<uint64_t, std::string> layouts; // by action, filled on first use
+    };
+
+    struct abi_version {
+        std::shared_ptr<contract_abi> abi;
+        std::list<uint64_t>::iterator recent;
+    };
+
     std::shared_ptr<soci::session> m_session;
-    std::string backend;
+    std::shared_ptr<sql_writer> m_writer;
+    std::shared_ptr<name_cache> m_names;
+    std::shared_ptr<account_set<Dialect>> m_accounts;
+    std::shared_ptr<rollups_table<Dialect>> m_rollups;
+    std::shared_ptr<action_costs_table<Dialect>> m_costs;
+    std::map<chain::account_name, std::shared_ptr<contract_abi>> m_abi_cache; // the current ABIs
+    std::set<chain::account_name> m_missing_abis; // looked up without one in this batch: another writer can set it
+    abi_history<Dialect> m_abi_history;
+    std::unordered_map<uint64_t, abi_version> m_abi_versions; // by hash: parsed once for every account and block using it
+    std::list<uint64_t> m_recent_abi_versions; // most recent first: the others are parsed again from m_abi_history
+    uint32_t m_block_num = 0; // of the action being added
+    decoded_action m_decoded; // reused from action to action
+    std::string m_transaction_id;
+    std::unique_ptr<payload_compressor> m_compressor;
+    std::string m_payload;
+    std::unique_ptr<payload_store<Dialect>> m_payloads;
+
+    action_handlers m_handlers;
+    std::vector<chain::account_name> m_token_contracts;
+
+    void clear_rows();
+    std::shared_ptr<contract_abi> get_abi(chain::account_name account, uint32_t block_num);
+    std::shared_ptr<contract_abi> find_abi_version(uint64_t hash);
+    void keep_abi_version(uint64_t hash, std::shared_ptr<contract_abi> abi);
+    // the ABI describes the action as the handler's native struct
+    bool native_layout(const action_handlers::handler& handler, chain::action_name action, contract_abi& abi);
+    void run_handler(const chain::action& action, const action_handlers::handler& handler, bool native);
+    void add_tokens(const std::string& account, const chain::asset& quantity);
+
+    // registers the typed decoder of Payload and its fallback on the decoded JSON
+    template<typename Payload>
+    void add_handler(chain::account_name contract, void (actions_table::*method)(const chain::action&, const Payload&));
 
-    void parse_actions(chain::action action, fc::variant variant);
+    void on_issue(const chain::action& action, const token_issue& payload);
+    void on_transfer(const chain::action& action, const token_transfer& payload);
+    void on_voteproducer(const chain::action& action, const system_voteproducer& payload);
+    void on_delegatebw(const chain::action& action, const system_delegatebw& payload);
+    void on_setabi(const chain::action& action, const decoded_action& decoded);
+    void on_newaccount(const chain::action& action, const decoded_action& decoded);
 
-    std::string add_action();
-    std::string add_action_account();
-    std::string upsert_stakes();
-    std::string upsert_votes();
+    const std::string m_insert = Dialect::actions::insert();
+    const std::string m_insert_compressed = Dialect::actions::insert_compressed();
+    const std::string m_insert_deduplicated = Dialect::actions::insert_deduplicated();
+    const std::string m_insert_account = Dialect::actions::insert_account();
+    const std::string m_insert_tokens = Dialect::actions::insert_tokens();
+    const std::string m_upsert_stakes = Dialect::actions::upsert_stakes();
+    const std::string m_upsert_votes = Dialect::actions::upsert_votes();
 
-    void create_mysql();
-    void create_postgresql();
+    // the rows of the batch, written in bulk
+    sql_writer::bulk m_action_rows{m_insert};
+    sql_writer::bulk m_compressed_rows{m_insert_compressed};
+    sql_writer::bulk m_deduplicated_rows{m_insert_deduplicated};
+    sql_writer::bulk m_account_rows{m_insert_account};
 };
 
 } // namespace
@@ -0,0 +1,145 @@
+#include "block_capture.h"
+
+#include <cstring>
+#include <thread>
+
+#include <fc/io/raw.hpp>
+#include <fc/log/logger.hpp>
+
+namespace eosio {
+
+namespace {
+
+const char capture_magic[8] = {'S', 'Q', 'L', 'D', 'B', 'C', 'A', 'P'};
+const uint32_t capture_version = 1;
+const size_t header_size = sizeof(capture_magic) + sizeof(capture_version);
+
+// the transactions are not packed with the block state: rebuilt from the block
+void restore_transactions(chain::block_state& state)
+{
+    for (const auto& receipt : state.block->transactions) {
+        if (receipt.trx.contains<chain::packed_transaction>()) {
+            state.trxs.push_back(std::make_shared<chain::transaction_metadata>(receipt.trx.get<chain::packed_transaction>()));
+        }
+    }
+}
+
+}
+
+block_capture::block_capture(const std::string& path, std::shared_ptr<trace_buffer> traces):
+    m_file(path, std::ios::out | std::ios::binary | std::ios::trunc),
+    m_traces(traces),
+    m_start(std::chrono::steady_clock::now())
+{
+    FC_ASSERT(m_file.is_open(), "cannot open capture file ${p}", ("p", path));
+    m_file.write(capture_magic, sizeof(capture_magic));
+    m_file.write(reinterpret_cast<const char*>(&capture_version), sizeof(capture_version));
+}
+
+void block_capture::consume(const std::vector<chain::block_state_ptr>& blocks)
+{
+    const int64_t offset_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count();
+
+    for (const auto& block : blocks) {
+        const auto actions = m_traces ? m_traces->peek(block->id) : std::vector<transaction_actions>();
+
+        const auto size = fc::raw::pack_size(offset_us) + fc::raw::pack_size(*block) + fc::raw::pack_size(actions);
+        m_record.resize(size);
+        fc::datastream<char*> stream(m_record.data(), m_record.size());
+        fc::raw::pack(stream, offset_us);
+        fc::raw::pack(stream, *block);
+        fc::raw::pack(stream, actions);
+
+        const auto record_size = static_cast<uint32_t>(size);
+        m_file.write(reinterpret_cast<const char*>(&record_size), sizeof(record_size));
+        m_file.write(m_record.data(), m_record.size());
+    }
+    m_file.flush(); // a batch at a time: a crash loses the last one at most
+}
+
+block_capture_reader::block_capture_reader(const std::string& path):
+    m_file(path.c_str(), boost::interprocess::read_only),
+    m_region(m_file, boost::interprocess::read_only),
+    m_begin(static_cast<const char*>(m_region.get_address())),
+    m_end(m_begin + m_region.get_size()),
+    m_pos(m_begin + header_size)
+{
+    uint32_t version = 0;
+    FC_ASSERT(m_region.get_size() >= header_size && std::memcmp(m_begin, capture_magic, sizeof(capture_magic)) == 0,
+              "${p} is not a block capture", ("p", path));
+    std::memcpy(&version, m_begin + sizeof(capture_magic), sizeof(version));
+    FC_ASSERT(version == capture_version, "unsupported capture version ${v}", ("v", version));
+}
+
+bool block_capture_reader::next(captured_block& block)
+{
+    uint32_t size = 0;
+    if (static_cast<size_t>(m_end - m_pos) < sizeof(size)) {
+        return false;
+    }
+    std::memcpy(&size, m_pos, sizeof(size));
+    if (static_cast<size_t>(m_end - m_pos) - sizeof(size) < size) {
+        return false;
+    }
+
+    fc::datastream<const char*> stream(m_pos + sizeof(size), size);
+    auto state = std::make_shared<chain::block_state>();
+    fc::raw::unpack(stream, block.offset_us);
+    fc::raw::unpack(stream, *state);
+    fc::raw::unpack(stream, block.actions);
+    restore_transactions(*state);
+    block.block = state;
+
+    m_pos += sizeof(size) + size;
+    return true;
+}
+
+void block_capture_reader::rewind()
+{
+    m_pos = m_begin + header_size;
+}
+
+replay_stats replay_capture(block_capture_reader& reader, consumer_core<chain::block_state_ptr>& core,
+                            std::shared_ptr<trace_buffer> traces, size_t max_batch, bool recorded_timing)
+{
+    using clock = std::chrono::steady_clock;
+
+    replay_stats stats;
+    const auto start = clock::now();
+    std::vector<chain::block_state_ptr> batch;
+
+    auto consume = [&]() {
+        if (batch.empty()) {
+            return;
+        }
+        core.consume(batch);
+        stats.blocks += batch.size();
+        stats.batches++;
+        batch.clear();
+    };
+
+    captured_block captured;
+    while (reader.next(captured)) {
+        if (recorded_timing) {
+            const auto due = start + std::chrono::microseconds(captured.offset_us);
+            if (due > clock::now()) {
+                consume(); // what arrived before it, then wait for it as the consumer did
+                std::this_thread::sleep_until(due);
+            }
+        }
+
+        if (traces) {
+            traces->put(captured.block->id, std::move(captured.actions));
+        }
+        batch.push_back(captured.block);
+        if (max_batch > 0 && batch.size() >= max_batch) {
+            consume();
+        }
+    }
+    consume();
+
+    stats.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - start);
+    return stats;
+}
+
+} // namespace
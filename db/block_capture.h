@@ -0,0 +1,81 @@
+#ifndef BLOCK_CAPTURE_H
+#define BLOCK_CAPTURE_H
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <eosio/chain/block_state.hpp>
+
+#include "consumer_core.h"
+#include "trace_buffer.h"
+
+namespace eosio {
+
+// A block as it reached the consumer: the block state, the executed actions of
+// its transactions and when it arrived, in microseconds since the capture started.
+struct captured_block {
+    chain::block_state_ptr block;
+    std::vector<transaction_actions> actions;
+    int64_t offset_us;
+};
+
+// Records the blocks of every batch to a file, to replay the same workload later
+// (replay_capture()). Placed first in a fanout_core, it copies the executed actions
+// before the database takes them.
+//
+// The file is a header followed by one record per block: its size as a uint32
+// then the offset, the block state and the actions, packed with fc::raw.
+class block_capture : public consumer_core<chain::block_state_ptr>
+{
+public:
+    block_capture(const std::string& path, std::shared_ptr<trace_buffer> traces);
+
+    void consume(const std::vector<chain::block_state_ptr>& blocks) override;
+
+private:
+    std::ofstream m_file;
+    std::shared_ptr<trace_buffer> m_traces;
+    std::chrono::steady_clock::time_point m_start;
+    std::vector<char> m_record;
+};
+
+// Reads a capture through a read only mapping of the file.
+class block_capture_reader
+{
+public:
+    explicit block_capture_reader(const std::string& path);
+
+    // false at the end of the file, or at a record cut short by a crash of the capture
+    bool next(captured_block& block);
+    void rewind();
+
+private:
+    boost::interprocess::file_mapping m_file;
+    boost::interprocess::mapped_region m_region;
+    const char* m_begin;
+    const char* m_end;
+    const char* m_pos;
+};
+
+struct replay_stats {
+    size_t blocks = 0;
+    size_t batches = 0;
+    std::chrono::microseconds elapsed{0};
+};
+
+// Feeds a capture to core, the actions through traces (the one of the database).
+// At full speed the batches have max_batch blocks (0: no limit). At the recorded
+// pace each batch has the blocks that arrived since the previous one, as with
+// a consumer that keeps up.
+replay_stats replay_capture(block_capture_reader& reader, consumer_core<chain::block_state_ptr>& core,
+                            std::shared_ptr<trace_buffer> traces, size_t max_batch, bool recorded_timing);
+
+} // namespace
+
+#endif // BLOCK_CAPTURE_H
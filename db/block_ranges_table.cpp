@@ -0,0 +1,92 @@
+#include "block_ranges_table.h"
+
+#include <algorithm>
+#include <fc/log/logger.hpp>
+
+namespace eosio {
+
+template<typename Dialect>
+block_ranges_table<Dialect>::block_ranges_table(std::shared_ptr<soci::session> session):
+    m_session(session)
+{
+}
+
+template<typename Dialect>
+void block_ranges_table<Dialect>::drop()
+{
+    const char* cascade = Dialect::cascade();
+
+    try {
+        *m_session << "DROP TABLE IF EXISTS block_ranges" << cascade;
+        *m_session << "DROP TABLE IF EXISTS backfill_start" << cascade;
+    }
+    catch(std::exception& e){
+        wlog(e.what());
+    }
+}
+
+template<typename Dialect>
+void block_ranges_table<Dialect>::create()
+{
+    Dialect::block_ranges::create(*m_session);
+}
+
+template<typename Dialect>
+void block_ranges_table<Dialect>::add(uint32_t first_block, uint32_t last_block)
+{
+    *m_session << "INSERT INTO block_ranges (first_block, last_block) VALUES (:fi, :la)",
+            soci::use(first_block, "fi"),
+            soci::use(last_block, "la");
+}
+
+// returns the last block of the gapless run starting at first_block, or first_block - 1 if it is missing
+template<typename Dialect>
+uint32_t block_ranges_table<Dialect>::contiguous_end(uint32_t first_block)
+{
+    uint32_t end = first_block - 1;
+    long long first = 0;
+    long long last = 0;
+    // into() converts from the INT columns of every backend, row::get<>() wants their exact type
+    soci::statement statement = (m_session->prepare << "SELECT first_block, last_block FROM block_ranges ORDER BY first_block",
+            soci::into(first), soci::into(last));
+    statement.execute();
+
+    while (statement.fetch()) {
+        if (first > static_cast<long long>(end) + 1) {
+            break;
+        }
+        end = std::max(end, static_cast<uint32_t>(last));
+    }
+    return end;
+}
+
+template<typename Dialect>
+void block_ranges_table<Dialect>::set_start(uint32_t first_block)
+{
+    long long start = 0;
+    soci::indicator ind = soci::i_null;
+    *m_session << "SELECT MIN(first_block) FROM backfill_start", soci::into(start, ind);
+    if (ind == soci::i_ok && start <= first_block) {
+        return;
+    }
+
+    *m_session << "DELETE FROM backfill_start";
+    *m_session << "INSERT INTO backfill_start (first_block) VALUES (:fi)",
+            soci::use(first_block, "fi");
+}
+
+template<typename Dialect>
+uint32_t block_ranges_table<Dialect>::start()
+{
+    long long start = 0;
+    soci::indicator ind = soci::i_null;
+    *m_session << "SELECT MIN(first_block) FROM backfill_start", soci::into(start, ind);
+    if (ind != soci::i_ok) {
+        *m_session << "SELECT MIN(first_block) FROM block_ranges", soci::into(start, ind);
+    }
+    return ind == soci::i_ok ? static_cast<uint32_t>(start) : 1;
+}
+
+SQL_DB_INSTANTIATE_DIALECTS(block_ranges_table)
+
+} // namespace
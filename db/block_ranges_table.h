@@ -0,0 +1,34 @@
+#ifndef BLOCK_RANGES_TABLE_H
+#define BLOCK_RANGES_TABLE_H
+
+#include <memory>
+#include <soci/soci.h>
+
+#include "sql_dialect.h"
+
+namespace eosio {
+
+// Gap tracker: every completed range of blocks is recorded, so a reader can
+// find up to where the history is complete even if it was written out of order.
+template<typename Dialect>
+class block_ranges_table
+{
+public:
+    block_ranges_table(std::shared_ptr<soci::session> session);
+
+    void drop();
+    void create();
+    void add(uint32_t first_block, uint32_t last_block);
+    uint32_t contiguous_end(uint32_t first_block);
+    // the first block of the backfilled history: the lowest one recorded
+    void set_start(uint32_t first_block);
+    // without one recorded, the first block of the earliest range
+    uint32_t start();
+
+private:
+    std::shared_ptr<soci::session> m_session;
+};
+
+} // namespace
+
+#endif // BLOCK_RANGES_TABLE_H
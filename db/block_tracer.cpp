@@ -0,0 +1,156 @@
+#include "block_tracer.h"
+
+#include <cstdio>
+#include <fstream>
+
+#include <fc/log/logger.hpp>
+
+namespace eosio {
+
+constexpr size_t block_tracer::ring_size;
+
+block_tracer& block_tracer::instance()
+{
+    static block_tracer tracer;
+    return tracer;
+}
+
+block_tracer::block_tracer():
+    m_start(clock::now()),
+    m_last_write(m_start)
+{
+    for (auto& enqueued : m_enqueued) {
+        enqueued = -1;
+    }
+}
+
+void block_tracer::set_sampling(uint32_t every_blocks)
+{
+    m_every = every_blocks;
+}
+
+int64_t block_tracer::now() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - m_start).count();
+}
+
+void block_tracer::record(const char* name, uint32_t block_num, int64_t begin, int64_t end)
+{
+    auto& r = this->local_ring();
+    const auto i = r.next.load(std::memory_order_relaxed); // only this thread writes the ring
+    auto& s = r.spans[i % ring_size];
+
+    // seqlock: a reader drops the span if seq moved while it copied it
+    s.seq.store(2 * i + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.name = name;
+    s.block_num = block_num;
+    s.begin = begin;
+    s.end = end;
+    s.seq.store(2 * i + 2, std::memory_order_release);
+    r.next.store(i + 1, std::memory_order_release);
+}
+
+void block_tracer::enqueued(uint32_t block_num)
+{
+    if (this->sampled(block_num)) {
+        m_enqueued[block_num % m_enqueued.size()].store(this->now(), std::memory_order_relaxed);
+    }
+}
+
+void block_tracer::dequeued(uint32_t block_num)
+{
+    if (!this->sampled(block_num)) {
+        return;
+    }
+    const auto begin = m_enqueued[block_num % m_enqueued.size()].exchange(-1, std::memory_order_relaxed);
+    if (begin >= 0) {
+        this->record("queued", block_num, begin, this->now());
+    }
+}
+
+std::string block_tracer::chrome_json()
+{
+    std::string json = "{\"traceEvents\":[";
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(m_rings_mux);
+    for (const auto& r : m_rings) {
+        const auto next = r->next.load(std::memory_order_acquire);
+        for (auto i = next > ring_size ? next - ring_size : 0; i < next; ++i) {
+            const auto& s = r->spans[i % ring_size];
+            const auto seq = s.seq.load(std::memory_order_acquire);
+            if (seq != 2 * i + 2) {
+                continue; // overwritten since
+            }
+            const auto name = s.name;
+            const auto block_num = s.block_num;
+            const auto begin = s.begin;
+            const auto end = s.end;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) != seq) {
+                continue;
+            }
+
+            json += first ? "" : ",";
+            json += "{\"name\":\"";
+            json += name;
+            json += "\",\"cat\":\"block\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            json += std::to_string(r->thread);
+            json += ",\"ts\":";
+            json += std::to_string(begin);
+            json += ",\"dur\":";
+            json += std::to_string(end - begin);
+            json += ",\"args\":{\"block\":";
+            json += std::to_string(block_num);
+            json += "}}";
+            first = false;
+        }
+    }
+    json += "]}";
+    return json;
+}
+
+void block_tracer::set_output(const std::string& path, std::chrono::seconds period)
+{
+    std::lock_guard<std::mutex> lock(m_output_mux);
+    m_path = path;
+    m_period = period;
+}
+
+void block_tracer::write_if_due()
+{
+    std::unique_lock<std::mutex> lock(m_output_mux, std::try_to_lock);
+    if (!lock || m_path.empty() || clock::now() - m_last_write < m_period) {
+        return;
+    }
+    m_last_write = clock::now();
+
+    // replaced in one rename: a reader never sees half a file
+    const auto temporary = m_path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << this->chrome_json();
+        if (!out) {
+            wlog("cannot write the block trace to ${p}", ("p", temporary));
+            return;
+        }
+    }
+    std::rename(temporary.c_str(), m_path.c_str());
+}
+
+// private
+
+block_tracer::ring& block_tracer::local_ring()
+{
+    thread_local ring* local = nullptr;
+    if (!local) {
+        std::lock_guard<std::mutex> lock(m_rings_mux);
+        m_rings.push_back(std::make_unique<ring>());
+        local = m_rings.back().get();
+        local->thread = m_rings.size();
+    }
+    return *local;
+}
+
+} // namespace
@@ -0,0 +1,112 @@
+#ifndef BLOCK_TRACER_H
+#define BLOCK_TRACER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eosio {
+
+// Spans of the life of the sampled blocks in the plugin: the accepted_block
+// handler, the wait in the queue, the write of each table and the commit.
+//
+// Every thread records into a ring of its own without locks; the oldest spans
+// are overwritten. The rings are read on demand, or written periodically to a
+// file, as Chrome trace_event JSON (chrome://tracing, Perfetto). When a block is
+// not sampled a span costs a load and a modulo.
+class block_tracer
+{
+public:
+    using clock = std::chrono::steady_clock;
+    static constexpr size_t ring_size = 1 << 14; // spans per thread
+
+    static block_tracer& instance();
+
+    // one block every every_blocks, 0: off
+    void set_sampling(uint32_t every_blocks);
+    bool sampled(uint32_t block_num) const
+    {
+        const auto every = m_every.load(std::memory_order_relaxed);
+        return every > 0 && block_num % every == 0;
+    }
+
+    // microseconds since the tracer started
+    int64_t now() const;
+    void record(const char* name, uint32_t block_num, int64_t begin, int64_t end);
+
+    // the queue span of a block goes from enqueued() to dequeued()
+    void enqueued(uint32_t block_num);
+    void dequeued(uint32_t block_num);
+
+    std::string chrome_json();
+
+    // chrome_json() is written to path every period by write_if_due()
+    void set_output(const std::string& path, std::chrono::seconds period);
+    void write_if_due();
+
+private:
+    struct span {
+        std::atomic<uint64_t> seq{0}; // odd while written
+        const char* name;
+        uint32_t block_num;
+        int64_t begin;
+        int64_t end;
+    };
+
+    struct ring {
+        uint32_t thread;
+        std::atomic<uint64_t> next{0};
+        std::array<span, ring_size> spans;
+    };
+
+    block_tracer();
+    ring& local_ring();
+
+    std::atomic<uint32_t> m_every{0};
+    clock::time_point m_start;
+    std::array<std::atomic<int64_t>, 4096> m_enqueued; // by block number, modulo
+
+    std::mutex m_rings_mux;
+    std::vector<std::unique_ptr<ring>> m_rings; // kept when their thread ends: the tracer lives as long as the process
+
+    std::mutex m_output_mux;
+    std::string m_path;
+    std::chrono::seconds m_period{0};
+    clock::time_point m_last_write;
+};
+
+// Records the span of its scope when the block is sampled
+class trace_scope
+{
+public:
+    trace_scope(const char* name, uint32_t block_num):
+        m_name(name),
+        m_block_num(block_num),
+        m_begin(block_tracer::instance().sampled(block_num) ? block_tracer::instance().now() : -1)
+    {
+    }
+
+    ~trace_scope()
+    {
+        if (m_begin >= 0) {
+            auto& tracer = block_tracer::instance();
+            tracer.record(m_name, m_block_num, m_begin, tracer.now());
+        }
+    }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+private:
+    const char* m_name;
+    uint32_t m_block_num;
+    int64_t m_begin;
+};
+
+} // namespace
+
+#endif // BLOCK_TRACER_H
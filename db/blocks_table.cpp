@@ -4,116 +4,80 @@
 
 namespace eosio {
 
-blocks_table::blocks_table(std::shared_ptr<soci::session> session):
-        m_session(session)
+template<typename Dialect>
+blocks_table<Dialect>::blocks_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer, std::shared_ptr<name_cache> names, std::shared_ptr<account_set<Dialect>> accounts):
+        m_session(session),
+        m_writer(writer),
+        m_names(names),
+        m_accounts(accounts)
 {
-    backend = m_session->get_backend_name();
 }
 
-void blocks_table::drop()
+template<typename Dialect>
+void blocks_table<Dialect>::drop()
 {
+    const char* cascade = Dialect::cascade();
+
     try {
-        *m_session << "DROP TABLE IF EXISTS blocks CASCADE";
+        *m_session << "DROP TABLE IF EXISTS blocks" << cascade;
     }
     catch(std::exception& e){
         wlog(e.what());
     }
 }
 
-void blocks_table::create()
+template<typename Dialect>
+void blocks_table<Dialect>::create(const index_options& indexes)
 {
-    if (backend == "postgresql") {
-        this->create_postgresql();
-    }
-    else if (backend == "mysql") {
-        this->create_mysql();
-    }
+    Dialect::blocks::create(*m_session);
 
     // indices
 
+    const char* monotonic = indexes.append_only() ? Dialect::monotonic_index() : "";
+
     *m_session << "CREATE INDEX idx_blocks_producer ON blocks (producer);";
-    *m_session << "CREATE INDEX idx_blocks_number ON blocks (block_number);";
+    *m_session << "CREATE INDEX idx_blocks_number ON blocks" << monotonic << " (block_number);";
 }
 
-void blocks_table::add(chain::signed_block_ptr block)
+template<typename Dialect>
+void blocks_table<Dialect>::add(chain::signed_block_ptr block)
 {
-    const auto block_id_str = block->id().str();
-    const auto previous_block_id_str = block->previous.str();
-    const auto transaction_mroot_str = block->transaction_mroot.str();
-    const auto action_mroot_str = block->action_mroot.str();
+    const auto block_id_str = checksum_string(block->id());
+    const auto previous_block_id_str = checksum_string(block->previous);
+    const auto transaction_mroot_str = checksum_string(block->transaction_mroot);
+    const auto action_mroot_str = checksum_string(block->action_mroot);
     const auto timestamp = std::chrono::seconds{block->timestamp.operator fc::time_point().sec_since_epoch()}.count();
     const auto num_transactions = (int)block->transactions.size();
 
-    *m_session << this->add_block(),
-            soci::use(block_id_str, "id"),
-            soci::use(block->block_num(), "in"),
-            soci::use(previous_block_id_str, "pb"),
-            soci::use(timestamp, "ti"),
-            soci::use(transaction_mroot_str, "tr"),
-            soci::use(action_mroot_str, "ar"),
-            soci::use(block->producer.to_string(), "pa"),
-            soci::use(block->schedule_version, "ve"),
-            soci::use(block->confirmed, "pe"),
-            soci::use(num_transactions, "nt");
+    m_accounts->add(block->producer);
+    m_writer->exec(m_insert,
+            block_id_str,
+            block->block_num(),
+            previous_block_id_str,
+            timestamp,
+            transaction_mroot_str,
+            action_mroot_str,
+            m_names->get(block->producer),
+            block->schedule_version,
+            block->confirmed,
+            num_transactions);
 
     if (block->new_producers) {
         const auto new_producers = fc::json::to_string(block->new_producers->producers);
-        *m_session << "UPDATE blocks SET new_producers = :np WHERE id = :id",
-                soci::use(new_producers, "np"),
-                soci::use(block_id_str, "id");
+        m_writer->exec("UPDATE blocks SET new_producers = :np WHERE id = :id",
+                new_producers,
+                block_id_str);
     }
 }
 
-// private
-
-void blocks_table::create_mysql()
-{
-    *m_session << "CREATE TABLE blocks("
-        "id VARCHAR(64) PRIMARY KEY,"
-        "block_number INT NOT NULL AUTO_INCREMENT,"
-        "prev_block_id VARCHAR(64),"
-        "irreversible TINYINT(1) DEFAULT 0,"
-        "timestamp DATETIME DEFAULT NOW(),"
-        "transaction_merkle_root VARCHAR(64),"
-        "action_merkle_root VARCHAR(64),"
-        "producer VARCHAR(12),"
-        "version INT NOT NULL DEFAULT 0,"
-        "new_producers JSON DEFAULT NULL,"
-        "num_transactions INT DEFAULT 0,"
-        "confirmed INT, FOREIGN KEY (producer) REFERENCES accounts(name), UNIQUE KEY block_number (block_number)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
-}
-
-void blocks_table::create_postgresql()
+template<typename Dialect>
+void blocks_table<Dialect>::remove(uint32_t first_block, uint32_t last_block)
 {
-   *m_session << "CREATE TABLE blocks ("
-        "id TEXT PRIMARY KEY,"
-        "block_number SERIAL,"
-        "prev_block_id TEXT,"
-        "irreversible INT DEFAULT 0,"
-        "timestamp TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP,"
-        "transaction_merkle_root TEXT,"
-        "action_merkle_root TEXT,"
-        "producer TEXT REFERENCES accounts (name),"
-        "version INT NOT NULL DEFAULT 0,"
-        "new_producers JSONB DEFAULT NULL,"
-        "num_transactions INT DEFAULT 0,"
-        "confirmed INT,"
-        "UNIQUE (block_number)"
-    ");";
+    m_writer->exec("DELETE FROM blocks WHERE block_number BETWEEN :fi AND :la",
+            first_block,
+            last_block);
 }
 
-// blocks_table::add_block() defaults to MySQL syntax
-std::string blocks_table::add_block()
-{
-    if (backend == "postgresql") {
-        return "INSERT INTO blocks (id, block_number, prev_block_id, timestamp, transaction_merkle_root, action_merkle_root,"
-            "producer, version, confirmed, num_transactions) VALUES (:id, :in, :pb, to_timestamp(:ti), :tr, :ar, :pa, :ve, :pe, :nt) ON CONFLICT (block_number)"
-            " DO UPDATE SET prev_block_id=EXCLUDED.prev_block_id, timestamp=EXCLUDED.timestamp, transaction_merkle_root=EXCLUDED.transaction_merkle_root,"
-            "action_merkle_root=EXCLUDED.action_merkle_root, producer=EXCLUDED.producer, version=EXCLUDED.version, confirmed=EXCLUDED.confirmed, num_transactions=EXCLUDED.num_transactions";
-    }
-
-    return "REPLACE INTO blocks(id, block_number, prev_block_id, timestamp, transaction_merkle_root, action_merkle_root,"
-            "producer, version, confirmed, num_transactions) VALUES (:id, :in, :pb, FROM_UNIXTIME(:ti), :tr, :ar, :pa, :ve, :pe, :nt)";
-}
+SQL_DB_INSTANTIATE_DIALECTS(blocks_table)
 
 } // namespace
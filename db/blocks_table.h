@@ -11,25 +11,32 @@
 
 #include <eosio/chain/block_state.hpp>
 
+#include "account_set.h"
+#include "chain_strings.h"
+#include "index_options.h"
+#include "sql_dialect.h"
+#include "sql_writer.h"
+
 namespace eosio {
 
+template<typename Dialect>
 class blocks_table
 {
 public:
-    blocks_table(std::shared_ptr<soci::session> session);
+    blocks_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer, std::shared_ptr<name_cache> names, std::shared_ptr<account_set<Dialect>> accounts);
 
     void drop();
-    void create();
+    void create(const index_options& indexes = index_options());
     void add(chain::signed_block_ptr block);
+    // the rows of the blocks first_block - last_block
+    void remove(uint32_t first_block, uint32_t last_block);
 
 private:
     std::shared_ptr<soci::session> m_session;
-    std::string backend;
-
-    std::string add_block();
-
-    void create_mysql();
-    void create_postgresql();
+    std::shared_ptr<sql_writer> m_writer;
+    std::shared_ptr<name_cache> m_names;
+    std::shared_ptr<account_set<Dialect>> m_accounts;
+    const std::string m_insert = Dialect::blocks::insert();
 };
 
 } // namespace
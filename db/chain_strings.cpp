@@ -0,0 +1,76 @@
+#include "chain_strings.h"
+
+#include <cstring>
+
+namespace eosio {
+
+namespace {
+
+const char name_charmap[] = ".12345abcdefghijklmnopqrstuvwxyz";
+
+// "000102...ff": two characters per byte value
+struct hex_table {
+    char pairs[512];
+
+    hex_table()
+    {
+        const char digits[] = "0123456789abcdef";
+        for (int i = 0; i < 256; ++i) {
+            pairs[2 * i] = digits[i >> 4];
+            pairs[2 * i + 1] = digits[i & 0x0f];
+        }
+    }
+};
+
+const hex_table hex_pairs;
+
+} // namespace
+
+std::string name_string(uint64_t value)
+{
+    char buffer[13];
+
+    // the 13th character holds the lowest 4 bits, the 12 first ones 5 bits each
+    buffer[12] = name_charmap[value & 0x0f];
+    value >>= 4;
+    for (int i = 11; i >= 0; --i) {
+        buffer[i] = name_charmap[value & 0x1f];
+        value >>= 5;
+    }
+
+    size_t size = 13;
+    while (size > 0 && buffer[size - 1] == '.') {
+        --size;
+    }
+    return std::string(buffer, size);
+}
+
+void hex_string(const char* data, size_t size, std::string& out)
+{
+    out.resize(size * 2);
+    char* dest = &out[0];
+    for (size_t i = 0; i < size; ++i) {
+        std::memcpy(dest + 2 * i, hex_pairs.pairs + 2 * static_cast<uint8_t>(data[i]), 2);
+    }
+}
+
+const std::string& name_cache::get(chain::name name)
+{
+    auto it = m_names.find(name.value);
+    if (it == m_names.end()) {
+        it = m_names.emplace(name.value, name_string(name.value)).first;
+    }
+    return it->second;
+}
+
+void name_cache::clear()
+{
+    m_names.clear();
+}
+
+size_t name_cache::size() const
+{
+    return m_names.size();
+}
+
+} // namespace
@@ -0,0 +1,43 @@
+#ifndef CHAIN_STRINGS_H
+#define CHAIN_STRINGS_H
+
+#include <string>
+#include <unordered_map>
+
+#include <eosio/chain/name.hpp>
+
+namespace eosio {
+
+// Same text as chain::name::to_string(). At most 13 characters: the result stays
+// in the small string buffer, nothing is allocated.
+std::string name_string(uint64_t value);
+
+// Lowercase hex of size bytes, as fc::to_hex(), written into out (its capacity is reused).
+void hex_string(const char* data, size_t size, std::string& out);
+
+// Same text as str() of the fc hashes (sha256, ripemd160...)
+template<typename Checksum>
+std::string checksum_string(const Checksum& checksum)
+{
+    std::string out;
+    hex_string(checksum.data(), checksum.data_size(), out);
+    return out;
+}
+
+// The text of the names seen in the batch: contracts, actions and actors repeat
+// (eosio.token, transfer, active...). Cleared by the owner at the end of the batch.
+class name_cache
+{
+public:
+    const std::string& get(chain::name name);
+    void clear();
+
+    size_t size() const;
+
+private:
+    std::unordered_map<uint64_t, std::string> m_names;
+};
+
+} // namespace
+
+#endif // CHAIN_STRINGS_H
@@ -0,0 +1,177 @@
+#include "change_feed.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <fc/log/logger.hpp>
+
+#include "chain_strings.h"
+
+namespace eosio {
+
+namespace {
+const size_t max_notify_payload = 7900; // PostgreSQL refuses 8000 bytes and more
+
+void set_non_blocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+void append_names(const std::set<uint64_t>& names, std::string& out)
+{
+    bool first = true;
+    for (const auto name : names) {
+        out += first ? "\"" : ",\"";
+        out += name_string(name);
+        out += "\"";
+        first = false;
+    }
+}
+}
+
+change_feed::change_feed()
+{
+}
+
+change_feed::~change_feed()
+{
+    for (const auto client : m_clients) {
+        close(client);
+    }
+    if (m_listener >= 0) {
+        close(m_listener);
+        unlink(m_socket_path.c_str());
+    }
+}
+
+void change_feed::set_notify_channel(std::shared_ptr<soci::session> session, const std::string& channel)
+{
+    if (session->get_backend_name() != "postgresql") {
+        throw std::runtime_error("the notifications need the postgresql backend");
+    }
+    m_session = session;
+    m_channel = channel;
+}
+
+void change_feed::set_socket(const std::string& path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("socket path too long: " + path);
+    }
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    m_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listener < 0) {
+        throw std::runtime_error(std::string("socket: ") + std::strerror(errno));
+    }
+    unlink(path.c_str()); // left by a previous run
+    if (bind(m_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(m_listener, 16) < 0) {
+        const auto error = std::string(std::strerror(errno));
+        close(m_listener);
+        m_listener = -1;
+        throw std::runtime_error("cannot listen on " + path + ": " + error);
+    }
+    set_non_blocking(m_listener);
+    m_socket_path = path;
+}
+
+void change_feed::add_block(uint32_t block_num)
+{
+    if (m_first_block == 0 || block_num < m_first_block) {
+        m_first_block = block_num;
+    }
+    m_last_block = std::max(m_last_block, block_num);
+}
+
+void change_feed::add_action(const chain::action& action, chain::account_name receiver)
+{
+    m_contracts.insert(action.account.value);
+    m_accounts.insert(receiver.value);
+    for (const auto& auth : action.authorization) {
+        m_accounts.insert(auth.actor.value);
+    }
+}
+
+void change_feed::publish()
+{
+    if (m_first_block > 0) {
+        if (m_session) {
+            auto payload = this->message(true);
+            if (payload.size() > max_notify_payload) {
+                payload = this->message(false);
+            }
+            try {
+                *m_session << "SELECT pg_notify(:ch, :pa)", soci::use(m_channel), soci::use(payload);
+            } catch (const std::exception& ex) {
+                elog("${e}", ("e", ex.what()));
+            }
+        }
+        if (m_listener >= 0) {
+            this->accept_clients();
+            this->send_clients(this->message(true) + "\n");
+        }
+    }
+    this->discard();
+}
+
+void change_feed::discard()
+{
+    m_first_block = 0;
+    m_last_block = 0;
+    m_contracts.clear();
+    m_accounts.clear();
+}
+
+// private
+
+std::string change_feed::message(bool with_lists) const
+{
+    std::string out = "{\"first_block\":" + std::to_string(m_first_block) + ",\"last_block\":" + std::to_string(m_last_block);
+    if (with_lists) {
+        out += ",\"contracts\":[";
+        append_names(m_contracts, out);
+        out += "],\"accounts\":[";
+        append_names(m_accounts, out);
+        out += "]}";
+    } else {
+        out += ",\"truncated\":true}";
+    }
+    return out;
+}
+
+void change_feed::accept_clients()
+{
+    for (;;) {
+        const int client = accept(m_listener, nullptr, nullptr);
+        if (client < 0) {
+            return; // EAGAIN: none left
+        }
+        set_non_blocking(client);
+        m_clients.push_back(client);
+    }
+}
+
+void change_feed::send_clients(const std::string& line)
+{
+    for (auto it = m_clients.begin(); it != m_clients.end();) {
+        const auto sent = send(*it, line.data(), line.size(), MSG_NOSIGNAL);
+        if (sent != static_cast<ssize_t>(line.size())) { // gone, or its buffer is full: it reads too slowly
+            close(*it);
+            it = m_clients.erase(it);
+            continue;
+        }
+        ++it;
+    }
+}
+
+} // namespace
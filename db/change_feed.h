@@ -0,0 +1,61 @@
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <soci/soci.h>
+
+#include <eosio/chain/action.hpp>
+
+namespace eosio {
+
+// Tells the subscribers what a committed batch changed, so they read it instead
+// of polling the tables:
+//   {"first_block":10,"last_block":12,"contracts":["eosio.token"],"accounts":["alice","bob"]}
+// contracts: the accounts of the actions; accounts: their receivers and actors.
+//
+// The notification goes to a PostgreSQL channel (LISTEN <channel>) and/or to the
+// clients of a Unix socket, one JSON line each. A client that does not keep up
+// is disconnected. When the lists do not fit in a NOTIFY payload they are left
+// out and "truncated" is set: the block range is still there.
+class change_feed
+{
+public:
+    change_feed();
+    ~change_feed();
+
+    // PostgreSQL only
+    void set_notify_channel(std::shared_ptr<soci::session> session, const std::string& channel);
+    void set_socket(const std::string& path);
+
+    void add_block(uint32_t block_num);
+    void add_action(const chain::action& action, chain::account_name receiver);
+
+    // after the commit of the batch, then starts the next one
+    void publish();
+    // instead of publish() when the batch was not written in full
+    void discard();
+
+private:
+    std::string message(bool with_lists) const;
+    void accept_clients();
+    void send_clients(const std::string& line);
+
+    std::shared_ptr<soci::session> m_session;
+    std::string m_channel;
+    std::string m_socket_path;
+    int m_listener = -1;
+    std::vector<int> m_clients;
+
+    uint32_t m_first_block = 0;
+    uint32_t m_last_block = 0;
+    std::set<uint64_t> m_contracts;
+    std::set<uint64_t> m_accounts;
+};
+
+} // namespace
+
+#endif // CHANGE_FEED_H
@@ -1,91 +1,589 @@
 #include "database.h"
 
+#include "accounts_table.h"
+#include "block_tracer.h"
+#include "actions_table.h"
+#include "block_ranges_table.h"
+#include "blocks_table.h"
+#include "rollups_table.h"
+#include "sql_dialect.h"
+#include "transactions_table.h"
+
 namespace eosio
 {
 
-database::database(const std::string &uri, uint32_t block_num_start, const std::string &db_schema)
+class database::tables
+{
+public:
+    virtual ~tables() = default;
+
+    virtual void wipe(const std::string& schema, const std::string& system_account, const index_options& indexes) = 0;
+    virtual bool exist(const std::string& account) = 0;
+
+    virtual void add_block(const chain::block_state_ptr& block) = 0;
+    virtual void add_block(const chain::signed_block_ptr& block) = 0; // not counted by the rollups
+    virtual void add_transaction(uint32_t block_num, const chain::transaction& transaction, const chain::transaction_id_type& transaction_id) = 0;
+    virtual void add_action(uint32_t block_num, const chain::action& action, chain::account_name receiver, const chain::transaction_id_type& transaction_id,
+                            fc::time_point_sec transaction_time, int seq, int parent) = 0;
+    virtual void add_abi_version(uint32_t block_num, const chain::action& action) = 0;
+    virtual void flush() = 0;
+    // what is kept in memory until a later batch, at shutdown
+    virtual void close() = 0;
+    // the batch was committed, or not: what is cached of the tables follows
+    virtual void commit() = 0;
+    virtual void rollback() = 0;
+    // what another writer, sql_db_backfill, may have added
+    virtual void reload_abi_versions() = 0;
+    virtual void set_compressed_payloads(bool enabled) = 0;
+    virtual void set_deduplicated_payloads(size_t cache_size) = 0;
+    virtual void set_action_costs(std::chrono::seconds refresh) = 0;
+    virtual void set_token_contracts(const std::vector<chain::account_name>& contracts) = 0;
+    virtual action_handlers& handlers() = 0;
+
+    // the rows of the blocks first_block - last_block, before they are written again
+    virtual void remove_blocks(uint32_t first_block, uint32_t last_block) = 0;
+    virtual void add_block_range(uint32_t first_block, uint32_t last_block) = 0;
+    virtual void set_backfill_start(uint32_t first_block) = 0;
+    virtual uint32_t backfill_start() = 0;
+    virtual uint32_t contiguous_end(uint32_t first_block) = 0;
+};
+
+template<typename Dialect>
+class database::dialect_tables : public database::tables
+{
+public:
+    dialect_tables(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer, std::shared_ptr<name_cache> names):
+        m_session(session),
+        m_accounts(session),
+        m_account_set(std::make_shared<account_set<Dialect>>(session, writer)),
+        m_blocks(session, writer, names, m_account_set),
+        m_transactions(session, writer),
+        m_rollups(std::make_shared<rollups_table<Dialect>>(session, writer)),
+        m_actions(session, writer, names, m_account_set, m_rollups),
+        m_costs(std::make_shared<action_costs_table<Dialect>>(session, writer)),
+        m_block_ranges(session)
+    {
+        Dialect::open(*m_session);
+    }
+
+    void wipe(const std::string& schema, const std::string& system_account, const index_options& indexes) override
+    {
+        Dialect::disable_references(*m_session, schema);
+
+        m_block_ranges.drop();
+        m_rollups->drop();
+        m_costs->drop();
+        m_actions.drop();
+        m_transactions.drop();
+        m_blocks.drop();
+        m_accounts.drop();
+
+        Dialect::enable_references(*m_session);
+
+        m_accounts.create();
+        m_blocks.create(indexes);
+        m_transactions.create(indexes);
+        m_actions.create(indexes);
+        m_block_ranges.create();
+        m_rollups->create();
+        m_costs->create();
+
+        m_accounts.add(system_account);
+        m_account_set->reset();
+    }
+
+    bool exist(const std::string& account) override
+    {
+        return m_accounts.exist(account);
+    }
+
+    void add_block(const chain::block_state_ptr& block) override
+    {
+        m_blocks.add(block->block);
+        m_rollups->add_block(block);
+    }
+
+    void add_block(const chain::signed_block_ptr& block) override
+    {
+        m_blocks.add(block);
+    }
+
+    void add_transaction(uint32_t block_num, const chain::transaction& transaction, const chain::transaction_id_type& transaction_id) override
+    {
+        m_transactions.add(block_num, transaction, transaction_id);
+    }
+
+    void add_action(uint32_t block_num, const chain::action& action, chain::account_name receiver, const chain::transaction_id_type& transaction_id,
+                    fc::time_point_sec transaction_time, int seq, int parent) override
+    {
+        if (receiver == action.account) {
+            m_rollups->add_action(action.account, action.name);
+        }
+        m_actions.add(block_num, action, receiver, transaction_id, transaction_time, seq, parent);
+    }
+
+    void add_abi_version(uint32_t block_num, const chain::action& action) override
+    {
+        m_actions.add_abi_version(block_num, action);
+    }
+
+    void reload_abi_versions() override
+    {
+        m_actions.reload_abi_versions();
+    }
+
+    void flush() override
+    {
+        m_actions.flush();
+        m_rollups->flush();
+        m_costs->flush();
+    }
+
+    void close() override
+    {
+        m_costs->flush(true);
+    }
+
+    void commit() override
+    {
+        m_actions.commit();
+        m_rollups->commit();
+        m_account_set->commit();
+    }
+
+    void rollback() override
+    {
+        m_actions.rollback();
+        m_rollups->rollback();
+        m_account_set->rollback();
+    }
+
+    void set_compressed_payloads(bool enabled) override
+    {
+        m_actions.set_compressed_payloads(enabled);
+    }
+
+    void set_deduplicated_payloads(size_t cache_size) override
+    {
+        m_actions.set_deduplicated_payloads(cache_size);
+    }
+
+    void set_action_costs(std::chrono::seconds refresh) override
+    {
+        m_costs->set_refresh(refresh);
+        m_actions.set_costs(refresh.count() > 0 ? m_costs : nullptr);
+    }
+
+    void set_token_contracts(const std::vector<chain::account_name>& contracts) override
+    {
+        m_actions.set_token_contracts(contracts);
+    }
+
+    action_handlers& handlers() override
+    {
+        return m_actions.handlers();
+    }
+
+    void remove_blocks(uint32_t first_block, uint32_t last_block) override
+    {
+        m_actions.remove(first_block, last_block);
+        m_transactions.remove(first_block, last_block);
+        m_blocks.remove(first_block, last_block);
+    }
+
+    void add_block_range(uint32_t first_block, uint32_t last_block) override
+    {
+        m_block_ranges.add(first_block, last_block);
+    }
+
+    void set_backfill_start(uint32_t first_block) override
+    {
+        m_block_ranges.set_start(first_block);
+    }
+
+    uint32_t backfill_start() override
+    {
+        return m_block_ranges.start();
+    }
+
+    uint32_t contiguous_end(uint32_t first_block) override
+    {
+        return m_block_ranges.contiguous_end(first_block);
+    }
+
+private:
+    std::shared_ptr<soci::session> m_session;
+    accounts_table<Dialect> m_accounts;
+    std::shared_ptr<account_set<Dialect>> m_account_set;
+    blocks_table<Dialect> m_blocks;
+    transactions_table<Dialect> m_transactions;
+    std::shared_ptr<rollups_table<Dialect>> m_rollups;
+    actions_table<Dialect> m_actions;
+    std::shared_ptr<action_costs_table<Dialect>> m_costs;
+    block_ranges_table<Dialect> m_block_ranges;
+};
+
+database::database(const std::string &uri, uint32_t block_num_start, const std::string &db_schema, std::shared_ptr<trace_buffer> traces)
 {
     m_session = std::make_shared<soci::session>(uri);
-    m_accounts_table = std::make_unique<accounts_table>(m_session);
-    m_blocks_table = std::make_unique<blocks_table>(m_session);
-    m_transactions_table = std::make_unique<transactions_table>(m_session);
-    m_actions_table = std::make_unique<actions_table>(m_session);
+    m_writer = std::make_shared<sql_writer>(m_session, &m_arena);
+    m_names = std::make_shared<name_cache>();
+    with_dialect(m_session->get_backend_name(), [this](auto dialect) {
+        using dialect_type = decltype(dialect);
+        m_tables = std::make_unique<dialect_tables<dialect_type>>(m_session, m_writer, m_names);
+        m_transaction_per_batch = dialect_type::transaction_per_batch();
+    });
     m_block_num_start = block_num_start;
+    m_traces = traces;
     system_account = chain::name(chain::config::system_account_name).to_string();
     schema = db_schema;
-    backend = m_session->get_backend_name();
+}
+
+database::~database()
+{
+    try {
+        m_tables->close();
+        m_writer->sync();
+    } catch (const std::exception &ex) {
+        elog("${e}", ("e", ex.what()));
+    }
+}
+
+size_t
+database::estimated_size(const chain::block_state_ptr &block)
+{
+    // by the packed sizes the transactions already know, not packed again on the thread of the
+    // signal: each one is held packed in the block and about as much unpacked in its metadata
+    size_t size = sizeof(chain::block_state);
+    for (const auto& receipt : block->block->transactions) {
+        size += sizeof(receipt);
+        if (receipt.trx.contains<chain::packed_transaction>()) {
+            const auto& transaction = receipt.trx.get<chain::packed_transaction>();
+            size += 2 * (transaction.get_unprunable_size() + transaction.get_prunable_size());
+        }
+    }
+    return size;
 }
 
 void
 database::consume(const std::vector<chain::block_state_ptr> &blocks)
 {
+    // SQLite pays a sync on every commit: one transaction per batch.
+    // A failing statement only rolls back itself, what was written is still committed.
+    std::unique_ptr<soci::transaction> batch;
+    auto& tracer = block_tracer::instance();
+    for (const auto &block : blocks) {
+        tracer.dequeued(block->block_num);
+    }
+
     try {
+        if (m_transaction_per_batch) {
+            batch = std::make_unique<soci::transaction>(*m_session);
+        }
+
         for (const auto &block : blocks) {
+            auto traces = m_traces ? m_traces->take(block->id) : std::vector<transaction_actions>();
+
             if (m_block_num_start > 0 && block->block_num < m_block_num_start) {
                 continue;
             }
 
+            std::map<chain::transaction_id_type, const transaction_actions*, std::less<chain::transaction_id_type>,
+                    arena_allocator<std::pair<const chain::transaction_id_type, const transaction_actions*>>> executed(&m_arena);
+            for (const auto &trx : traces) {
+                executed[trx.id] = &trx;
+            }
 
-            m_blocks_table->add(block->block);
+            trace_scope block_span("block", block->block_num);
+            if (m_feed) {
+                m_feed->add_block(block->block_num);
+            }
+            {
+                trace_scope table_span("blocks", block->block_num);
+                m_tables->add_block(block);
+            }
             for (const auto &transaction : block->trxs) {
-                m_transactions_table->add(block->block_num, transaction->trx);
-                uint8_t seq = 0;
-                for (const auto &action : transaction->trx.actions) {
-                    try {
-                        m_actions_table->add(action, transaction->trx.id(), transaction->trx.expiration, seq);
-                        seq++;
-                    } catch (const fc::assert_exception &ex) { // malformed actions
-                        wlog("${e}", ("e", ex.what()));
-                        continue;
-                    }
-                }
+                auto it = executed.find(transaction->id);
+                this->add_transaction(block->block_num, transaction->trx, it != executed.end() ? it->second : nullptr);
             }
 
         }
+        trace_scope rollups_span("rollups", blocks.empty() ? 0 : blocks.back()->block_num);
+        m_tables->flush();
     } catch (const std::exception &ex) {
         elog("${e}", ("e", ex.what())); // prevent crash
+        if (m_feed) {
+            m_feed->discard(); // the rest of the batch is not written
+        }
     }
+
+    try {
+        trace_scope commit_span("commit", blocks.empty() ? 0 : blocks.back()->block_num);
+        m_writer->sync(); // reports the errors of the pipelined statements
+        if (batch) {
+            batch->commit();
+        }
+        m_tables->commit();
+        if (m_feed) {
+            m_feed->publish();
+        }
+    } catch (const std::exception &ex) {
+        elog("${e}", ("e", ex.what()));
+        m_tables->rollback();
+        if (m_feed) {
+            m_feed->discard();
+        }
+    }
+    m_arena.reset();
+    m_names->clear();
+
+    if (m_history && !blocks.empty()) {
+        m_history->invalidate(blocks.front()->block_num, blocks.back()->block_num);
+        if (m_history->invalidate_backfilled()) {
+            m_tables->reload_abi_versions(); // recorded by the backfill with its chunks
+        }
+    }
+    tracer.write_if_due();
+}
+
+void
+database::consume_block(const chain::signed_block_ptr &block)
+{
+    const auto block_num = block->block_num();
+
+    m_tables->add_block(block);
+    for (const auto &receipt : block->transactions) {
+        if (!receipt.trx.contains<chain::packed_transaction>()) {
+            continue; // deferred transactions are not carried by the block
+        }
+        this->add_transaction(block_num, receipt.trx.get<chain::packed_transaction>().get_transaction(), nullptr);
+    }
+}
+
+bool
+database::consume_range(uint32_t first_block, uint32_t last_block, const std::function<chain::signed_block_ptr(uint32_t)>& read_block)
+{
+    auto block_num = first_block;
+    bool complete = true;
+    m_tables->reload_abi_versions(); // the other workers may have written setabi
+    try {
+        soci::transaction chunk(*m_session);
+        m_tables->remove_blocks(first_block, last_block);
+        for (; block_num <= last_block; ++block_num) {
+            this->consume_block(read_block(block_num));
+        }
+        m_tables->flush();
+        m_writer->sync();
+        m_tables->add_block_range(first_block, last_block);
+        chunk.commit();
+        m_tables->commit();
+    } catch (const fc::exception& ex) {
+        elog("block ${n}: ${e}", ("n", block_num)("e", ex.to_detail_string()));
+        complete = false;
+    } catch (const std::exception& ex) {
+        elog("block ${n}: ${e}", ("n", block_num)("e", ex.what()));
+        complete = false;
+    }
+    if (!complete) {
+        m_tables->rollback();
+    }
+    m_arena.reset();
+    m_names->clear();
+
+    if (complete && m_history) {
+        m_history->invalidate(first_block, last_block);
+    }
+    return complete;
+}
+
+bool
+database::add_abi_versions(uint32_t first_block, uint32_t last_block, const std::function<chain::signed_block_ptr(uint32_t)>& read_block)
+{
+    auto block_num = first_block;
+    bool complete = true;
+    try {
+        soci::transaction chunk(*m_session);
+        for (; block_num <= last_block; ++block_num) {
+            const auto block = read_block(block_num);
+            for (const auto &receipt : block->transactions) {
+                if (!receipt.trx.contains<chain::packed_transaction>()) {
+                    continue;
+                }
+                for (const auto &action : receipt.trx.get<chain::packed_transaction>().get_transaction().actions) {
+                    if (action.account == chain::config::system_account_name && action.name == N(setabi)) {
+                        m_tables->add_abi_version(block_num, action);
+                    }
+                }
+            }
+        }
+        m_writer->sync();
+        chunk.commit();
+        m_tables->commit();
+    } catch (const fc::exception& ex) {
+        elog("block ${n}: ${e}", ("n", block_num)("e", ex.to_detail_string()));
+        complete = false;
+    } catch (const std::exception& ex) {
+        elog("block ${n}: ${e}", ("n", block_num)("e", ex.what()));
+        complete = false;
+    }
+    if (!complete) {
+        m_tables->rollback();
+    }
+    m_tables->reload_abi_versions(); // the versions found missing before
+    m_arena.reset();
+    return complete;
 }
 
 void
 database::wipe()
 {
-    this->set_drop_references_and_paths();
+    m_tables->wipe(schema, system_account, m_indexes);
+}
 
-    m_actions_table->drop();
-    m_transactions_table->drop();
-    m_blocks_table->drop();
-    m_accounts_table->drop();
+void
+database::add_block_range(uint32_t first_block, uint32_t last_block)
+{
+    m_tables->add_block_range(first_block, last_block);
+}
 
-    this->set_create_references_and_paths();
+void
+database::set_backfill_start(uint32_t first_block)
+{
+    m_tables->set_backfill_start(first_block);
+}
 
-    m_accounts_table->create();
-    m_blocks_table->create();
-    m_transactions_table->create();
-    m_actions_table->create();
+uint32_t
+database::backfill_end()
+{
+    try {
+        const auto start = m_tables->backfill_start();
+        const auto end = m_tables->contiguous_end(start);
+        return end >= start ? end : 0;
+    } catch (const std::exception &ex) { // tables created before the gap tracker existed
+        wlog("${e}", ("e", ex.what()));
+        return 0;
+    }
+}
 
-    m_accounts_table->add(system_account);
+void
+database::set_block_num_start(uint32_t block_num_start)
+{
+    m_block_num_start = block_num_start;
+}
+
+void
+database::set_history(std::shared_ptr<history_query> history)
+{
+    m_history = history;
+}
+
+void
+database::set_change_feed(std::shared_ptr<change_feed> feed)
+{
+    m_feed = feed;
+}
+
+std::shared_ptr<soci::session>
+database::session() const
+{
+    return m_session;
+}
+
+void
+database::set_compressed_payloads(bool enabled)
+{
+    m_tables->set_compressed_payloads(enabled);
+}
+
+void
+database::set_deduplicated_payloads(size_t cache_size)
+{
+    m_tables->set_deduplicated_payloads(cache_size);
+}
+
+void
+database::set_action_costs(std::chrono::seconds refresh)
+{
+    m_tables->set_action_costs(refresh);
+}
+
+void
+database::set_token_contracts(const std::vector<std::string>& contracts)
+{
+    std::vector<chain::account_name> names;
+    for (const auto& contract : contracts) {
+        names.push_back(contract == "*" ? chain::name(action_handlers::any_contract) : chain::name(contract));
+    }
+    m_tables->set_token_contracts(names);
+}
+
+action_handlers&
+database::handlers()
+{
+    return m_tables->handlers();
+}
+
+void
+database::set_indexes(const index_options& indexes)
+{
+    m_indexes = indexes;
+}
+
+void
+database::set_pipelined_writes(bool enabled)
+{
+    m_writer->set_pipeline(enabled);
 }
 
 bool
 database::is_started()
 {
-    return m_accounts_table->exist(system_account);
+    return m_tables->exist(system_account);
 }
 
 void
-database::set_drop_references_and_paths() {
-    if (backend == "postgresql") {
-        *m_session << "SET search_path TO " << schema << ",public;";
-    } else {
-        *m_session << "SET foreign_key_checks = 0;";
+database::add_transaction(uint32_t block_num, const chain::transaction &transaction, const transaction_actions *executed)
+{
+    const auto transaction_id = transaction.id(); // hashes the packed transaction: once
+    {
+        trace_scope span("transactions", block_num);
+        m_tables->add_transaction(block_num, transaction, transaction_id);
+    }
+
+    if (executed) {
+        this->add_executed_actions(block_num, *executed, transaction.expiration);
+        return;
+    }
+
+    int seq = 0;
+    for (const auto &action : transaction.actions) {
+        try {
+            if (m_feed) {
+                m_feed->add_action(action, action.account);
+            }
+            m_tables->add_action(block_num, action, action.account, transaction_id, transaction.expiration, seq, -1);
+            seq++;
+        } catch (const fc::assert_exception &ex) { // malformed actions
+            wlog("${e}", ("e", ex.what()));
+            continue;
+        }
     }
 }
 
 void
-database::set_create_references_and_paths() {
-    if (backend == "mysql") {
-        *m_session << "SET foreign_key_checks = 1;";
+database::add_executed_actions(uint32_t block_num, const transaction_actions &transaction, fc::time_point_sec transaction_time)
+{
+    int seq = 0;
+    for (const auto &action : transaction.actions) {
+        try {
+            if (m_feed) {
+                m_feed->add_action(action.act, action.receiver);
+            }
+            m_tables->add_action(block_num, action.act, action.receiver, transaction.id, transaction_time, seq, action.parent);
+        } catch (const fc::assert_exception &ex) { // malformed actions
+            wlog("${e}", ("e", ex.what()));
+        }
+        seq++; // keep seq aligned with the trace order, children reference their parent by it
     }
 }
 
@@ -3,6 +3,8 @@
 
 #include "consumer_core.h"
 
+#include <chrono>
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -12,35 +14,81 @@
 #include <eosio/chain/block_state.hpp>
 #include <eosio/chain/types.hpp>
 
-#include "accounts_table.h"
-#include "transactions_table.h"
-#include "blocks_table.h"
-#include "actions_table.h"
+#include "trace_buffer.h"
+#include "sql_writer.h"
+#include "action_handlers.h"
+#include "index_options.h"
+#include "chain_strings.h"
+#include "change_feed.h"
+#include "history_query.h"
 
 namespace eosio {
 
 class database : public consumer_core<chain::block_state_ptr>
 {
 public:
-    database(const std::string& uri, uint32_t block_num_start, const std::string& db_schema);
+    database(const std::string& uri, uint32_t block_num_start, const std::string& db_schema, std::shared_ptr<trace_buffer> traces = nullptr);
+    ~database();
+
+    // the memory held by a queued block, for the byte budget of the batches
+    static size_t estimated_size(const chain::block_state_ptr& block);
 
     void consume(const std::vector<chain::block_state_ptr>& blocks) override;
+    // the blocks first_block - last_block of a backfill, written in one transaction over what an earlier run
+    // left of them and recorded as a block range. false if any of them failed: nothing of them is written
+    bool consume_range(uint32_t first_block, uint32_t last_block, const std::function<chain::signed_block_ptr(uint32_t)>& read_block);
+
+    // only the ABI versions set by the setabi actions of the blocks first_block - last_block, before they are
+    // written: a backfill worker then decodes every action with the ABI of its block. false if any of them failed
+    bool add_abi_versions(uint32_t first_block, uint32_t last_block, const std::function<chain::signed_block_ptr(uint32_t)>& read_block);
 
+    void add_block_range(uint32_t first_block, uint32_t last_block);
+    // the first block of the backfilled history, kept if a lower one was set
+    void set_backfill_start(uint32_t first_block);
+    uint32_t backfill_end();
+    void set_block_num_start(uint32_t block_num_start);
+    void set_pipelined_writes(bool enabled);
+    void set_compressed_payloads(bool enabled);
+    // payloads stored once in the payloads table, the ids of the latest cache_size of them in memory. 0 disables it
+    void set_deduplicated_payloads(size_t cache_size);
+    // the ingest costs by contract action, added to action_costs every refresh. 0 disables them
+    void set_action_costs(std::chrono::seconds refresh);
+    // the contracts whose issue and transfer actions update the tokens table, "*" for any contract
+    void set_token_contracts(const std::vector<std::string>& contracts);
+    // what to do with the actions besides storing them, by contract and name
+    action_handlers& handlers();
+    // its cached pages are invalidated by the blocks written
+    void set_history(std::shared_ptr<history_query> history);
+    // notified of every committed batch
+    void set_change_feed(std::shared_ptr<change_feed> feed);
+    std::shared_ptr<soci::session> session() const;
+
+    // the indexes created by wipe()
+    void set_indexes(const index_options& indexes);
     void wipe();
     bool is_started();
 
 private:
-    void set_drop_references_and_paths();
-    void set_create_references_and_paths();
+    void consume_block(const chain::signed_block_ptr& block);
+    void add_transaction(uint32_t block_num, const chain::transaction& transaction, const transaction_actions* executed);
+    void add_executed_actions(uint32_t block_num, const transaction_actions& transaction, fc::time_point_sec transaction_time);
+
+    // the tables, with the statements of the backend's dialect
+    class tables;
+    template<typename Dialect> class dialect_tables;
 
     std::shared_ptr<soci::session> m_session;
-    std::unique_ptr<accounts_table> m_accounts_table;
-    std::unique_ptr<actions_table> m_actions_table;
-    std::unique_ptr<blocks_table> m_blocks_table;
-    std::unique_ptr<transactions_table> m_transactions_table;
+    batch_arena m_arena;
+    std::shared_ptr<sql_writer> m_writer;
+    std::shared_ptr<name_cache> m_names;
+    std::unique_ptr<tables> m_tables;
+    bool m_transaction_per_batch;
+    index_options m_indexes;
+    std::shared_ptr<trace_buffer> m_traces;
+    std::shared_ptr<history_query> m_history;
+    std::shared_ptr<change_feed> m_feed;
     std::string schema;
     std::string system_account;
-    std::string backend;
 
     uint32_t m_block_num_start;
 };
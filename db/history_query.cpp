@@ -0,0 +1,195 @@
+#include "history_query.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <fc/log/logger.hpp>
+
+namespace eosio {
+
+constexpr uint32_t history_query::max_limit;
+
+history_query::history_query(std::shared_ptr<soci::session> session, size_t cache_pages):
+    m_session(session),
+    m_cache_pages(cache_pages)
+{
+    backend = m_session->get_backend_name();
+    if (payload_compressor::supported()) {
+        m_decompressor = std::make_unique<payload_decompressor>(m_session);
+    }
+}
+
+history_page history_query::account_history(chain::account_name account, const fc::optional<history_cursor>& after, uint32_t limit)
+{
+    return this->query(kind::account, account, after, limit);
+}
+
+history_page history_query::contract_history(chain::account_name contract, const fc::optional<history_cursor>& after, uint32_t limit)
+{
+    return this->query(kind::contract, contract, after, limit);
+}
+
+// a page depends on the blocks between its cursor and its last action: the first
+// page on every new block, the last one on every older block
+void history_query::invalidate(uint32_t first_block, uint32_t last_block)
+{
+    std::lock_guard<std::mutex> lock(m_mux);
+    for (auto it = m_lru.begin(); it != m_lru.end();) {
+        if (it->lowest_block <= last_block && first_block <= it->highest_block) {
+            m_cache.erase(it->key);
+            it = m_lru.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool history_query::invalidate_backfilled()
+{
+    long long ranges = 0;
+    soci::indicator ind = soci::i_null;
+    std::lock_guard<std::mutex> lock(m_mux);
+    try {
+        *m_session << "SELECT COUNT(*) FROM block_ranges", soci::into(ranges, ind);
+    } catch (const std::exception& ex) { // tables created before the gap tracker existed
+        wlog("${e}", ("e", ex.what()));
+        return false;
+    }
+    if (ranges == m_backfilled_ranges) {
+        return false;
+    }
+    m_backfilled_ranges = ranges;
+    m_cache.clear();
+    m_lru.clear();
+    return true;
+}
+
+// private
+
+history_page history_query::query(kind what, chain::account_name name, const fc::optional<history_cursor>& after, uint32_t limit)
+{
+    limit = std::min(limit, max_limit); // before the key: one entry per page
+    std::string key = (what == kind::account ? "a:" : "c:") + name.to_string() + ':' + std::to_string(limit);
+    if (after) {
+        key += ':' + std::to_string(after->block_number) + ':' + std::to_string(after->id);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mux);
+    auto cached = m_cache.find(key);
+    if (cached != m_cache.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, cached->second);
+        return cached->second->page;
+    }
+
+    auto page = this->select(what, name, after, limit);
+    if (m_cache_pages == 0) {
+        return page;
+    }
+
+    const uint32_t highest = after ? after->block_number : std::numeric_limits<uint32_t>::max();
+    const uint32_t lowest = page.next ? page.next->block_number : 0;
+    m_lru.push_front(cached_page{key, lowest, highest, page});
+    m_cache[key] = m_lru.begin();
+    if (m_lru.size() > m_cache_pages) {
+        m_cache.erase(m_lru.back().key);
+        m_lru.pop_back();
+    }
+    return page;
+}
+
+history_page history_query::select(kind what, chain::account_name name, const fc::optional<history_cursor>& after, uint32_t limit)
+{
+    history_page page;
+    if (limit == 0) {
+        return page;
+    }
+
+    std::vector<long long> ids(limit), blocks(limit);
+    std::vector<int> seqs(limit);
+    std::vector<std::string> transaction_ids(limit), accounts(limit), receivers(limit), names(limit), data(limit), data_zstd(limit);
+    std::vector<soci::indicator> receivers_ind(limit), data_ind(limit), data_zstd_ind(limit);
+
+    const auto name_str = name.to_string();
+    const long long after_block = after ? after->block_number : 0;
+    const long long after_id = after ? static_cast<long long>(after->id) : 0;
+    const int limit_value = limit;
+
+    soci::statement statement(*m_session);
+    statement.exchange(soci::into(ids));
+    statement.exchange(soci::into(blocks));
+    statement.exchange(soci::into(transaction_ids));
+    statement.exchange(soci::into(seqs));
+    statement.exchange(soci::into(accounts));
+    statement.exchange(soci::into(receivers, receivers_ind));
+    statement.exchange(soci::into(names));
+    statement.exchange(soci::into(data, data_ind));
+    statement.exchange(soci::into(data_zstd, data_zstd_ind));
+    statement.exchange(soci::use(name_str, "name"));
+    if (after) {
+        statement.exchange(soci::use(after_block, "block"));
+        statement.exchange(soci::use(after_block, "block2"));
+        statement.exchange(soci::use(after_id, "id"));
+    }
+    statement.exchange(soci::use(limit_value, "limit"));
+    statement.alloc();
+    statement.prepare(this->select_sql(what, bool(after)));
+    statement.define_and_bind();
+    statement.execute(true);
+
+    page.actions.reserve(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        page.actions.push_back(history_action{
+                static_cast<uint64_t>(ids[i]),
+                static_cast<uint32_t>(blocks[i]),
+                std::move(transaction_ids[i]),
+                seqs[i],
+                std::move(accounts[i]),
+                receivers_ind[i] == soci::i_ok ? std::move(receivers[i]) : std::string(),
+                std::move(names[i]),
+                data_ind[i] == soci::i_ok ? std::move(data[i]) : std::string()});
+
+        if (data_ind[i] != soci::i_ok && data_zstd_ind[i] == soci::i_ok && m_decompressor) {
+            page.actions.back().data = m_decompressor->decompress(data_zstd[i]);
+        }
+    }
+
+    if (page.actions.size() == limit) {
+        page.next = history_cursor{page.actions.back().block_number, page.actions.back().id};
+    }
+    return page;
+}
+
+// history_query::select_sql() is the same for every backend: LIMIT and the expanded keyset
+// condition are understood by MySQL, PostgreSQL and SQLite, and use the (name, block_number, id) indices.
+// The payload is in payloads when written with sql_db-dedup-payloads.
+std::string history_query::select_sql(kind what, bool after)
+{
+    std::string sql;
+    if (what == kind::account) {
+        // the page of ids first, in the order of idx_actions_actor_history, then its actions. DISTINCT:
+        // an actor authorizing an action with two permissions has two rows of it
+        sql = "SELECT a.id, a.block_number, a.transaction_id, a.seq, a.account, a.receiver, a.name,"
+              " COALESCE(a.data, p.data), COALESCE(a.data_zstd, p.data_zstd)"
+              " FROM (SELECT DISTINCT aa.block_number, aa.action_id FROM actions_accounts aa"
+              " WHERE aa.actor = :name";
+        if (after) {
+            sql += " AND (aa.block_number < :block OR (aa.block_number = :block2 AND aa.action_id < :id))";
+        }
+        sql += " ORDER BY aa.block_number DESC, aa.action_id DESC LIMIT :limit) page"
+               " JOIN actions a ON a.id = page.action_id"
+               " LEFT JOIN payloads p ON p.id = a.payload_id"
+               " ORDER BY page.block_number DESC, page.action_id DESC";
+    } else {
+        sql = "SELECT a.id, a.block_number, a.transaction_id, a.seq, a.account, a.receiver, a.name,"
+              " COALESCE(a.data, p.data), COALESCE(a.data_zstd, p.data_zstd)"
+              " FROM actions a LEFT JOIN payloads p ON p.id = a.payload_id"
+              " WHERE a.account = :name";
+        if (after) {
+            sql += " AND (a.block_number < :block OR (a.block_number = :block2 AND a.id < :id))";
+        }
+        sql += " ORDER BY a.block_number DESC, a.id DESC LIMIT :limit";
+    }
+    return sql;
+}
+
+} // namespace
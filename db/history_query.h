@@ -0,0 +1,92 @@
+#ifndef HISTORY_QUERY_H
+#define HISTORY_QUERY_H
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <soci/soci.h>
+
+#include <fc/optional.hpp>
+
+#include <eosio/chain/types.hpp>
+
+#include "payload_codec.h"
+
+namespace eosio {
+
+struct history_action {
+    uint64_t id;
+    uint32_t block_number;
+    std::string transaction_id;
+    int seq;
+    std::string account;
+    std::string receiver;
+    std::string name;
+    std::string data; // decompressed from data_zstd if needed
+};
+
+// position of the last action of a page: the next page starts right after it
+struct history_cursor {
+    uint32_t block_number;
+    uint64_t id;
+};
+
+struct history_page {
+    std::vector<history_action> actions;
+    fc::optional<history_cursor> next; // not set on the last page
+};
+
+// Read side of the action history, newest first.
+//
+// Pages are selected by keyset on (block_number, id) instead of OFFSET: the cost
+// of a page does not depend on how deep it is in the history. Recent pages are
+// kept in a LRU cache; invalidate() drops the ones the newly written blocks can
+// change. Thread safe: the queries are serialized on the session.
+class history_query
+{
+public:
+    history_query(std::shared_ptr<soci::session> session, size_t cache_pages = 1024);
+
+    // the most actions of a page: a larger limit is lowered to it
+    static constexpr uint32_t max_limit = 1000;
+
+    // actions authorized by the account
+    history_page account_history(chain::account_name account, const fc::optional<history_cursor>& after, uint32_t limit);
+    // actions of the contract
+    history_page contract_history(chain::account_name contract, const fc::optional<history_cursor>& after, uint32_t limit);
+
+    void invalidate(uint32_t first_block, uint32_t last_block);
+    // drops every page when another process, sql_db_backfill, recorded block ranges since the last call. True if so
+    bool invalidate_backfilled();
+
+private:
+    enum class kind {account, contract};
+
+    struct cached_page {
+        std::string key;
+        uint32_t lowest_block; // the blocks the page depends on
+        uint32_t highest_block;
+        history_page page;
+    };
+
+    history_page query(kind what, chain::account_name name, const fc::optional<history_cursor>& after, uint32_t limit);
+    history_page select(kind what, chain::account_name name, const fc::optional<history_cursor>& after, uint32_t limit);
+    std::string select_sql(kind what, bool after);
+
+    std::shared_ptr<soci::session> m_session;
+    std::string backend;
+    std::unique_ptr<payload_decompressor> m_decompressor;
+    size_t m_cache_pages;
+    std::mutex m_mux;
+    std::list<cached_page> m_lru; // most recent first
+    std::unordered_map<std::string, std::list<cached_page>::iterator> m_cache;
+    long long m_backfilled_ranges = -1;
+};
+
+} // namespace
+
+#endif // HISTORY_QUERY_H
@@ -0,0 +1,54 @@
+#ifndef INDEX_OPTIONS_H
+#define INDEX_OPTIONS_H
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <eosio/chain/name.hpp>
+
+namespace eosio {
+
+// How the secondary indexes are built when the tables are created.
+//
+// btree: a B-tree on every column that is searched.
+// append_only: the tables only grow, in block order: BRIN on the monotonic columns
+// and hash on the transaction ids where the backend has them (PostgreSQL), and no
+// single column index that is the prefix of a history index.
+enum class index_profile { btree, append_only };
+
+struct index_options {
+    index_profile profile = index_profile::btree;
+    // contracts whose actions get an index of their own, by name and block (partial indexes)
+    std::vector<std::string> hot_contracts;
+
+    bool append_only() const { return profile == index_profile::append_only; }
+};
+
+inline index_profile parse_index_profile(const std::string& value)
+{
+    if (value == "btree") {
+        return index_profile::btree;
+    }
+    if (value == "append-only") {
+        return index_profile::append_only;
+    }
+    throw std::invalid_argument("unknown index profile " + value);
+}
+
+// the contract name as it is written in the index name, after checking it is a valid account name
+inline std::string index_suffix(const std::string& contract)
+{
+    if (contract.empty() || chain::name(contract).to_string() != contract) {
+        throw std::invalid_argument("invalid contract name " + contract);
+    }
+    std::string suffix = contract;
+    for (auto& c : suffix) {
+        c = c == '.' ? '_' : c;
+    }
+    return suffix;
+}
+
+} // namespace
+
+#endif // INDEX_OPTIONS_H
@@ -0,0 +1,172 @@
+#include "mysql_dialect.h"
+
+namespace eosio {
+
+void mysql_dialect::open(soci::session&)
+{
+}
+
+void mysql_dialect::disable_references(soci::session& session, const std::string&)
+{
+    session << "SET foreign_key_checks = 0;";
+}
+
+void mysql_dialect::enable_references(soci::session& session)
+{
+    session << "SET foreign_key_checks = 1;";
+}
+
+void mysql_dialect::accounts::create(soci::session& session)
+{
+    session <<  "CREATE TABLE accounts("
+        "name VARCHAR(12) PRIMARY KEY,"
+        "abi JSON DEFAULT NULL,"
+        "created_at DATETIME DEFAULT NOW(),"
+        "updated_at DATETIME DEFAULT NOW()) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+    
+    session << "CREATE TABLE accounts_keys("
+        "account VARCHAR(12),"
+        "public_key VARCHAR(53),"
+        "permission VARCHAR(12), FOREIGN KEY (account) REFERENCES accounts(name)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+}
+
+void mysql_dialect::blocks::create(soci::session& session)
+{
+    session << "CREATE TABLE blocks("
+        "id VARCHAR(64) PRIMARY KEY,"
+        "block_number INT NOT NULL AUTO_INCREMENT,"
+        "prev_block_id VARCHAR(64),"
+        "irreversible TINYINT(1) DEFAULT 0,"
+        "timestamp DATETIME DEFAULT NOW(),"
+        "transaction_merkle_root VARCHAR(64),"
+        "action_merkle_root VARCHAR(64),"
+        "producer VARCHAR(12),"
+        "version INT NOT NULL DEFAULT 0,"
+        "new_producers JSON DEFAULT NULL,"
+        "num_transactions INT DEFAULT 0,"
+        "confirmed INT, UNIQUE KEY block_number (block_number)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+}
+
+void mysql_dialect::transactions::create(soci::session& session)
+{
+    session << "CREATE TABLE transactions("
+        "id VARCHAR(64) PRIMARY KEY,"
+        "block_id INT NOT NULL,"
+        "ref_block_num INT NOT NULL,"
+        "ref_block_prefix INT,"
+        "expiration DATETIME DEFAULT NOW(),"
+        "pending TINYINT(1),"
+        "created_at DATETIME DEFAULT NOW(),"
+        "num_actions INT DEFAULT 0,"
+        "updated_at DATETIME DEFAULT NOW(), FOREIGN KEY (block_id) REFERENCES blocks(block_number) ON DELETE CASCADE) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+}
+
+void mysql_dialect::actions::create(soci::session& session)
+{
+    session << "CREATE TABLE actions("
+            "id INT NOT NULL AUTO_INCREMENT PRIMARY KEY,"
+            "block_number INT,"
+            "account VARCHAR(12),"
+            "receiver VARCHAR(12),"
+            "transaction_id VARCHAR(64),"
+            "seq SMALLINT,"
+            "parent SMALLINT DEFAULT NULL," // seq of the parent action in the same transaction
+            "name VARCHAR(12),"
+            "created_at DATETIME DEFAULT NOW(),"
+            "data JSON,"
+            "data_zstd LONGBLOB," // instead of data with sql_db-compress-payloads
+            "payload_id BIGINT DEFAULT NULL," // instead of both with sql_db-dedup-payloads
+            "FOREIGN KEY (transaction_id) REFERENCES transactions(id) ON DELETE CASCADE) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+
+    session << "CREATE TABLE payloads("
+            "id BIGINT PRIMARY KEY,"
+            "data JSON,"
+            "data_zstd LONGBLOB) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+
+    session << "CREATE TABLE actions_accounts("
+            "block_number INT,"
+            "actor VARCHAR(12),"
+            "permission VARCHAR(12),"
+            "action_id INT NOT NULL, FOREIGN KEY (action_id) REFERENCES actions(id) ON DELETE CASCADE) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+
+    session << "CREATE TABLE tokens("
+            "account VARCHAR(13),"
+            "symbol VARCHAR(10),"
+            "amount DOUBLE(64,4)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;"; // TODO: other tokens could have diff format.
+
+    session << "CREATE TABLE stakes("
+            "account VARCHAR(13) PRIMARY KEY,"
+            "cpu REAL(14,4),"
+            "net REAL(14,4)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+
+    session << "CREATE TABLE votes("
+            "account VARCHAR(13) PRIMARY KEY,"
+            "votes JSON"
+            ", UNIQUE KEY account (account)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+}
+
+void mysql_dialect::block_ranges::create(soci::session& session)
+{
+    session << "CREATE TABLE block_ranges("
+        "first_block BIGINT NOT NULL,"
+        "last_block BIGINT NOT NULL,"
+        "created_at DATETIME DEFAULT NOW()) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+
+    session << "CREATE TABLE backfill_start("
+        "first_block BIGINT NOT NULL) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+}
+
+void mysql_dialect::rollups::create(soci::session& session)
+{
+    session << "CREATE TABLE rollup_blocks("
+            "block_number INT PRIMARY KEY,"
+            "transactions INT,"
+            "actions INT) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+
+    session << "CREATE TABLE rollup_minutes("
+            "minute DATETIME PRIMARY KEY,"
+            "blocks INT,"
+            "transactions BIGINT,"
+            "actions BIGINT) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+
+    session << "CREATE TABLE rollup_contracts("
+            "account VARCHAR(12),"
+            "name VARCHAR(12),"
+            "actions BIGINT,"
+            "PRIMARY KEY (account, name)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+
+    session << "CREATE TABLE rollup_transfers("
+            "minute DATETIME,"
+            "contract VARCHAR(12),"
+            "symbol VARCHAR(10),"
+            "transfers BIGINT,"
+            "volume DOUBLE,"
+            "PRIMARY KEY (minute, contract, symbol)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+}
+
+void mysql_dialect::abi_history::create(soci::session& session)
+{
+    session << "CREATE TABLE abi_history("
+            "account VARCHAR(12),"
+            "block_number INT,"
+            "abi_hash BIGINT,"
+            "abi JSON,"
+            "PRIMARY KEY (account, block_number)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+}
+
+void mysql_dialect::action_costs::create(soci::session& session)
+{
+    session << "CREATE TABLE action_costs("
+            "account VARCHAR(12),"
+            "name VARCHAR(12),"
+            "actions BIGINT,"
+            "skipped BIGINT,"
+            "bytes BIGINT,"
+            "abi_us BIGINT,"
+            "decode_us BIGINT,"
+            "sql_us BIGINT,"
+            "total_us BIGINT,"
+            "PRIMARY KEY (account, name)) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+}
+
+} // namespace
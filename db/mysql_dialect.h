@@ -0,0 +1,165 @@
+#ifndef MYSQL_DIALECT_H
+#define MYSQL_DIALECT_H
+
+#include <string>
+
+#include <soci/soci.h>
+
+namespace eosio {
+
+struct mysql_dialect
+{
+    static constexpr const char* name() { return "mysql"; }
+    static constexpr const char* cascade() { return " CASCADE"; }
+    static constexpr bool transaction_per_batch() { return false; }
+    // the index method of a column that grows with the rows, and of one only searched by equality
+    static constexpr const char* monotonic_index() { return ""; }
+    static constexpr const char* equality_index() { return ""; }
+    static constexpr bool partial_indexes() { return false; }
+
+    static void open(soci::session& session);
+    static void disable_references(soci::session& session, const std::string& schema);
+    static void enable_references(soci::session& session);
+
+    struct accounts {
+        static void create(soci::session& session);
+
+        // nothing when it is there already
+        static constexpr const char* insert()
+        {
+            return "INSERT IGNORE INTO accounts (name) VALUES (:na)";
+        }
+    };
+
+    struct blocks {
+        static void create(soci::session& session);
+
+        static constexpr const char* insert()
+        {
+            return "REPLACE INTO blocks(id, block_number, prev_block_id, timestamp, transaction_merkle_root, action_merkle_root,"
+                "producer, version, confirmed, num_transactions) VALUES (:id, :in, :pb, FROM_UNIXTIME(:ti), :tr, :ar, :pa, :ve, :pe, :nt)";
+        }
+    };
+
+    struct transactions {
+        static void create(soci::session& session);
+
+        static constexpr const char* insert()
+        {
+            return "INSERT INTO transactions(id, block_id, ref_block_num, ref_block_prefix,"
+                "expiration, pending, created_at, updated_at, num_actions) VALUES (:id, :bi, :rbi, :rb, FROM_UNIXTIME(:ex), :pe, FROM_UNIXTIME(:ca), FROM_UNIXTIME(:ua), :na)";
+        }
+    };
+
+    struct actions {
+        static void create(soci::session& session);
+
+        static constexpr const char* insert()
+        {
+            return "INSERT INTO actions (block_number, account, receiver, seq, parent, created_at, name, data, transaction_id) VALUES (:bn, :ac, :re, :se, :pa, FROM_UNIXTIME(:ca), :na, :da, :ti)";
+        }
+
+        // the payload is bound as hex
+        static constexpr const char* insert_compressed()
+        {
+            return "INSERT INTO actions (block_number, account, receiver, seq, parent, created_at, name, data_zstd, transaction_id) VALUES (:bn, :ac, :re, :se, :pa, FROM_UNIXTIME(:ca), :na, UNHEX(:dz), :ti)";
+        }
+
+        // the payload in payloads (sql_db-dedup-payloads)
+        static constexpr const char* insert_deduplicated()
+        {
+            return "INSERT INTO actions (block_number, account, receiver, seq, parent, created_at, name, payload_id, transaction_id) VALUES (:bn, :ac, :re, :se, :pa, FROM_UNIXTIME(:ca), :na, :pi, :ti)";
+        }
+
+        // nothing when it is there already: the id is the hash of the payload
+        static constexpr const char* insert_payload()
+        {
+            return "INSERT IGNORE INTO payloads (id, data) VALUES (:id, :da)";
+        }
+
+        static constexpr const char* insert_payload_compressed()
+        {
+            return "INSERT IGNORE INTO payloads (id, data_zstd) VALUES (:id, UNHEX(:dz))";
+        }
+
+        // written in bulk after the actions: each row finds its action by transaction and seq
+        static constexpr const char* insert_account()
+        {
+            return "INSERT INTO actions_accounts (block_number, action_id, actor, permission)"
+                " VALUES (:bn, (SELECT MAX(id) FROM actions WHERE transaction_id = :ti AND seq = :se AND block_number = :bn2), :ac, :pe)";
+        }
+
+        // a no-op when the row was already updated
+        static constexpr const char* insert_tokens()
+        {
+            return "INSERT INTO tokens (account, amount, symbol) SELECT :ac, :am, :sy FROM DUAL"
+                " WHERE NOT EXISTS (SELECT 1 FROM tokens WHERE account = :ac2 AND symbol = :sy2)";
+        }
+
+        static constexpr const char* upsert_stakes()
+        {
+            return "REPLACE INTO stakes(account, cpu, net) VALUES (:ac, :cp, :ne)";
+        }
+
+        static constexpr const char* upsert_votes()
+        {
+            return "REPLACE INTO votes(account, votes) VALUES (:ac, :vo)";
+        }
+    };
+
+    struct block_ranges {
+        static void create(soci::session& session);
+    };
+
+    struct rollups {
+        static void create(soci::session& session);
+
+        static constexpr const char* upsert_block()
+        {
+            return "REPLACE INTO rollup_blocks (block_number, transactions, actions) VALUES (:bn, :tr, :ac)";
+        }
+
+        static constexpr const char* add_minute()
+        {
+            return "INSERT INTO rollup_minutes (minute, blocks, transactions, actions) VALUES (FROM_UNIXTIME(:mi), :bl, :tr, :ac)"
+                " ON DUPLICATE KEY UPDATE blocks = blocks + VALUES(blocks), transactions = transactions + VALUES(transactions), actions = actions + VALUES(actions)";
+        }
+
+        static constexpr const char* add_contract()
+        {
+            return "INSERT INTO rollup_contracts (account, name, actions) VALUES (:ac, :na, :co)"
+                " ON DUPLICATE KEY UPDATE actions = actions + VALUES(actions)";
+        }
+
+        static constexpr const char* add_transfers()
+        {
+            return "INSERT INTO rollup_transfers (minute, contract, symbol, transfers, volume) VALUES (FROM_UNIXTIME(:mi), :co, :sy, :tr, :vo)"
+                " ON DUPLICATE KEY UPDATE transfers = transfers + VALUES(transfers), volume = volume + VALUES(volume)";
+        }
+    };
+
+    struct abi_history {
+        static void create(soci::session& session);
+
+        static constexpr const char* upsert()
+        {
+            return "REPLACE INTO abi_history (account, block_number, abi_hash, abi) VALUES (:ac, :bn, :ha, :ab)";
+        }
+    };
+
+    struct action_costs {
+        static void create(soci::session& session);
+
+        // the costs of a refresh are added
+        static constexpr const char* add()
+        {
+            return "INSERT INTO action_costs (account, name, actions, skipped, bytes, abi_us, decode_us, sql_us, total_us) VALUES (:ac, :na, :co, :sk, :by, :ab, :de, :sq, :to)"
+                " ON DUPLICATE KEY UPDATE actions = actions + VALUES(actions), skipped = skipped + VALUES(skipped), bytes = bytes + VALUES(bytes), abi_us = abi_us + VALUES(abi_us),"
+                " decode_us = decode_us + VALUES(decode_us), sql_us = sql_us + VALUES(sql_us), total_us = total_us + VALUES(total_us)";
+        }
+    };
+};
+
+} // namespace
+
+#endif // MYSQL_DIALECT_H
@@ -0,0 +1,87 @@
+#ifndef NATIVE_ACTIONS_H
+#define NATIVE_ACTIONS_H
+
+#include <string>
+#include <vector>
+
+#include <fc/reflect/reflect.hpp>
+
+#include <eosio/chain/asset.hpp>
+#include <eosio/chain/name.hpp>
+
+#include "abi_json_writer.h"
+
+namespace eosio {
+
+// The payloads of the hot actions, unpacked with fc::raw when the contract's ABI
+// describes them with the layout they were compiled for (abi_json_writer::layout()).
+// from_decoded() reads the same fields from the decoded JSON, for the other ABIs.
+
+struct token_issue {
+    chain::account_name to;
+    chain::asset quantity;
+    std::string memo;
+
+    static chain::action_name name() { return N(issue); }
+    static const char* layout() { return "to:name,quantity:asset,memo:string"; }
+    static std::vector<std::string> fields() { return {"to", "quantity"}; }
+    static token_issue from_decoded(const decoded_action& decoded)
+    {
+        return {decoded.as<chain::name>("to"), decoded.as<chain::asset>("quantity"), std::string()};
+    }
+};
+
+struct token_transfer {
+    chain::account_name from;
+    chain::account_name to;
+    chain::asset quantity;
+    std::string memo;
+
+    static chain::action_name name() { return N(transfer); }
+    static const char* layout() { return "from:name,to:name,quantity:asset,memo:string"; }
+    static std::vector<std::string> fields() { return {"from", "to", "quantity"}; }
+    static token_transfer from_decoded(const decoded_action& decoded)
+    {
+        return {decoded.as<chain::name>("from"), decoded.as<chain::name>("to"), decoded.as<chain::asset>("quantity"), std::string()};
+    }
+};
+
+struct system_delegatebw {
+    chain::account_name from;
+    chain::account_name receiver;
+    chain::asset stake_net_quantity;
+    chain::asset stake_cpu_quantity;
+    bool transfer;
+
+    static chain::action_name name() { return N(delegatebw); }
+    static const char* layout() { return "from:name,receiver:name,stake_net_quantity:asset,stake_cpu_quantity:asset,transfer:bool"; }
+    static std::vector<std::string> fields() { return {"receiver", "stake_cpu_quantity", "stake_net_quantity"}; }
+    static system_delegatebw from_decoded(const decoded_action& decoded)
+    {
+        return {chain::account_name(), decoded.as<chain::name>("receiver"),
+                decoded.as<chain::asset>("stake_net_quantity"), decoded.as<chain::asset>("stake_cpu_quantity"), false};
+    }
+};
+
+struct system_voteproducer {
+    chain::account_name voter;
+    chain::account_name proxy;
+    std::vector<chain::account_name> producers;
+
+    static chain::action_name name() { return N(voteproducer); }
+    static const char* layout() { return "voter:name,proxy:name,producers:name[]"; }
+    static std::vector<std::string> fields() { return {"voter", "producers"}; }
+    static system_voteproducer from_decoded(const decoded_action& decoded)
+    {
+        return {decoded.as<chain::name>("voter"), chain::account_name(), decoded.as<std::vector<chain::account_name>>("producers")};
+    }
+};
+
+} // namespace
+
+FC_REFLECT(eosio::token_issue, (to)(quantity)(memo))
+FC_REFLECT(eosio::token_transfer, (from)(to)(quantity)(memo))
+FC_REFLECT(eosio::system_delegatebw, (from)(receiver)(stake_net_quantity)(stake_cpu_quantity)(transfer))
+FC_REFLECT(eosio::system_voteproducer, (voter)(proxy)(producers))
+
+#endif // NATIVE_ACTIONS_H
@@ -0,0 +1,350 @@
+#include "parquet_sink.h"
+
+#include <ctime>
+#include <stdexcept>
+
+#include <boost/filesystem.hpp>
+#include <fc/log/logger.hpp>
+
+#ifdef SQL_DB_HAVE_PARQUET
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/exception.h>
+#endif
+
+#include "chain_strings.h"
+
+namespace eosio {
+
+#ifdef SQL_DB_HAVE_PARQUET
+
+namespace {
+
+using name_builder = arrow::Dictionary32Builder<arrow::StringType>;
+
+void check(const arrow::Status& status)
+{
+    if (!status.ok()) {
+        throw std::runtime_error(status.ToString());
+    }
+}
+
+std::shared_ptr<arrow::DataType> name_type()
+{
+    return arrow::dictionary(arrow::int32(), arrow::utf8());
+}
+
+std::shared_ptr<arrow::DataType> seconds_type()
+{
+    return arrow::timestamp(arrow::TimeUnit::SECOND);
+}
+
+// The rows of one table: appended column by column, written as a row group by flush().
+// truncate() drops the columns past a row that was not appended in full.
+class table_writer
+{
+public:
+    table_writer(std::string name, std::vector<std::shared_ptr<arrow::Field>> fields):
+        m_name(std::move(name)),
+        m_schema(arrow::schema(std::move(fields)))
+    {
+        for (const auto& field : m_schema->fields()) {
+            std::unique_ptr<arrow::ArrayBuilder> builder;
+            check(arrow::MakeBuilderExactIndex(arrow::default_memory_pool(), field->type(), &builder));
+            m_builders.push_back(std::move(builder));
+        }
+    }
+
+    template<typename Builder>
+    Builder& column(int i) { return static_cast<Builder&>(*m_builders[i]); }
+
+    void row_added() { ++m_rows; }
+    size_t rows() const { return m_rows; }
+
+    void open(const std::string& dir, const std::string& date, uint32_t first_block)
+    {
+        const auto partition = boost::filesystem::path(dir) / m_name / ("date=" + date);
+        boost::filesystem::create_directories(partition);
+        const auto path = (partition / ("part-" + std::to_string(first_block) + ".parquet")).string();
+
+        std::shared_ptr<arrow::io::FileOutputStream> file;
+        PARQUET_ASSIGN_OR_THROW(file, arrow::io::FileOutputStream::Open(path));
+        const auto properties = parquet::WriterProperties::Builder().compression(parquet::Compression::ZSTD)->build();
+        const auto arrow_properties = parquet::ArrowWriterProperties::Builder().store_schema()->build();
+        PARQUET_ASSIGN_OR_THROW(m_writer, parquet::arrow::FileWriter::Open(*m_schema, arrow::default_memory_pool(), file, properties, arrow_properties));
+    }
+
+    // the builders cannot drop their last values: the rows kept are finished into a chunk
+    void truncate(size_t rows)
+    {
+        this->finish_chunk(rows);
+        m_rows = rows;
+    }
+
+    void flush()
+    {
+        if (m_rows == 0 || !m_writer) {
+            return;
+        }
+        const auto rows = m_rows;
+        this->finish_chunk(rows);
+        std::vector<std::shared_ptr<arrow::ChunkedArray>> columns;
+        for (size_t i = 0; i < m_builders.size(); ++i) {
+            arrow::ArrayVector chunks;
+            for (const auto& chunk : m_chunks) {
+                chunks.push_back(chunk[i]);
+            }
+            columns.push_back(std::make_shared<arrow::ChunkedArray>(chunks, m_schema->field(i)->type()));
+        }
+        m_chunks.clear();
+        m_chunked_rows = 0;
+        m_rows = 0;
+        check(m_writer->WriteTable(*arrow::Table::Make(m_schema, columns, rows), rows));
+    }
+
+    void close()
+    {
+        this->flush();
+        if (m_writer) {
+            check(m_writer->Close());
+            m_writer.reset();
+        }
+    }
+
+private:
+    void finish_chunk(size_t rows)
+    {
+        std::vector<std::shared_ptr<arrow::Array>> chunk;
+        for (auto& builder : m_builders) {
+            std::shared_ptr<arrow::Array> column;
+            check(builder->Finish(&column));
+            chunk.push_back(column->Slice(0, rows - m_chunked_rows));
+        }
+        m_chunks.push_back(std::move(chunk));
+        m_chunked_rows = rows;
+    }
+
+    std::string m_name;
+    std::shared_ptr<arrow::Schema> m_schema;
+    std::vector<std::unique_ptr<arrow::ArrayBuilder>> m_builders;
+    std::vector<std::vector<std::shared_ptr<arrow::Array>>> m_chunks; // of the rows before a truncate()
+    std::unique_ptr<parquet::arrow::FileWriter> m_writer;
+    size_t m_rows = 0;
+    size_t m_chunked_rows = 0;
+};
+
+std::string day_of(uint32_t seconds)
+{
+    const std::time_t time = seconds;
+    std::tm tm;
+    gmtime_r(&time, &tm);
+    char buffer[16];
+    std::strftime(buffer, sizeof(buffer), "%Y-%m-%d", &tm);
+    return buffer;
+}
+
+} // namespace
+
+struct parquet_sink::tables {
+    table_writer blocks{"blocks", {
+            arrow::field("block_number", arrow::uint32()),
+            arrow::field("id", arrow::utf8()),
+            arrow::field("timestamp", seconds_type()),
+            arrow::field("producer", name_type()),
+            arrow::field("schedule_version", arrow::uint32()),
+            arrow::field("num_transactions", arrow::int32())}};
+    table_writer transactions{"transactions", {
+            arrow::field("block_number", arrow::uint32()),
+            arrow::field("id", arrow::utf8()),
+            arrow::field("timestamp", seconds_type()),
+            arrow::field("expiration", seconds_type()),
+            arrow::field("num_actions", arrow::int32())}};
+    table_writer actions{"actions", {
+            arrow::field("block_number", arrow::uint32()),
+            arrow::field("timestamp", seconds_type()),
+            arrow::field("transaction_id", arrow::utf8()),
+            arrow::field("seq", arrow::int32()),
+            arrow::field("account", name_type()),
+            arrow::field("name", name_type()),
+            arrow::field("actor", name_type()), // first authorization
+            arrow::field("permission", name_type()),
+            arrow::field("data", arrow::binary())}};
+
+    // the rows of each table
+    struct mark {
+        size_t blocks;
+        size_t transactions;
+        size_t actions;
+    };
+
+    mark rows() const
+    {
+        return mark{blocks.rows(), transactions.rows(), actions.rows()};
+    }
+
+    void truncate(const mark& rows)
+    {
+        blocks.truncate(rows.blocks);
+        transactions.truncate(rows.transactions);
+        actions.truncate(rows.actions);
+    }
+
+    void flush()
+    {
+        blocks.flush();
+        transactions.flush();
+        actions.flush();
+    }
+
+    void close()
+    {
+        blocks.close();
+        transactions.close();
+        actions.close();
+    }
+};
+
+#else
+
+struct parquet_sink::tables {};
+
+#endif // SQL_DB_HAVE_PARQUET
+
+parquet_sink::parquet_sink(const std::string& dir, uint32_t max_blocks_per_file, size_t row_group_rows):
+    m_dir(dir),
+    m_max_blocks_per_file(max_blocks_per_file),
+    m_row_group_rows(row_group_rows)
+{
+    if (!supported()) {
+        throw std::runtime_error("the Parquet export needs the plugin built with Arrow and Parquet");
+    }
+}
+
+parquet_sink::~parquet_sink()
+{
+    try {
+        this->close();
+    } catch (const std::exception& ex) {
+        elog("${e}", ("e", ex.what()));
+    }
+}
+
+bool parquet_sink::supported()
+{
+#ifdef SQL_DB_HAVE_PARQUET
+    return true;
+#else
+    return false;
+#endif
+}
+
+void parquet_sink::consume(const std::vector<chain::block_state_ptr>& blocks)
+{
+#ifdef SQL_DB_HAVE_PARQUET
+    for (const auto& block_state : blocks) {
+        fc::optional<tables::mark> rows;
+        try {
+            const auto& block = block_state->block;
+            const auto timestamp = block->timestamp.operator fc::time_point().sec_since_epoch();
+            const auto date = day_of(timestamp);
+            if (!m_tables || date != m_date || m_blocks >= m_max_blocks_per_file) {
+                this->roll(block_state, date);
+            }
+            rows = m_tables->rows();
+
+            auto& blocks_table = m_tables->blocks;
+            check(blocks_table.column<arrow::UInt32Builder>(0).Append(block_state->block_num));
+            check(blocks_table.column<arrow::StringBuilder>(1).Append(checksum_string(block_state->id)));
+            check(blocks_table.column<arrow::TimestampBuilder>(2).Append(timestamp));
+            check(blocks_table.column<name_builder>(3).Append(name_string(block->producer.value)));
+            check(blocks_table.column<arrow::UInt32Builder>(4).Append(block->schedule_version));
+            check(blocks_table.column<arrow::Int32Builder>(5).Append(static_cast<int32_t>(block->transactions.size())));
+            blocks_table.row_added();
+
+            for (const auto& metadata : block_state->trxs) {
+                const auto& transaction = metadata->trx;
+                const auto transaction_id = checksum_string(metadata->id);
+
+                auto& transactions_table = m_tables->transactions;
+                check(transactions_table.column<arrow::UInt32Builder>(0).Append(block_state->block_num));
+                check(transactions_table.column<arrow::StringBuilder>(1).Append(transaction_id));
+                check(transactions_table.column<arrow::TimestampBuilder>(2).Append(timestamp));
+                check(transactions_table.column<arrow::TimestampBuilder>(3).Append(transaction.expiration.sec_since_epoch()));
+                check(transactions_table.column<arrow::Int32Builder>(4).Append(static_cast<int32_t>(transaction.total_actions())));
+                transactions_table.row_added();
+
+                int32_t seq = 0;
+                for (const auto& action : transaction.actions) {
+                    auto& actions_table = m_tables->actions;
+                    check(actions_table.column<arrow::UInt32Builder>(0).Append(block_state->block_num));
+                    check(actions_table.column<arrow::TimestampBuilder>(1).Append(timestamp));
+                    check(actions_table.column<arrow::StringBuilder>(2).Append(transaction_id));
+                    check(actions_table.column<arrow::Int32Builder>(3).Append(seq++));
+                    check(actions_table.column<name_builder>(4).Append(name_string(action.account.value)));
+                    check(actions_table.column<name_builder>(5).Append(name_string(action.name.value)));
+                    if (action.authorization.empty()) {
+                        check(actions_table.column<name_builder>(6).AppendNull());
+                        check(actions_table.column<name_builder>(7).AppendNull());
+                    } else {
+                        check(actions_table.column<name_builder>(6).Append(name_string(action.authorization.front().actor.value)));
+                        check(actions_table.column<name_builder>(7).Append(name_string(action.authorization.front().permission.value)));
+                    }
+                    check(actions_table.column<arrow::BinaryBuilder>(8).Append(reinterpret_cast<const uint8_t*>(action.data.data()),
+                                                                               static_cast<int32_t>(action.data.size())));
+                    actions_table.row_added();
+                }
+            }
+            ++m_blocks;
+            rows.reset(); // in full
+
+            if (m_tables->actions.rows() >= m_row_group_rows || m_tables->transactions.rows() >= m_row_group_rows) {
+                m_tables->flush();
+            }
+        } catch (const std::exception& ex) {
+            elog("block ${n} not exported: ${e}", ("n", block_state->block_num)("e", ex.what())); // prevent crash
+            try {
+                if (m_tables && rows) {
+                    m_tables->truncate(*rows); // the columns keep the same length
+                }
+            } catch (const std::exception& ex) {
+                elog("${e}", ("e", ex.what()));
+                m_tables.reset();
+            }
+        }
+    }
+#endif
+}
+
+void parquet_sink::close()
+{
+#ifdef SQL_DB_HAVE_PARQUET
+    if (m_tables) {
+        auto tables = std::move(m_tables); // not reused if closing them fails
+        tables->close();
+    }
+#endif
+}
+
+// private
+
+void parquet_sink::roll(const chain::block_state_ptr& block, const std::string& date)
+{
+#ifdef SQL_DB_HAVE_PARQUET
+    try {
+        this->close();
+    } catch (const std::exception& ex) { // the rows not written yet are lost, not the next files
+        elog("${e}", ("e", ex.what()));
+    }
+    auto tables = std::make_unique<parquet_sink::tables>();
+    tables->blocks.open(m_dir, date, block->block_num);
+    tables->transactions.open(m_dir, date, block->block_num);
+    tables->actions.open(m_dir, date, block->block_num);
+    m_tables = std::move(tables); // only once all three are open: a failed roll is tried again on the next block
+    m_date = date;
+    m_first_block = block->block_num;
+    m_blocks = 0;
+#endif
+}
+
+} // namespace
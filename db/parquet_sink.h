@@ -0,0 +1,49 @@
+#ifndef PARQUET_SINK_H
+#define PARQUET_SINK_H
+
+#include "consumer_core.h"
+
+#include <memory>
+#include <string>
+
+#include <eosio/chain/block_state.hpp>
+
+namespace eosio {
+
+// Writes the blocks, transactions and actions to Parquet files for the analytics,
+// next to or instead of the SQL database.
+//
+// The files are partitioned by day: <dir>/<table>/date=YYYY-MM-DD/part-<first block>.parquet.
+// A file is rolled at the end of the day or after max_blocks_per_file, and is only
+// readable once closed. Rows are buffered up to row_group_rows per row group. The
+// name columns (accounts, actions, permissions) are dictionary encoded. Actions are
+// the ones carried by the transactions, data is their packed payload.
+// Available when built with Arrow and Parquet (SQL_DB_HAVE_PARQUET).
+class parquet_sink : public consumer_core<chain::block_state_ptr>
+{
+public:
+    parquet_sink(const std::string& dir, uint32_t max_blocks_per_file = 100000, size_t row_group_rows = 100000);
+    ~parquet_sink();
+
+    static bool supported();
+
+    void consume(const std::vector<chain::block_state_ptr>& blocks) override;
+    void close();
+
+private:
+    struct tables;
+
+    void roll(const chain::block_state_ptr& block, const std::string& date);
+
+    std::string m_dir;
+    uint32_t m_max_blocks_per_file;
+    size_t m_row_group_rows;
+    std::unique_ptr<tables> m_tables;
+    std::string m_date;
+    uint32_t m_first_block = 0;
+    uint32_t m_blocks = 0;
+};
+
+} // namespace
+
+#endif // PARQUET_SINK_H
@@ -0,0 +1,358 @@
+#include "payload_codec.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fc/exception/exception.hpp>
+#include <fc/log/logger.hpp>
+
+#ifdef SQL_DB_HAVE_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+#include "chain_strings.h"
+
+namespace eosio {
+
+namespace {
+
+const size_t max_samples = 1000;
+const size_t max_sample_bytes = 256 * 1024;
+const size_t max_sampled_types = 256; // bounds the memory held by the samples
+const size_t dictionary_capacity = 16 * 1024;
+const size_t max_resident_dictionaries = 256; // prepared, 100 KB or more each
+const uint32_t first_dictionary_id = 32768; // the ids below are reserved by zstd
+
+// PostgreSQL returns bytea as \x followed by the hex digits
+std::string from_stored(const std::string& stored)
+{
+    if (stored.size() < 2 || stored[0] != '\\' || stored[1] != 'x') {
+        return stored;
+    }
+
+    auto digit = [](char c) {
+        return c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10;
+    };
+    std::string result((stored.size() - 2) / 2, '\0');
+    for (size_t i = 0; i < result.size(); ++i) {
+        result[i] = static_cast<char>(digit(stored[2 + 2 * i]) << 4 | digit(stored[3 + 2 * i]));
+    }
+    return result;
+}
+
+#ifdef SQL_DB_HAVE_ZSTD
+// the dictionary header: magic number then id, little endian
+void set_dictionary_id(std::string& dictionary, uint32_t id)
+{
+    FC_ASSERT(dictionary.size() >= 8, "zstd dictionary without header");
+    for (int i = 0; i < 4; ++i) {
+        dictionary[4 + i] = static_cast<char>(id >> (8 * i));
+    }
+}
+#endif
+
+} // namespace
+
+payload_compressor::payload_compressor(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer, int level):
+    m_session(session),
+    m_writer(writer),
+    m_level(level)
+{
+    backend = session->get_backend_name();
+
+#ifdef SQL_DB_HAVE_ZSTD
+    m_context = ZSTD_createCCtx();
+
+    // the dictionaries trained before a restart are kept, new ones follow their ids;
+    // they are prepared on their first use
+    m_next_id = first_dictionary_id;
+    try {
+        long long id;
+        std::string account, name;
+        soci::statement statement = (session->prepare << "SELECT id, account, name FROM payload_dictionaries ORDER BY id",
+                soci::into(id), soci::into(account), soci::into(name));
+        statement.execute();
+        while (statement.fetch()) {
+            auto& type = m_types[{chain::name(account).value, chain::name(name).value}];
+            type.id = static_cast<uint32_t>(id);
+            type.trained = true;
+            m_next_id = std::max<uint32_t>(m_next_id, id + 1);
+        }
+    } catch (const std::exception& e) { // tables created before the compression existed
+        wlog(e.what());
+    }
+    m_committed_id = m_next_id;
+#endif
+}
+
+payload_compressor::~payload_compressor()
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    for (auto& type : m_types) {
+        ZSTD_freeCDict(type.second.dictionary);
+    }
+    ZSTD_freeCCtx(m_context);
+#endif
+}
+
+bool payload_compressor::supported()
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+void payload_compressor::compress(chain::account_name account, chain::action_name name, const std::string& json, std::string& out)
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    const type_key key{account.value, name.value};
+    auto& type = m_types[key];
+    if (!type.trained && type.sample_sizes.empty()) {
+        type.trained = m_sampling >= max_sampled_types; // too many types in training: this one goes without
+        m_sampling += type.trained ? 0 : 1;
+    }
+    if (!type.trained) {
+        type.samples += json;
+        type.sample_sizes.push_back(json.size());
+        if (type.sample_sizes.size() >= max_samples || type.samples.size() >= max_sample_bytes) {
+            this->train(account, name, type);
+        }
+    }
+
+    const auto dictionary = this->get_dictionary(key, type);
+    m_frame.resize(ZSTD_compressBound(json.size()));
+    const auto size = dictionary ?
+                ZSTD_compress_usingCDict(m_context, &m_frame[0], m_frame.size(), json.data(), json.size(), dictionary) :
+                ZSTD_compressCCtx(m_context, &m_frame[0], m_frame.size(), json.data(), json.size(), m_level);
+    FC_ASSERT(!ZSTD_isError(size), "zstd: ${e}", ("e", ZSTD_getErrorName(size)));
+    this->to_bound(m_frame.data(), size, out);
+#else
+    FC_THROW("payload compression needs the plugin built with zstd");
+#endif
+}
+
+void payload_compressor::commit()
+{
+    m_trained.clear();
+    m_committed_id = m_next_id;
+}
+
+void payload_compressor::rollback()
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    // their rows were rolled back with the batch: trained again from new samples
+    for (const auto& key : m_trained) {
+        auto it = m_types.find(key);
+        if (it != m_types.end()) {
+            this->free_dictionary(it->second);
+            m_types.erase(it);
+        }
+    }
+#endif
+    m_trained.clear();
+    m_next_id = m_committed_id;
+}
+
+void payload_compressor::drop(soci::session& session)
+{
+    try {
+        session << "DROP TABLE IF EXISTS payload_dictionaries";
+    }
+    catch(std::exception& e){
+        wlog(e.what());
+    }
+}
+
+void payload_compressor::create(soci::session& session)
+{
+    const auto backend = session.get_backend_name();
+    if (backend == "postgresql") {
+        session << "CREATE TABLE payload_dictionaries ("
+                "id BIGINT PRIMARY KEY,"
+                "account TEXT,"
+                "name TEXT,"
+                "dictionary BYTEA);";
+    }
+    else if (backend == "mysql") {
+        session << "CREATE TABLE payload_dictionaries("
+                "id BIGINT PRIMARY KEY,"
+                "account VARCHAR(12),"
+                "name VARCHAR(12),"
+                "dictionary LONGBLOB) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+    }
+    else if (backend == "sqlite3") {
+        session << "CREATE TABLE payload_dictionaries ("
+                "id INTEGER PRIMARY KEY,"
+                "account TEXT,"
+                "name TEXT,"
+                "dictionary BLOB);";
+    }
+}
+
+// private
+
+void payload_compressor::train(chain::account_name account, chain::action_name name, payload_type& type)
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    std::string dictionary(dictionary_capacity, '\0');
+    const auto size = ZDICT_trainFromBuffer(&dictionary[0], dictionary.size(),
+                                            type.samples.data(), type.sample_sizes.data(), type.sample_sizes.size());
+    type.trained = true;
+    std::string().swap(type.samples);
+    std::vector<size_t>().swap(type.sample_sizes);
+    --m_sampling;
+
+    if (ZDICT_isError(size)) { // too few or too similar samples
+        dlog("no payload dictionary for ${a}::${n}: ${e}", ("a", account.to_string())("n", name.to_string())("e", ZDICT_getErrorName(size)));
+        return;
+    }
+
+    // zstd picks random ids: ours are sequential, so they do not collide
+    dictionary.resize(size);
+    type.id = m_next_id++;
+    set_dictionary_id(dictionary, type.id);
+    this->set_dictionary({account.value, name.value}, type, dictionary);
+    m_trained.push_back({account.value, name.value});
+
+    std::string bound;
+    this->to_bound(dictionary.data(), dictionary.size(), bound);
+    m_writer->exec(this->add_dictionary(),
+            static_cast<long long>(type.id),
+            account.to_string(),
+            name.to_string(),
+            bound);
+#endif
+}
+
+ZSTD_CDict_s* payload_compressor::get_dictionary(const type_key& key, payload_type& type)
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    if (type.dictionary) {
+        m_resident.splice(m_resident.begin(), m_resident, type.resident);
+        return type.dictionary;
+    }
+    if (!type.id) {
+        return nullptr;
+    }
+
+    m_writer->sync(); // the session is used directly
+    std::string stored;
+    const long long id = type.id;
+    *m_session << "SELECT dictionary FROM payload_dictionaries WHERE id = :id", soci::into(stored), soci::use(id, "id");
+    FC_ASSERT(m_session->got_data(), "missing payload dictionary ${id}", ("id", type.id));
+    this->set_dictionary(key, type, from_stored(stored));
+    return type.dictionary;
+#else
+    return nullptr;
+#endif
+}
+
+void payload_compressor::set_dictionary(const type_key& key, payload_type& type, const std::string& dictionary)
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    type.dictionary = ZSTD_createCDict(dictionary.data(), dictionary.size(), m_level);
+    m_resident.push_front(key);
+    type.resident = m_resident.begin();
+    if (m_resident.size() > max_resident_dictionaries) {
+        this->free_dictionary(m_types[m_resident.back()]); // read again when needed
+    }
+#endif
+}
+
+void payload_compressor::free_dictionary(payload_type& type)
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    if (type.dictionary) {
+        ZSTD_freeCDict(type.dictionary);
+        type.dictionary = nullptr;
+        m_resident.erase(type.resident);
+    }
+#endif
+}
+
+void payload_compressor::to_bound(const char* data, size_t size, std::string& out)
+{
+    if (backend == "sqlite3") {
+        out.assign(data, size);
+    } else {
+        hex_string(data, size, out);
+    }
+}
+
+// payload_compressor::add_dictionary() defaults to MySQL syntax
+std::string payload_compressor::add_dictionary()
+{
+    if (backend == "postgresql") {
+        return "INSERT INTO payload_dictionaries (id, account, name, dictionary) VALUES (:id, :ac, :na, decode(:di, 'hex'))";
+    }
+    else if (backend == "sqlite3") {
+        return "INSERT INTO payload_dictionaries (id, account, name, dictionary) VALUES (:id, :ac, :na, :di)";
+    }
+
+    return "INSERT INTO payload_dictionaries (id, account, name, dictionary) VALUES (:id, :ac, :na, UNHEX(:di))";
+}
+
+payload_decompressor::payload_decompressor(std::shared_ptr<soci::session> session):
+    m_session(session)
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    m_context = ZSTD_createDCtx();
+#endif
+}
+
+payload_decompressor::~payload_decompressor()
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    for (auto& dictionary : m_dictionaries) {
+        ZSTD_freeDDict(dictionary.second);
+    }
+    ZSTD_freeDCtx(m_context);
+#endif
+}
+
+std::string payload_decompressor::decompress(const std::string& stored)
+{
+#ifdef SQL_DB_HAVE_ZSTD
+    const auto frame = from_stored(stored);
+    const auto content_size = ZSTD_getFrameContentSize(frame.data(), frame.size());
+    FC_ASSERT(content_size != ZSTD_CONTENTSIZE_ERROR && content_size != ZSTD_CONTENTSIZE_UNKNOWN, "not a zstd payload");
+
+    std::string json(content_size, '\0');
+    const auto id = ZSTD_getDictID_fromFrame(frame.data(), frame.size());
+    const auto size = id ?
+                ZSTD_decompress_usingDDict(m_context, &json[0], json.size(), frame.data(), frame.size(), this->get_dictionary(id)) :
+                ZSTD_decompressDCtx(m_context, &json[0], json.size(), frame.data(), frame.size());
+    FC_ASSERT(!ZSTD_isError(size), "zstd: ${e}", ("e", ZSTD_getErrorName(size)));
+    json.resize(size);
+    return json;
+#else
+    FC_THROW("payload decompression needs the plugin built with zstd");
+#endif
+}
+
+// private
+
+ZSTD_DDict_s* payload_decompressor::get_dictionary(uint32_t id)
+{
+    auto it = m_dictionaries.find(id);
+    if (it != m_dictionaries.end()) {
+        return it->second;
+    }
+
+#ifdef SQL_DB_HAVE_ZSTD
+    std::string stored;
+    const long long id_value = id;
+    *m_session << "SELECT dictionary FROM payload_dictionaries WHERE id = :id", soci::into(stored), soci::use(id_value, "id");
+    FC_ASSERT(m_session->got_data(), "missing payload dictionary ${id}", ("id", id));
+
+    const auto dictionary = from_stored(stored);
+    return m_dictionaries[id] = ZSTD_createDDict(dictionary.data(), dictionary.size());
+#else
+    return nullptr;
+#endif
+}
+
+} // namespace
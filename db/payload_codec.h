@@ -0,0 +1,106 @@
+#ifndef PAYLOAD_CODEC_H
+#define PAYLOAD_CODEC_H
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <soci/soci.h>
+
+#include <eosio/chain/types.hpp>
+
+#include "sql_writer.h"
+
+struct ZSTD_CCtx_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DCtx_s;
+struct ZSTD_DDict_s;
+
+namespace eosio {
+
+// Compresses the action payloads (actions.data_zstd) with zstd.
+//
+// Every (contract, action) gets a dictionary trained on its first payloads: the
+// JSON of one type repeats the same keys and shapes, which a dictionary removes
+// even from the small payloads. Until then the payloads are compressed without.
+// The dictionaries are stored in payload_dictionaries under their zstd id, which
+// every frame carries. Only the most recently used ones are kept prepared in
+// memory, the others are read again when their type comes back. The ones trained
+// by a batch are forgotten if it rolls back, with their ids: their rows are gone.
+// Available when built with zstd only (SQL_DB_HAVE_ZSTD).
+class payload_compressor
+{
+public:
+    payload_compressor(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer, int level = 3);
+    ~payload_compressor();
+
+    static bool supported();
+
+    // out: the zstd frame as bound for the backend: hex text that the SQL decodes, but for SQLite
+    void compress(chain::account_name account, chain::action_name name, const std::string& json, std::string& out);
+
+    // the batch
+    void commit();
+    void rollback();
+
+    // payload_dictionaries
+    static void drop(soci::session& session);
+    static void create(soci::session& session);
+
+private:
+    using type_key = std::pair<uint64_t, uint64_t>;
+
+    struct payload_type {
+        std::string samples;
+        std::vector<size_t> sample_sizes;
+        uint32_t id = 0; // of the dictionary, 0: none
+        ZSTD_CDict_s* dictionary = nullptr; // prepared, when resident
+        std::list<type_key>::iterator resident;
+        bool trained = false; // or given up
+    };
+
+    void train(chain::account_name account, chain::action_name name, payload_type& type);
+    ZSTD_CDict_s* get_dictionary(const type_key& key, payload_type& type);
+    void set_dictionary(const type_key& key, payload_type& type, const std::string& dictionary);
+    void free_dictionary(payload_type& type);
+    void to_bound(const char* data, size_t size, std::string& out);
+    std::string add_dictionary();
+
+    std::shared_ptr<soci::session> m_session;
+    std::shared_ptr<sql_writer> m_writer;
+    std::string backend;
+    int m_level;
+    ZSTD_CCtx_s* m_context = nullptr;
+    std::string m_frame;
+    std::map<type_key, payload_type> m_types;
+    std::list<type_key> m_resident; // most recent first
+    std::vector<type_key> m_trained; // by the batch
+    size_t m_sampling = 0;
+    uint32_t m_next_id = 0;
+    uint32_t m_committed_id = 0; // m_next_id at the last commit
+};
+
+// The read side: the payload JSON from the actions.data_zstd value.
+class payload_decompressor
+{
+public:
+    payload_decompressor(std::shared_ptr<soci::session> session);
+    ~payload_decompressor();
+
+    // stored: the value as read from the database (PostgreSQL returns bytea as \x hex)
+    std::string decompress(const std::string& stored);
+
+private:
+    ZSTD_DDict_s* get_dictionary(uint32_t id);
+
+    std::shared_ptr<soci::session> m_session;
+    ZSTD_DCtx_s* m_context = nullptr;
+    std::unordered_map<uint32_t, ZSTD_DDict_s*> m_dictionaries;
+};
+
+} // namespace
+
+#endif // PAYLOAD_CODEC_H
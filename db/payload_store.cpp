@@ -0,0 +1,80 @@
+#include "payload_store.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fc/crypto/city.hpp>
+
+namespace eosio {
+
+template<typename Dialect>
+payload_store<Dialect>::payload_store(std::shared_ptr<sql_writer> writer, size_t capacity):
+    m_writer(writer),
+    m_generation_size(std::max<size_t>(1, capacity / 2))
+{
+}
+
+template<typename Dialect>
+uint64_t payload_store<Dialect>::id(const chain::action& action, uint64_t abi_hash)
+{
+    uint64_t key[3] = {action.account.value, action.name.value, abi_hash};
+    const uint64_t data_hash = fc::city_hash64(action.data.data(), action.data.size());
+
+    char buffer[sizeof(key) + sizeof(data_hash)];
+    std::memcpy(buffer, key, sizeof(key));
+    std::memcpy(buffer + sizeof(key), &data_hash, sizeof(data_hash));
+    return fc::city_hash64(buffer, sizeof(buffer));
+}
+
+template<typename Dialect>
+bool payload_store<Dialect>::contains(uint64_t id)
+{
+    if (m_batch.count(id) || m_current.count(id)) {
+        return true;
+    }
+    if (m_previous.count(id)) {
+        m_batch.insert(id); // still recent: kept in the next generation
+        return true;
+    }
+    return false;
+}
+
+template<typename Dialect>
+void payload_store<Dialect>::add(uint64_t id, const std::string& payload, bool compressed)
+{
+    m_writer->exec(compressed ? m_insert_compressed : m_insert,
+            static_cast<long long>(id), // BIGINT: the same bits
+            payload);
+    m_batch.insert(id);
+}
+
+template<typename Dialect>
+void payload_store<Dialect>::commit()
+{
+    for (const auto id : m_batch) {
+        if (m_current.size() >= m_generation_size) {
+            m_previous.swap(m_current);
+            m_current.clear();
+        }
+        m_current.insert(id);
+    }
+    m_batch.clear();
+}
+
+template<typename Dialect>
+void payload_store<Dialect>::rollback()
+{
+    m_batch.clear();
+}
+
+template<typename Dialect>
+void payload_store<Dialect>::clear()
+{
+    m_batch.clear();
+    m_current.clear();
+    m_previous.clear();
+}
+
+SQL_DB_INSTANTIATE_DIALECTS(payload_store)
+
+} // namespace
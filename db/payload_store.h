@@ -0,0 +1,57 @@
+#ifndef PAYLOAD_STORE_H
+#define PAYLOAD_STORE_H
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+
+#include <soci/soci.h>
+#include <eosio/chain/action.hpp>
+
+#include "sql_dialect.h"
+#include "sql_writer.h"
+
+namespace eosio {
+
+// The action payloads stored once (sql_db-dedup-payloads): spam and airdrops repeat
+// the same bytes millions of times. A payload is keyed by the 64 bit city hash of its
+// contract, action, ABI and raw data, so the id is known before the decode and a
+// payload seen recently is neither decoded nor written again.
+//
+// The ids written in the current batch are kept apart until it commits. The ones
+// before are remembered in two generations of `capacity` / 2 ids: when the current
+// one is full the older is forgotten. A payload written before is still found by
+// the insert, which ignores the ids already in the table.
+template<typename Dialect>
+class payload_store
+{
+public:
+    payload_store(std::shared_ptr<sql_writer> writer, size_t capacity);
+
+    // abi_hash: of the ABI the payload is decoded with, the same bytes give another JSON with another ABI
+    static uint64_t id(const chain::action& action, uint64_t abi_hash);
+
+    // written by this batch or a recent one
+    bool contains(uint64_t id);
+    // payload: as bound by the actions insert, the zstd frame when compressed
+    void add(uint64_t id, const std::string& payload, bool compressed);
+
+    // the batch is in the table
+    void commit();
+    // the batch was rolled back: its ids are not in the table
+    void rollback();
+    void clear();
+
+private:
+    std::shared_ptr<sql_writer> m_writer;
+    size_t m_generation_size;
+    std::unordered_set<uint64_t> m_batch;
+    std::unordered_set<uint64_t> m_current;
+    std::unordered_set<uint64_t> m_previous;
+    const std::string m_insert = Dialect::actions::insert_payload();
+    const std::string m_insert_compressed = Dialect::actions::insert_payload_compressed();
+};
+
+} // namespace
+
+#endif // PAYLOAD_STORE_H
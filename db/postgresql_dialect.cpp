@@ -0,0 +1,172 @@
+#include "postgresql_dialect.h"
+
+namespace eosio {
+
+void postgresql_dialect::open(soci::session&)
+{
+}
+
+void postgresql_dialect::disable_references(soci::session& session, const std::string& schema)
+{
+    // the tables are dropped with CASCADE
+    session << "SET search_path TO " << schema << ",public;";
+}
+
+void postgresql_dialect::enable_references(soci::session&)
+{
+}
+
+void postgresql_dialect::accounts::create(soci::session& session)
+{
+    session << "CREATE TABLE accounts ("
+        "name TEXT PRIMARY KEY,"
+        "abi JSONB DEFAULT NULL,"
+        "created_at TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP,"
+        "updated_at TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP);";
+
+    session << "CREATE TABLE accounts_keys ("
+        "account TEXT REFERENCES accounts (name),"
+        "public_key TEXT,"
+        "permission TEXT);";
+}
+
+void postgresql_dialect::blocks::create(soci::session& session)
+{
+    session << "CREATE TABLE blocks ("
+        "id TEXT PRIMARY KEY,"
+        "block_number SERIAL,"
+        "prev_block_id TEXT,"
+        "irreversible INT DEFAULT 0,"
+        "timestamp TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP,"
+        "transaction_merkle_root TEXT,"
+        "action_merkle_root TEXT,"
+        "producer TEXT,"
+        "version INT NOT NULL DEFAULT 0,"
+        "new_producers JSONB DEFAULT NULL,"
+        "num_transactions INT DEFAULT 0,"
+        "confirmed INT,"
+        "UNIQUE (block_number)"
+    ");";
+}
+
+void postgresql_dialect::transactions::create(soci::session& session)
+{
+    session << "CREATE TABLE transactions ("
+            "id TEXT PRIMARY KEY,"
+            "block_id INT NOT NULL REFERENCES blocks (block_number) ON DELETE CASCADE,"
+            "ref_block_num INT NOT NULL,"
+            "ref_block_prefix INT,"
+            "expiration TIMESTAMPTZ DEFAULT NOW(),"
+            "pending INT,"
+            "created_at TIMESTAMPTZ DEFAULT NOW(),"
+            "num_actions INT DEFAULT 0,"
+            "updated_at TIMESTAMPTZ DEFAULT NOW());";
+}
+
+void postgresql_dialect::actions::create(soci::session& session)
+{
+    session << "CREATE TABLE actions ("
+            "id SERIAL PRIMARY KEY,"
+            "block_number INT,"
+            "account TEXT,"
+            "receiver TEXT,"
+            "transaction_id TEXT REFERENCES transactions (id) ON DELETE CASCADE,"
+            "seq INT,"
+            "parent INT DEFAULT NULL," // seq of the parent action in the same transaction
+            "name TEXT,"
+            "created_at TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP,"
+            "data JSONB,"
+            "data_zstd BYTEA," // instead of data with sql_db-compress-payloads
+            "payload_id BIGINT DEFAULT NULL);"; // instead of both with sql_db-dedup-payloads
+
+    session << "CREATE TABLE payloads ("
+            "id BIGINT PRIMARY KEY,"
+            "data JSONB,"
+            "data_zstd BYTEA);";
+
+    session << "CREATE TABLE actions_accounts ("
+            "block_number INT,"
+            "actor TEXT,"
+            "permission TEXT,"
+            "action_id INT NOT NULL REFERENCES actions (id) ON DELETE CASCADE)";
+
+    session << "CREATE TABLE tokens ("
+            "account TEXT,"
+            "symbol TEXT,"
+            "amount DOUBLE PRECISION);"; // TODO: other tokens could have diff format.
+
+    session << "CREATE TABLE stakes("
+            "account text PRIMARY KEY,"
+            "cpu REAL,"
+            "net REAL);";
+
+    session << "CREATE TABLE votes ("
+            "account text PRIMARY KEY,"
+            "votes JSONB);";
+}
+
+void postgresql_dialect::block_ranges::create(soci::session& session)
+{
+    session << "CREATE TABLE block_ranges ("
+        "first_block BIGINT NOT NULL,"
+        "last_block BIGINT NOT NULL,"
+        "created_at TIMESTAMPTZ DEFAULT CURRENT_TIMESTAMP);";
+
+    session << "CREATE TABLE backfill_start ("
+        "first_block BIGINT NOT NULL);";
+}
+
+void postgresql_dialect::rollups::create(soci::session& session)
+{
+    session << "CREATE TABLE rollup_blocks ("
+            "block_number INT PRIMARY KEY,"
+            "transactions INT,"
+            "actions INT);";
+
+    session << "CREATE TABLE rollup_minutes ("
+            "minute TIMESTAMPTZ PRIMARY KEY,"
+            "blocks INT,"
+            "transactions BIGINT,"
+            "actions BIGINT);";
+
+    session << "CREATE TABLE rollup_contracts ("
+            "account TEXT,"
+            "name TEXT,"
+            "actions BIGINT,"
+            "PRIMARY KEY (account, name));";
+
+    session << "CREATE TABLE rollup_transfers ("
+            "minute TIMESTAMPTZ,"
+            "contract TEXT,"
+            "symbol TEXT,"
+            "transfers BIGINT,"
+            "volume DOUBLE PRECISION,"
+            "PRIMARY KEY (minute, contract, symbol));";
+}
+
+void postgresql_dialect::abi_history::create(soci::session& session)
+{
+    session << "CREATE TABLE abi_history ("
+            "account TEXT,"
+            "block_number INT,"
+            "abi_hash BIGINT,"
+            "abi JSONB,"
+            "PRIMARY KEY (account, block_number));";
+}
+
+void postgresql_dialect::action_costs::create(soci::session& session)
+{
+    session << "CREATE TABLE action_costs ("
+            "account TEXT,"
+            "name TEXT,"
+            "actions BIGINT,"
+            "skipped BIGINT,"
+            "bytes BIGINT,"
+            "abi_us BIGINT,"
+            "decode_us BIGINT,"
+            "sql_us BIGINT,"
+            "total_us BIGINT,"
+            "PRIMARY KEY (account, name));";
+}
+
+} // namespace
@@ -0,0 +1,200 @@
+#include "rollups_table.h"
+
+#include <set>
+
+#include <fc/log/logger.hpp>
+
+#include "chain_strings.h"
+
+namespace eosio {
+
+namespace {
+const size_t max_window = 10000; // if irreversibility stalls
+}
+
+template<typename Dialect>
+rollups_table<Dialect>::rollups_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer):
+    m_session(session),
+    m_writer(writer)
+{
+}
+
+template<typename Dialect>
+void rollups_table<Dialect>::drop()
+{
+    try {
+        *m_session << "DROP TABLE IF EXISTS rollup_blocks";
+        *m_session << "DROP TABLE IF EXISTS rollup_minutes";
+        *m_session << "DROP TABLE IF EXISTS rollup_contracts";
+        *m_session << "DROP TABLE IF EXISTS rollup_transfers";
+    }
+    catch(std::exception& e){
+        wlog(e.what());
+    }
+}
+
+template<typename Dialect>
+void rollups_table<Dialect>::create()
+{
+    Dialect::rollups::create(*m_session);
+}
+
+template<typename Dialect>
+void rollups_table<Dialect>::add_block(const chain::block_state_ptr& block)
+{
+    const auto block_num = block->block_num;
+
+    // a fork replaces the blocks from block_num on
+    while (!m_window.empty() && m_window.back().block_num >= block_num) {
+        auto& replaced = m_window.back();
+        m_removed_blocks.push_back(replaced.block_num);
+        if (!m_blocks.erase(replaced.block_num)) {
+            this->apply(replaced, -1); // already written
+            m_replaced.push_back(std::move(replaced));
+        }
+        m_window.pop_back();
+    }
+
+    m_window.emplace_back();
+    auto& rollup = m_window.back();
+    rollup.block_num = block_num;
+    rollup.minute = block->block->timestamp.operator fc::time_point().sec_since_epoch() / 60 * 60;
+    rollup.transactions = block->block->transactions.size();
+    m_blocks[block_num] = &rollup;
+    m_irreversible = block->dpos_irreversible_blocknum;
+}
+
+template<typename Dialect>
+void rollups_table<Dialect>::add_action(chain::account_name account, chain::action_name name)
+{
+    if (m_window.empty()) {
+        return;
+    }
+    auto& rollup = m_window.back();
+    rollup.actions++;
+    rollup.contract_actions[{account.value, name.value}]++;
+}
+
+template<typename Dialect>
+void rollups_table<Dialect>::add_transfer(chain::account_name contract, const chain::asset& quantity)
+{
+    if (m_window.empty()) {
+        return;
+    }
+    auto& transfers = m_window.back().contract_transfers[{contract.value, quantity.get_symbol().name()}];
+    transfers.count++;
+    transfers.volume += quantity.to_real();
+}
+
+template<typename Dialect>
+void rollups_table<Dialect>::flush()
+{
+    for (const auto block_num : m_removed_blocks) {
+        m_writer->exec("DELETE FROM rollup_blocks WHERE block_number = :bn",
+                block_num);
+    }
+
+    for (const auto& block : m_blocks) {
+        this->apply(*block.second, 1);
+        m_batch_blocks.push_back(block.first);
+        m_writer->exec(m_upsert_block,
+                block.first,
+                block.second->transactions,
+                block.second->actions);
+    }
+
+    for (const auto& minute : m_minutes) {
+        m_writer->exec(m_add_minute,
+                minute.first,
+                minute.second.blocks,
+                minute.second.transactions,
+                minute.second.actions);
+    }
+
+    for (const auto& contract : m_contracts) {
+        if (contract.second == 0) {
+            continue;
+        }
+        m_writer->exec(m_add_contract,
+                name_string(contract.first.first),
+                name_string(contract.first.second),
+                contract.second);
+    }
+
+    for (const auto& transfer : m_transfers) {
+        if (transfer.second.count == 0) {
+            continue;
+        }
+        m_writer->exec(m_add_transfers,
+                std::get<0>(transfer.first),
+                name_string(std::get<1>(transfer.first)),
+                std::get<2>(transfer.first),
+                transfer.second.count,
+                transfer.second.volume);
+    }
+
+    m_blocks.clear();
+    m_removed_blocks.clear();
+    m_minutes.clear();
+    m_contracts.clear();
+    m_transfers.clear();
+
+    while (!m_window.empty() && (m_window.front().block_num <= m_irreversible || m_window.size() > max_window)) {
+        m_window.pop_front();
+    }
+}
+
+template<typename Dialect>
+void rollups_table<Dialect>::commit()
+{
+    m_batch_blocks.clear();
+    m_replaced.clear();
+}
+
+template<typename Dialect>
+void rollups_table<Dialect>::rollback()
+{
+    // the blocks of the batch are the newest of the window
+    std::set<uint32_t> added(m_batch_blocks.begin(), m_batch_blocks.end());
+    for (const auto& block : m_blocks) {
+        added.insert(block.first);
+    }
+    while (!m_window.empty() && added.count(m_window.back().block_num)) {
+        m_window.pop_back();
+    }
+    for (auto it = m_replaced.rbegin(); it != m_replaced.rend(); ++it) {
+        m_window.push_back(std::move(*it));
+    }
+
+    m_blocks.clear();
+    m_removed_blocks.clear();
+    m_minutes.clear();
+    m_contracts.clear();
+    m_transfers.clear();
+    m_batch_blocks.clear();
+    m_replaced.clear();
+}
+
+// private
+
+template<typename Dialect>
+void rollups_table<Dialect>::apply(const block_rollup& block, int sign)
+{
+    auto& minute = m_minutes[block.minute];
+    minute.blocks += sign;
+    minute.transactions += sign * block.transactions;
+    minute.actions += sign * block.actions;
+
+    for (const auto& contract : block.contract_actions) {
+        m_contracts[contract.first] += sign * contract.second;
+    }
+    for (const auto& contract : block.contract_transfers) {
+        auto& transfers = m_transfers[std::make_tuple(block.minute, contract.first.first, contract.first.second)];
+        transfers.count += sign * contract.second.count;
+        transfers.volume += sign * contract.second.volume;
+    }
+}
+
+SQL_DB_INSTANTIATE_DIALECTS(rollups_table)
+
+} // namespace
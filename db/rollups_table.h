@@ -0,0 +1,98 @@
+#ifndef ROLLUPS_TABLE_H
+#define ROLLUPS_TABLE_H
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <soci/soci.h>
+
+#include <eosio/chain/asset.hpp>
+#include <eosio/chain/block_state.hpp>
+
+#include "sql_dialect.h"
+#include "sql_writer.h"
+
+namespace eosio {
+
+// Aggregates kept while the blocks are ingested, so the dashboards read a few
+// rows instead of scanning actions and transactions:
+//   rollup_blocks:    transactions and actions per block
+//   rollup_minutes:   blocks, transactions and actions per minute
+//   rollup_contracts: actions per contract action
+//   rollup_transfers: transfers and volume per minute, token contract and symbol
+//
+// The counts of a batch are written by flush() as increments. The blocks of the
+// reversible window are remembered: when a fork replaces them their counts are
+// subtracted before the new blocks are added. rollback() puts the window back as
+// it was before the batch that was not committed.
+template<typename Dialect>
+class rollups_table
+{
+public:
+    rollups_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer);
+
+    void drop();
+    void create();
+
+    void add_block(const chain::block_state_ptr& block);
+    // for the block added last
+    void add_action(chain::account_name account, chain::action_name name);
+    void add_transfer(chain::account_name contract, const chain::asset& quantity);
+
+    void flush();
+    // the outcome of the batch written by flush()
+    void commit();
+    void rollback();
+
+private:
+    struct transfers {
+        int64_t count = 0;
+        double volume = 0;
+    };
+
+    struct block_rollup {
+        uint32_t block_num;
+        int64_t minute;
+        int64_t transactions = 0;
+        int64_t actions = 0;
+        std::map<std::pair<uint64_t, uint64_t>, int64_t> contract_actions;
+        std::map<std::pair<uint64_t, std::string>, transfers> contract_transfers;
+    };
+
+    struct minute_counts {
+        int64_t blocks = 0;
+        int64_t transactions = 0;
+        int64_t actions = 0;
+    };
+
+    void apply(const block_rollup& block, int sign);
+
+    std::shared_ptr<soci::session> m_session;
+    std::shared_ptr<sql_writer> m_writer;
+    const std::string m_upsert_block = Dialect::rollups::upsert_block();
+    const std::string m_add_minute = Dialect::rollups::add_minute();
+    const std::string m_add_contract = Dialect::rollups::add_contract();
+    const std::string m_add_transfers = Dialect::rollups::add_transfers();
+
+    std::deque<block_rollup> m_window; // reversible blocks, oldest first: pruned by flush() only
+    uint32_t m_irreversible = 0;
+
+    // increments of the batch
+    std::map<uint32_t, const block_rollup*> m_blocks; // in m_window, not yet applied
+    std::vector<uint32_t> m_removed_blocks;
+    std::map<int64_t, minute_counts> m_minutes;
+    std::map<std::pair<uint64_t, uint64_t>, int64_t> m_contracts;
+    std::map<std::tuple<int64_t, uint64_t, std::string>, transfers> m_transfers;
+
+    // what the batch changed in the window, for rollback()
+    std::vector<uint32_t> m_batch_blocks; // added, already applied by flush()
+    std::vector<block_rollup> m_replaced; // committed and replaced by a fork, newest first
+};
+
+} // namespace
+
+#endif // ROLLUPS_TABLE_H
@@ -0,0 +1,44 @@
+#ifndef SQL_DIALECT_H
+#define SQL_DIALECT_H
+
+#include <stdexcept>
+#include <string>
+
+#include "mysql_dialect.h"
+#include "postgresql_dialect.h"
+#include "sqlite_dialect.h"
+
+// The SQL of each backend is a dialect: a traits type with the statement text of
+// every table and the few steps that differ between the backends. The tables are
+// templates on it, so the text is fixed at compile time instead of chosen on each
+// row. A new backend is a new dialect added here.
+
+namespace eosio {
+
+// calls f with a value of the dialect of the soci backend
+template<typename F>
+void with_dialect(const std::string& backend, F&& f)
+{
+    if (backend == postgresql_dialect::name()) {
+        f(postgresql_dialect());
+    }
+    else if (backend == mysql_dialect::name()) {
+        f(mysql_dialect());
+    }
+    else if (backend == sqlite_dialect::name()) {
+        f(sqlite_dialect());
+    }
+    else {
+        throw std::runtime_error("unsupported soci backend " + backend);
+    }
+}
+
+} // namespace
+
+// in the .cpp of a class template on the dialect
+#define SQL_DB_INSTANTIATE_DIALECTS(name) \
+    template class name<mysql_dialect>; \
+    template class name<postgresql_dialect>; \
+    template class name<sqlite_dialect>;
+
+#endif // SQL_DIALECT_H
@@ -0,0 +1,322 @@
+#include "sql_writer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <poll.h>
+#include <stdexcept>
+
+#include <fc/log/logger.hpp>
+
+#ifdef SQL_DB_HAVE_LIBPQ
+#include <libpq-fe.h>
+#include <soci/postgresql/soci-postgresql.h>
+#endif
+
+#if defined(SQL_DB_HAVE_LIBPQ) && defined(LIBPQ_HAS_PIPELINING)
+#define SQL_DB_PIPELINE 1
+#endif
+
+namespace eosio {
+
+namespace {
+// past this many statements without a result the writer waits for the server to catch up
+const size_t max_in_flight = 4096;
+}
+
+sql_writer::sql_writer(std::shared_ptr<soci::session> session, batch_arena* arena):
+    m_session(session),
+    m_arena(arena)
+{
+}
+
+sql_writer::~sql_writer()
+{
+    try {
+        this->sync();
+    } catch (const std::exception& e) {
+        elog("${e}", ("e", e.what()));
+    }
+}
+
+bool sql_writer::pipeline_supported(const std::string& backend)
+{
+#ifdef SQL_DB_PIPELINE
+    return backend == "postgresql";
+#else
+    return false;
+#endif
+}
+
+void sql_writer::set_pipeline(bool enabled)
+{
+    this->sync();
+    if (enabled && !pipeline_supported(m_session->get_backend_name())) {
+        throw std::runtime_error("pipelined writes need the postgresql backend and libpq >= 14");
+    }
+
+#ifdef SQL_DB_PIPELINE
+    m_conn = enabled ? static_cast<soci::postgresql_session_backend*>(m_session->get_backend())->conn_ : nullptr;
+#endif
+    m_pipeline = enabled;
+}
+
+void sql_writer::exec(bulk& rows)
+{
+    if (rows.empty()) {
+        return;
+    }
+    const auto& sql = rows.sql();
+
+    if (!m_pipeline) {
+        std::vector<soci::indicator> indicators;
+        indicators.reserve(rows.m_values.size());
+        soci::statement statement(*m_session);
+        for (auto& v : rows.m_values) {
+            indicators.push_back(v.null ? soci::i_null : soci::i_ok);
+            statement.exchange(soci::use(v.value, indicators.back()));
+        }
+        statement.alloc();
+        statement.prepare(sql);
+        statement.define_and_bind();
+        statement.execute(true);
+    } else {
+        param_list params(m_arena);
+        params.reserve(rows.m_values.size());
+        for (const auto& v : rows.m_values) {
+            params.emplace_back(m_arena);
+            params.back().value.assign(v.value.data(), v.value.size());
+            params.back().null = v.null;
+        }
+        this->send(sql, params);
+    }
+    rows.clear();
+}
+
+sql_writer::bulk::bulk(const std::string& insert)
+{
+    const auto values = insert.find(" VALUES ");
+    if (values == std::string::npos) {
+        throw std::invalid_argument("not an INSERT ... VALUES statement: " + insert);
+    }
+    m_head = insert.substr(0, values + 8);
+
+    // the same placeholder syntax as positional(): :name outside quotes, :: is a cast
+    std::string literal;
+    bool quoted = false;
+    for (size_t i = values + 8; i < insert.size(); ++i) {
+        const char c = insert[i];
+        if (c == '\'') {
+            quoted = !quoted;
+        }
+        if (quoted || c != ':') {
+            literal += c;
+        } else if (i + 1 < insert.size() && insert[i + 1] == ':') {
+            literal += "::";
+            ++i;
+        } else {
+            std::string name;
+            while (i + 1 < insert.size() && (std::isalnum(static_cast<unsigned char>(insert[i + 1])) || insert[i + 1] == '_')) {
+                name += insert[++i];
+            }
+            m_literals.push_back(std::move(literal));
+            m_names.push_back(std::move(name));
+            literal.clear();
+        }
+    }
+    m_literals.push_back(std::move(literal));
+
+    // SQLite binds 999 parameters at most before 3.32
+    m_max_rows = std::max<size_t>(1, 999 / std::max<size_t>(1, m_names.size()));
+}
+
+void sql_writer::bulk::clear()
+{
+    m_values.clear();
+    m_rows = 0;
+}
+
+const std::string& sql_writer::bulk::sql()
+{
+    auto it = m_statements.find(m_rows);
+    if (it != m_statements.end()) {
+        return it->second;
+    }
+
+    std::string sql = m_head;
+    for (size_t row = 0; row < m_rows; ++row) {
+        if (row > 0) {
+            sql += ", ";
+        }
+        for (size_t i = 0; i < m_names.size(); ++i) {
+            sql += m_literals[i];
+            sql += ':';
+            sql += m_names[i];
+            sql += '_';
+            sql += std::to_string(row); // SQLite binds the same name to the same value
+        }
+        sql += m_literals.back();
+    }
+    return m_statements.emplace(m_rows, std::move(sql)).first->second;
+}
+
+#ifdef SQL_DB_PIPELINE
+
+void sql_writer::sync()
+{
+    if (!m_in_pipeline) {
+        return;
+    }
+
+    if (!PQpipelineSync(m_conn)) {
+        throw std::runtime_error(PQerrorMessage(m_conn));
+    }
+    m_syncing = true;
+    this->drain(true);
+
+    PQexitPipelineMode(m_conn);
+    PQsetnonblocking(m_conn, 0);
+    m_in_pipeline = false;
+
+    if (!m_error.empty()) {
+        std::string error;
+        std::swap(error, m_error);
+        throw std::runtime_error("pipelined statement failed: " + error);
+    }
+}
+
+// private
+
+void sql_writer::send(const std::string& sql, const param_list& params)
+{
+    if (!m_in_pipeline) {
+        if (PQsetnonblocking(m_conn, 1) != 0 || !PQenterPipelineMode(m_conn)) {
+            throw std::runtime_error(PQerrorMessage(m_conn));
+        }
+        m_in_pipeline = true;
+    }
+
+    std::vector<const char*, arena_allocator<const char*>> values(m_arena);
+    values.reserve(params.size());
+    for (const auto& p : params) {
+        values.push_back(p.null ? nullptr : p.value.c_str());
+    }
+
+    const auto& statement = this->positional(sql);
+    if (!PQsendQueryParams(m_conn, statement.c_str(), static_cast<int>(values.size()), nullptr, values.data(), nullptr, nullptr, 0)) {
+        throw std::runtime_error(PQerrorMessage(m_conn));
+    }
+    ++m_in_flight;
+
+    this->drain(false);
+    while (m_in_flight > max_in_flight) {
+        PQsendFlushRequest(m_conn); // the server holds small results back until asked
+        this->wait_socket();
+        this->drain(false);
+    }
+}
+
+// translates soci :name placeholders to libpq $n ones, in order of appearance
+const std::string& sql_writer::positional(const std::string& sql)
+{
+    auto it = m_statements.find(sql);
+    if (it != m_statements.end()) {
+        return it->second;
+    }
+
+    std::string result;
+    result.reserve(sql.size());
+    int n = 0;
+    bool quoted = false;
+    for (size_t i = 0; i < sql.size(); ++i) {
+        const char c = sql[i];
+        if (c == '\'') {
+            quoted = !quoted;
+        }
+        if (quoted || c != ':') {
+            result += c;
+        } else if (i + 1 < sql.size() && sql[i + 1] == ':') { // PostgreSQL cast
+            result += "::";
+            ++i;
+        } else {
+            result += '$' + std::to_string(++n);
+            while (i + 1 < sql.size() && (std::isalnum(static_cast<unsigned char>(sql[i + 1])) || sql[i + 1] == '_')) {
+                ++i;
+            }
+        }
+    }
+    return m_statements.emplace(sql, std::move(result)).first->second;
+}
+
+// collects the results already received; with until_sync blocks up to the pending sync point
+void sql_writer::drain(bool until_sync)
+{
+    while (true) {
+        if (PQflush(m_conn) < 0 || !PQconsumeInput(m_conn)) {
+            throw std::runtime_error(PQerrorMessage(m_conn));
+        }
+
+        bool separator = false;
+        while (!PQisBusy(m_conn)) {
+            PGresult* result = PQgetResult(m_conn);
+            if (!result) { // ends the results of a statement
+                if (separator || (m_in_flight == 0 && !m_syncing)) {
+                    break;
+                }
+                separator = true;
+                continue;
+            }
+            separator = false;
+
+            switch (PQresultStatus(result)) {
+            case PGRES_PIPELINE_SYNC:
+                m_syncing = false;
+                break;
+            case PGRES_FATAL_ERROR:
+                if (m_error.empty()) {
+                    m_error = PQresultErrorMessage(result);
+                }
+                --m_in_flight;
+                break;
+            default: // PGRES_PIPELINE_ABORTED for the statements following an error
+                --m_in_flight;
+                break;
+            }
+            PQclear(result);
+
+            if (until_sync && !m_syncing) {
+                return;
+            }
+        }
+
+        if (!until_sync) {
+            return;
+        }
+        this->wait_socket();
+    }
+}
+
+void sql_writer::wait_socket()
+{
+    pollfd fd;
+    fd.fd = PQsocket(m_conn);
+    fd.events = POLLIN;
+    if (PQflush(m_conn) == 1) {
+        fd.events |= POLLOUT;
+    }
+    poll(&fd, 1, -1);
+}
+
+#else
+
+void sql_writer::sync()
+{
+}
+
+void sql_writer::send(const std::string&, const param_list&)
+{
+    throw std::runtime_error("pipelined writes are not supported by this build");
+}
+
+#endif
+
+} // namespace
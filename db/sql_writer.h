@@ -0,0 +1,168 @@
+#ifndef SQL_WRITER_H
+#define SQL_WRITER_H
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/optional.hpp>
+#include <soci/soci.h>
+#include <soci/boost-optional.h>
+
+#include "batch_arena.h"
+
+struct pg_conn;
+
+namespace eosio {
+
+// Executes the statements that do not return rows.
+//
+// By default every statement is a synchronous round trip through soci. With the
+// pipeline enabled (PostgreSQL built against libpq >= 14 only) the statements are
+// queued on the connection with libpq's pipeline mode and the server works while
+// the caller decodes the next rows: errors are only reported by sync().
+//
+// Parameters are bound by position: placeholders (:name) must appear in the
+// statement in the same order as the arguments. The pipelined parameters are
+// staged in the batch arena, which the owner resets after sync().
+class sql_writer
+{
+public:
+    sql_writer(std::shared_ptr<soci::session> session, batch_arena* arena);
+    ~sql_writer();
+
+    static bool pipeline_supported(const std::string& backend);
+    void set_pipeline(bool enabled);
+
+    template<typename... Args>
+    void exec(const std::string& sql, const Args&... args);
+
+    // The rows of a multi-row INSERT, added one at a time and written by one
+    // statement. The statement is built from a single row INSERT ... VALUES (...),
+    // with its placeholders renamed for every row.
+    class bulk
+    {
+    public:
+        explicit bulk(const std::string& insert);
+
+        // returns true when the statement is full: exec() it before adding more
+        template<typename... Args>
+        bool add(const Args&... args);
+
+        bool empty() const { return m_rows == 0; }
+        size_t size() const { return m_rows; }
+        void clear();
+
+    private:
+        friend class sql_writer;
+
+        struct value {
+            std::string value;
+            bool null = false;
+        };
+
+        const std::string& sql();
+
+        std::string m_head;                 // up to VALUES
+        std::vector<std::string> m_literals; // of the row, around its placeholders
+        std::vector<std::string> m_names;    // of the placeholders
+        size_t m_max_rows;
+        size_t m_rows = 0;
+        std::vector<value> m_values;
+        std::unordered_map<size_t, std::string> m_statements; // by number of rows
+    };
+
+    // writes the rows and clears them
+    void exec(bulk& rows);
+
+    // waits for every statement in flight. Must be called before any other use of the session.
+    void sync();
+
+private:
+    struct param {
+        param(batch_arena* arena) : value(arena), null(false) {}
+
+        arena_string value;
+        bool null;
+    };
+    using param_list = std::vector<param, arena_allocator<param>>;
+
+    template<typename P>
+    static void to_param(const std::string& value, P& p) { p.value.assign(value.data(), value.size()); }
+
+    template<typename P>
+    static void to_param(double value, P& p)
+    {
+        char buffer[32];
+        const int size = std::snprintf(buffer, sizeof(buffer), "%.17g", value);
+        p.value.assign(buffer, size);
+    }
+
+    template<typename T, typename P>
+    static typename std::enable_if<std::is_integral<T>::value>::type to_param(T value, P& p)
+    {
+        char buffer[24];
+        const int size = std::is_signed<T>::value ?
+                    std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value)) :
+                    std::snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+        p.value.assign(buffer, size);
+    }
+
+    template<typename T, typename P>
+    static void to_param(const boost::optional<T>& value, P& p)
+    {
+        p.null = !value;
+        if (value) {
+            to_param(*value, p);
+        }
+    }
+
+    void send(const std::string& sql, const param_list& params);
+    const std::string& positional(const std::string& sql);
+    void drain(bool until_sync);
+    void wait_socket();
+
+    std::shared_ptr<soci::session> m_session;
+    batch_arena* m_arena;
+    pg_conn* m_conn = nullptr;
+    bool m_pipeline = false;
+    bool m_in_pipeline = false;
+    bool m_syncing = false;
+    size_t m_in_flight = 0;
+    std::string m_error;
+    std::unordered_map<std::string, std::string> m_statements;
+};
+
+template<typename... Args>
+void sql_writer::exec(const std::string& sql, const Args&... args)
+{
+    if (!m_pipeline) {
+        auto statement = (*m_session << sql);
+        using expand = int[];
+        (void)expand{0, ((void)(statement, soci::use(args)), 0)...};
+        return; // executed when the last copy of statement goes out of scope
+    }
+
+    param_list params(m_arena);
+    params.reserve(sizeof...(Args));
+    using expand = int[];
+    (void)expand{0, (params.emplace_back(m_arena), to_param(args, params.back()), 0)...};
+    this->send(sql, params);
+}
+
+template<typename... Args>
+bool sql_writer::bulk::add(const Args&... args)
+{
+    static_assert(sizeof...(Args) > 0, "a row has values");
+    using expand = int[];
+    (void)expand{0, (m_values.emplace_back(), sql_writer::to_param(args, m_values.back()), 0)...};
+    ++m_rows;
+    return m_rows >= m_max_rows;
+}
+
+} // namespace
+
+#endif // SQL_WRITER_H
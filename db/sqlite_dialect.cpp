@@ -0,0 +1,175 @@
+#include "sqlite_dialect.h"
+
+namespace eosio {
+
+void sqlite_dialect::open(soci::session& session)
+{
+    session << "PRAGMA journal_mode = WAL";
+    session << "PRAGMA synchronous = NORMAL";
+    session << "PRAGMA cache_size = -262144"; // in KiB: 256 MiB
+    session << "PRAGMA temp_store = MEMORY";
+    session << "PRAGMA foreign_keys = ON";
+}
+
+void sqlite_dialect::disable_references(soci::session& session, const std::string&)
+{
+    session << "PRAGMA foreign_keys = OFF;";
+}
+
+void sqlite_dialect::enable_references(soci::session& session)
+{
+    session << "PRAGMA foreign_keys = ON;";
+}
+
+void sqlite_dialect::accounts::create(soci::session& session)
+{
+    session << "CREATE TABLE accounts ("
+        "name TEXT PRIMARY KEY,"
+        "abi TEXT DEFAULT NULL,"
+        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP);";
+
+    session << "CREATE TABLE accounts_keys ("
+        "account TEXT REFERENCES accounts (name),"
+        "public_key TEXT,"
+        "permission TEXT);";
+}
+
+void sqlite_dialect::blocks::create(soci::session& session)
+{
+    session << "CREATE TABLE blocks ("
+        "id TEXT PRIMARY KEY,"
+        "block_number INTEGER NOT NULL UNIQUE,"
+        "prev_block_id TEXT,"
+        "irreversible INTEGER DEFAULT 0,"
+        "timestamp DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "transaction_merkle_root TEXT,"
+        "action_merkle_root TEXT,"
+        "producer TEXT,"
+        "version INTEGER NOT NULL DEFAULT 0,"
+        "new_producers TEXT DEFAULT NULL,"
+        "num_transactions INTEGER DEFAULT 0,"
+        "confirmed INTEGER);";
+}
+
+void sqlite_dialect::transactions::create(soci::session& session)
+{
+    session << "CREATE TABLE transactions ("
+            "id TEXT PRIMARY KEY,"
+            "block_id INTEGER NOT NULL REFERENCES blocks (block_number) ON DELETE CASCADE,"
+            "ref_block_num INTEGER NOT NULL,"
+            "ref_block_prefix INTEGER,"
+            "expiration DATETIME DEFAULT CURRENT_TIMESTAMP,"
+            "pending INTEGER,"
+            "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+            "num_actions INTEGER DEFAULT 0,"
+            "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP);";
+}
+
+void sqlite_dialect::actions::create(soci::session& session)
+{
+    session << "CREATE TABLE actions ("
+            "id INTEGER PRIMARY KEY,"
+            "block_number INTEGER,"
+            "account TEXT,"
+            "receiver TEXT,"
+            "transaction_id TEXT REFERENCES transactions (id) ON DELETE CASCADE,"
+            "seq INTEGER,"
+            "parent INTEGER DEFAULT NULL," // seq of the parent action in the same transaction
+            "name TEXT,"
+            "created_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+            "data TEXT,"
+            "data_zstd BLOB," // instead of data with sql_db-compress-payloads
+            "payload_id INTEGER DEFAULT NULL);"; // instead of both with sql_db-dedup-payloads
+
+    session << "CREATE TABLE payloads ("
+            "id INTEGER PRIMARY KEY,"
+            "data TEXT,"
+            "data_zstd BLOB);";
+
+    session << "CREATE TABLE actions_accounts ("
+            "block_number INTEGER,"
+            "actor TEXT,"
+            "permission TEXT,"
+            "action_id INTEGER NOT NULL REFERENCES actions (id) ON DELETE CASCADE)";
+
+    session << "CREATE TABLE tokens ("
+            "account TEXT,"
+            "symbol TEXT,"
+            "amount REAL);"; // TODO: other tokens could have diff format.
+
+    session << "CREATE TABLE stakes("
+            "account TEXT PRIMARY KEY,"
+            "cpu REAL,"
+            "net REAL);";
+
+    session << "CREATE TABLE votes ("
+            "account TEXT PRIMARY KEY,"
+            "votes TEXT);";
+}
+
+void sqlite_dialect::block_ranges::create(soci::session& session)
+{
+    session << "CREATE TABLE block_ranges ("
+        "first_block INTEGER NOT NULL,"
+        "last_block INTEGER NOT NULL,"
+        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP);";
+
+    session << "CREATE TABLE backfill_start ("
+        "first_block INTEGER NOT NULL);";
+}
+
+void sqlite_dialect::rollups::create(soci::session& session)
+{
+    session << "CREATE TABLE rollup_blocks ("
+            "block_number INTEGER PRIMARY KEY,"
+            "transactions INTEGER,"
+            "actions INTEGER);";
+
+    session << "CREATE TABLE rollup_minutes ("
+            "minute DATETIME PRIMARY KEY,"
+            "blocks INTEGER,"
+            "transactions INTEGER,"
+            "actions INTEGER);";
+
+    session << "CREATE TABLE rollup_contracts ("
+            "account TEXT,"
+            "name TEXT,"
+            "actions INTEGER,"
+            "PRIMARY KEY (account, name));";
+
+    session << "CREATE TABLE rollup_transfers ("
+            "minute DATETIME,"
+            "contract TEXT,"
+            "symbol TEXT,"
+            "transfers INTEGER,"
+            "volume REAL,"
+            "PRIMARY KEY (minute, contract, symbol));";
+}
+
+void sqlite_dialect::abi_history::create(soci::session& session)
+{
+    session << "CREATE TABLE abi_history ("
+            "account TEXT,"
+            "block_number INTEGER,"
+            "abi_hash INTEGER,"
+            "abi TEXT,"
+            "PRIMARY KEY (account, block_number));";
+}
+
+void sqlite_dialect::action_costs::create(soci::session& session)
+{
+    session << "CREATE TABLE action_costs ("
+            "account TEXT,"
+            "name TEXT,"
+            "actions INTEGER,"
+            "skipped INTEGER,"
+            "bytes INTEGER,"
+            "abi_us INTEGER,"
+            "decode_us INTEGER,"
+            "sql_us INTEGER,"
+            "total_us INTEGER,"
+            "PRIMARY KEY (account, name));";
+}
+
+} // namespace
@@ -0,0 +1,171 @@
+#ifndef SQLITE_DIALECT_H
+#define SQLITE_DIALECT_H
+
+#include <string>
+
+#include <soci/soci.h>
+
+namespace eosio {
+
+struct sqlite_dialect
+{
+    static constexpr const char* name() { return "sqlite3"; }
+    static constexpr const char* cascade() { return ""; } // wipe() disables the foreign keys instead
+    static constexpr bool transaction_per_batch() { return true; } // a sync on every commit
+    // the index method of a column that grows with the rows, and of one only searched by equality
+    static constexpr const char* monotonic_index() { return ""; }
+    static constexpr const char* equality_index() { return ""; }
+    static constexpr bool partial_indexes() { return true; }
+
+    static void open(soci::session& session);
+    static void disable_references(soci::session& session, const std::string& schema);
+    static void enable_references(soci::session& session);
+
+    struct accounts {
+        static void create(soci::session& session);
+
+        // nothing when it is there already
+        static constexpr const char* insert()
+        {
+            return "INSERT OR IGNORE INTO accounts (name) VALUES (:na)";
+        }
+    };
+
+    struct blocks {
+        static void create(soci::session& session);
+
+        static constexpr const char* insert()
+        {
+            return "INSERT INTO blocks (id, block_number, prev_block_id, timestamp, transaction_merkle_root, action_merkle_root,"
+                "producer, version, confirmed, num_transactions) VALUES (:id, :in, :pb, DATETIME(:ti, 'unixepoch'), :tr, :ar, :pa, :ve, :pe, :nt) ON CONFLICT (block_number)"
+                " DO UPDATE SET prev_block_id=EXCLUDED.prev_block_id, timestamp=EXCLUDED.timestamp, transaction_merkle_root=EXCLUDED.transaction_merkle_root,"
+                "action_merkle_root=EXCLUDED.action_merkle_root, producer=EXCLUDED.producer, version=EXCLUDED.version, confirmed=EXCLUDED.confirmed, num_transactions=EXCLUDED.num_transactions";
+        }
+    };
+
+    struct transactions {
+        static void create(soci::session& session);
+
+        static constexpr const char* insert()
+        {
+            return "INSERT INTO transactions (id, block_id, ref_block_num, ref_block_prefix,"
+                "expiration, pending, created_at, updated_at, num_actions) VALUES (:id, :bi, :rbi, :rb, DATETIME(:ex, 'unixepoch'), :pe, DATETIME(:ca, 'unixepoch'), DATETIME(:ua, 'unixepoch'), :na)";
+        }
+    };
+
+    struct actions {
+        static void create(soci::session& session);
+
+        static constexpr const char* insert()
+        {
+            return "INSERT INTO actions (block_number, account, receiver, seq, parent, created_at, name, data, transaction_id) VALUES (:bn, :ac, :re, :se, :pa, DATETIME(:ca, 'unixepoch'), :na, :da, :ti)";
+        }
+
+        // the payload is bound as a blob
+        static constexpr const char* insert_compressed()
+        {
+            return "INSERT INTO actions (block_number, account, receiver, seq, parent, created_at, name, data_zstd, transaction_id) VALUES (:bn, :ac, :re, :se, :pa, DATETIME(:ca, 'unixepoch'), :na, :dz, :ti)";
+        }
+
+        // the payload in payloads (sql_db-dedup-payloads)
+        static constexpr const char* insert_deduplicated()
+        {
+            return "INSERT INTO actions (block_number, account, receiver, seq, parent, created_at, name, payload_id, transaction_id) VALUES (:bn, :ac, :re, :se, :pa, DATETIME(:ca, 'unixepoch'), :na, :pi, :ti)";
+        }
+
+        // nothing when it is there already: the id is the hash of the payload
+        static constexpr const char* insert_payload()
+        {
+            return "INSERT OR IGNORE INTO payloads (id, data) VALUES (:id, :da)";
+        }
+
+        static constexpr const char* insert_payload_compressed()
+        {
+            return "INSERT OR IGNORE INTO payloads (id, data_zstd) VALUES (:id, :dz)";
+        }
+
+        // written in bulk after the actions: each row finds its action by transaction and seq
+        static constexpr const char* insert_account()
+        {
+            return "INSERT INTO actions_accounts (block_number, action_id, actor, permission)"
+                " VALUES (:bn, (SELECT MAX(id) FROM actions WHERE transaction_id = :ti AND seq = :se AND block_number = :bn2), :ac, :pe)";
+        }
+
+        // a no-op when the row was already updated
+        static constexpr const char* insert_tokens()
+        {
+            return "INSERT INTO tokens (account, amount, symbol) SELECT :ac, CAST(:am AS DOUBLE PRECISION), :sy"
+                " WHERE NOT EXISTS (SELECT 1 FROM tokens WHERE account = :ac2 AND symbol = :sy2)";
+        }
+
+        static constexpr const char* upsert_stakes()
+        {
+            return "INSERT INTO stakes (account, cpu, net) VALUES (:ac, :cp, :ne) ON CONFLICT (account) DO UPDATE SET cpu=EXCLUDED.cpu, net=EXCLUDED.net";
+        }
+
+        static constexpr const char* upsert_votes()
+        {
+            return "INSERT INTO votes (account, votes) VALUES (:ac, :vo) ON CONFLICT (account) DO UPDATE SET votes=EXCLUDED.votes";
+        }
+    };
+
+    struct block_ranges {
+        static void create(soci::session& session);
+    };
+
+    struct rollups {
+        static void create(soci::session& session);
+
+        static constexpr const char* upsert_block()
+        {
+            return "INSERT INTO rollup_blocks (block_number, transactions, actions) VALUES (:bn, :tr, :ac)"
+                " ON CONFLICT (block_number) DO UPDATE SET transactions = EXCLUDED.transactions, actions = EXCLUDED.actions";
+        }
+
+        static constexpr const char* add_minute()
+        {
+            return "INSERT INTO rollup_minutes (minute, blocks, transactions, actions) VALUES (DATETIME(:mi, 'unixepoch'), :bl, :tr, :ac)"
+                " ON CONFLICT (minute) DO UPDATE SET blocks = rollup_minutes.blocks + EXCLUDED.blocks,"
+                " transactions = rollup_minutes.transactions + EXCLUDED.transactions, actions = rollup_minutes.actions + EXCLUDED.actions";
+        }
+
+        static constexpr const char* add_contract()
+        {
+            return "INSERT INTO rollup_contracts (account, name, actions) VALUES (:ac, :na, :co)"
+                " ON CONFLICT (account, name) DO UPDATE SET actions = rollup_contracts.actions + EXCLUDED.actions";
+        }
+
+        static constexpr const char* add_transfers()
+        {
+            return "INSERT INTO rollup_transfers (minute, contract, symbol, transfers, volume) VALUES (DATETIME(:mi, 'unixepoch'), :co, :sy, :tr, :vo)"
+                " ON CONFLICT (minute, contract, symbol) DO UPDATE SET transfers = rollup_transfers.transfers + EXCLUDED.transfers,"
+                " volume = rollup_transfers.volume + EXCLUDED.volume";
+        }
+    };
+
+    struct abi_history {
+        static void create(soci::session& session);
+
+        static constexpr const char* upsert()
+        {
+            return "INSERT INTO abi_history (account, block_number, abi_hash, abi) VALUES (:ac, :bn, :ha, :ab)"
+                " ON CONFLICT (account, block_number) DO UPDATE SET abi_hash = EXCLUDED.abi_hash, abi = EXCLUDED.abi";
+        }
+    };
+
+    struct action_costs {
+        static void create(soci::session& session);
+
+        // the costs of a refresh are added
+        static constexpr const char* add()
+        {
+            return "INSERT INTO action_costs (account, name, actions, skipped, bytes, abi_us, decode_us, sql_us, total_us) VALUES (:ac, :na, :co, :sk, :by, :ab, :de, :sq, :to)"
+                " ON CONFLICT (account, name) DO UPDATE SET actions = action_costs.actions + EXCLUDED.actions, skipped = action_costs.skipped + EXCLUDED.skipped, bytes = action_costs.bytes + EXCLUDED.bytes, abi_us = action_costs.abi_us + EXCLUDED.abi_us,"
+                " decode_us = action_costs.decode_us + EXCLUDED.decode_us, sql_us = action_costs.sql_us + EXCLUDED.sql_us, total_us = action_costs.total_us + EXCLUDED.total_us";
+        }
+    };
+};
+
+} // namespace
+
+#endif // SQLITE_DIALECT_H
@@ -0,0 +1,108 @@
+#include "trace_buffer.h"
+
+namespace eosio {
+
+namespace {
+// speculative traces of transactions that never made it into a block are dropped after this many blocks
+const uint64_t max_pending_age = 64;
+}
+
+void trace_buffer::add(const chain::transaction_trace_ptr& trace)
+{
+    if (!trace->receipt || trace->receipt->status != chain::transaction_receipt_header::executed) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mux);
+    // a transaction is applied again when the block that contains it arrives: the latest trace wins
+    m_pending[trace->id] = pending_trace{trace, m_seals};
+}
+
+void trace_buffer::seal(const chain::block_state_ptr& block)
+{
+    std::vector<transaction_actions> transactions;
+
+    std::lock_guard<std::mutex> lock(m_mux);
+    for (const auto& receipt : block->block->transactions) {
+        chain::transaction_id_type id;
+        if (receipt.trx.contains<chain::transaction_id_type>()) {
+            id = receipt.trx.get<chain::transaction_id_type>();
+        } else {
+            id = receipt.trx.get<chain::packed_transaction>().id();
+        }
+
+        auto it = m_pending.find(id);
+        if (it == m_pending.end()) {
+            continue;
+        }
+
+        transaction_actions trx{id, {}};
+        for (const auto& trace : it->second.trace->action_traces) {
+            flatten(trace, -1, trx.actions);
+        }
+        transactions.push_back(std::move(trx));
+        m_pending.erase(it);
+    }
+
+    m_sealed[block->id] = std::move(transactions);
+    m_sealed_order.emplace_back(m_seals, block->id);
+
+    ++m_seals;
+    while (!m_sealed_order.empty() && m_seals - m_sealed_order.front().first > m_max_sealed_age) {
+        m_sealed.erase(m_sealed_order.front().second); // a no-op once taken
+        m_sealed_order.pop_front();
+    }
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (m_seals - it->second.sealed_at > max_pending_age) {
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::vector<transaction_actions> trace_buffer::take(const chain::block_id_type& block_id)
+{
+    std::lock_guard<std::mutex> lock(m_mux);
+    auto it = m_sealed.find(block_id);
+    if (it == m_sealed.end()) {
+        return {};
+    }
+
+    auto result = std::move(it->second);
+    m_sealed.erase(it);
+    return result;
+}
+
+std::vector<transaction_actions> trace_buffer::peek(const chain::block_id_type& block_id)
+{
+    std::lock_guard<std::mutex> lock(m_mux);
+    auto it = m_sealed.find(block_id);
+    return it != m_sealed.end() ? it->second : std::vector<transaction_actions>();
+}
+
+void trace_buffer::put(const chain::block_id_type& block_id, std::vector<transaction_actions> transactions)
+{
+    std::lock_guard<std::mutex> lock(m_mux);
+    m_sealed[block_id] = std::move(transactions);
+}
+
+void trace_buffer::set_max_sealed_age(uint64_t max_age)
+{
+    std::lock_guard<std::mutex> lock(m_mux);
+    m_max_sealed_age = max_age;
+}
+
+// private
+
+void trace_buffer::flatten(const chain::action_trace& trace, int32_t parent, std::vector<executed_action>& actions)
+{
+    const auto seq = static_cast<int32_t>(actions.size());
+    actions.push_back(executed_action{trace.act, trace.receipt.receiver, parent});
+
+    for (const auto& inline_trace : trace.inline_traces) {
+        flatten(inline_trace, seq, actions);
+    }
+}
+
+} // namespace
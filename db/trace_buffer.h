@@ -0,0 +1,63 @@
+#ifndef TRACE_BUFFER_H
+#define TRACE_BUFFER_H
+
+#include <deque>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <eosio/chain/block_state.hpp>
+#include <eosio/chain/trace.hpp>
+
+namespace eosio {
+
+// one executed action, flattened out of a transaction trace in execution order
+struct executed_action {
+    chain::action act;
+    chain::account_name receiver;
+    int32_t parent; // seq of the parent action inside the same transaction, -1 for top level actions
+};
+
+struct transaction_actions {
+    chain::transaction_id_type id;
+    std::vector<executed_action> actions;
+};
+
+// Collects applied_transaction traces on the main thread and hands them, grouped
+// by block, to the consumer thread once the block has been accepted.
+class trace_buffer
+{
+public:
+    void add(const chain::transaction_trace_ptr& trace);
+    void seal(const chain::block_state_ptr& block);
+    std::vector<transaction_actions> take(const chain::block_id_type& block_id);
+    // a copy of what take() will return
+    std::vector<transaction_actions> peek(const chain::block_id_type& block_id);
+    // the actions of a block as sealed when it was captured, for a replay
+    void put(const chain::block_id_type& block_id, std::vector<transaction_actions> transactions);
+    // the blocks sealed before the last max_age ones are dropped if nothing took them:
+    // the consumer failed or stopped before their batch. At least the queue size.
+    void set_max_sealed_age(uint64_t max_age);
+
+private:
+    struct pending_trace {
+        chain::transaction_trace_ptr trace;
+        uint64_t sealed_at;
+    };
+
+    static void flatten(const chain::action_trace& trace, int32_t parent, std::vector<executed_action>& actions);
+
+    std::mutex m_mux;
+    std::map<chain::transaction_id_type, pending_trace> m_pending;
+    std::map<chain::block_id_type, std::vector<transaction_actions>> m_sealed;
+    std::deque<std::pair<uint64_t, chain::block_id_type>> m_sealed_order; // by seal, oldest first
+    uint64_t m_seals = 0;
+    uint64_t m_max_sealed_age = 10000;
+};
+
+} // namespace
+
+FC_REFLECT(eosio::executed_action, (act)(receiver)(parent))
+FC_REFLECT(eosio::transaction_actions, (id)(actions))
+
+#endif // TRACE_BUFFER_H
@@ -5,92 +5,65 @@
 
 namespace eosio {
 
-transactions_table::transactions_table(std::shared_ptr<soci::session> session):
-    m_session(session)
+template<typename Dialect>
+transactions_table<Dialect>::transactions_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer):
+    m_session(session),
+    m_writer(writer)
 {
-    backend = m_session->get_backend_name();
 }
 
-void transactions_table::drop()
+template<typename Dialect>
+void transactions_table<Dialect>::drop()
 {
+    const char* cascade = Dialect::cascade();
+
     try {
-        *m_session << "DROP TABLE IF EXISTS transactions CASCADE;";
+        *m_session << "DROP TABLE IF EXISTS transactions" << cascade;
     }
     catch(std::exception& e){
         wlog(e.what());
     }
 }
 
-void transactions_table::create()
+template<typename Dialect>
+void transactions_table<Dialect>::create(const index_options& indexes)
 {
-    if (backend == "postgresql") {
-        this->create_postgresql();
-    }
-    else if (backend == "mysql") {
-        this->create_mysql();
-    }
+    Dialect::transactions::create(*m_session);
 
     // indices
 
-    *m_session << "CREATE INDEX transactions_block_id ON transactions (block_id);";
+    const char* monotonic = indexes.append_only() ? Dialect::monotonic_index() : "";
+
+    *m_session << "CREATE INDEX transactions_block_id ON transactions" << monotonic << " (block_id);";
 
 }
 
-void transactions_table::add(uint32_t block_id, chain::transaction transaction)
+template<typename Dialect>
+void transactions_table<Dialect>::add(uint32_t block_id, const chain::transaction& transaction, const chain::transaction_id_type& transaction_id)
 {
-    const auto transaction_id_str = transaction.id().str();
+    const auto transaction_id_str = checksum_string(transaction_id);
     const auto expiration = std::chrono::seconds{transaction.expiration.sec_since_epoch()}.count();
 
-    *m_session << this->add_transaction(),
-            soci::use(transaction_id_str, "id"),
-            soci::use(block_id, "bi"),
-            soci::use(transaction.ref_block_num, "rbi"),
-            soci::use(transaction.ref_block_prefix, "rb"),
-            soci::use(expiration, "ex"),
-            soci::use(0, "pe"),
-            soci::use(expiration, "ca"),
-            soci::use(expiration, "ua"),
-            soci::use(transaction.total_actions(), "na");
+    m_writer->exec(m_insert,
+            transaction_id_str,
+            block_id,
+            transaction.ref_block_num,
+            transaction.ref_block_prefix,
+            expiration,
+            0,
+            expiration,
+            expiration,
+            transaction.total_actions());
 }
 
-void transactions_table::create_mysql()
+template<typename Dialect>
+void transactions_table<Dialect>::remove(uint32_t first_block, uint32_t last_block)
 {
-    *m_session << "CREATE TABLE transactions("
-        "id VARCHAR(64) PRIMARY KEY,"
-        "block_id INT NOT NULL,"
-        "ref_block_num INT NOT NULL,"
-        "ref_block_prefix INT,"
-        "expiration DATETIME DEFAULT NOW(),"
-        "pending TINYINT(1),"
-        "created_at DATETIME DEFAULT NOW(),"
-        "num_actions INT DEFAULT 0,"
-        "updated_at DATETIME DEFAULT NOW(), FOREIGN KEY (block_id) REFERENCES blocks(block_number) ON DELETE CASCADE) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE utf8mb4_general_ci;";
+    m_writer->exec("DELETE FROM transactions WHERE block_id BETWEEN :fi AND :la",
+            first_block,
+            last_block);
 }
 
-void transactions_table::create_postgresql()
-{
-    *m_session << "CREATE TABLE transactions ("
-            "id TEXT PRIMARY KEY,"
-            "block_id INT NOT NULL REFERENCES blocks (block_number) ON DELETE CASCADE,"
-            "ref_block_num INT NOT NULL,"
-            "ref_block_prefix INT,"
-            "expiration TIMESTAMPTZ DEFAULT NOW(),"
-            "pending INT,"
-            "created_at TIMESTAMPTZ DEFAULT NOW(),"
-            "num_actions INT DEFAULT 0,"
-            "updated_at TIMESTAMPTZ DEFAULT NOW());";
-}
-
-// transactions_table::add_transaction() defaults to MySQL syntax
-std::string transactions_table::add_transaction()
-{
-    if (backend == "postgresql") {
-        return "INSERT INTO transactions (id, block_id, ref_block_num, ref_block_prefix,"
-            "expiration, pending, created_at, updated_at, num_actions) VALUES (:id, :bi, :rbi, :rb, TO_TIMESTAMP(:ex), :pe, TO_TIMESTAMP(:ca), TO_TIMESTAMP(:ua), :na)";
-    }
-
-    return "INSERT INTO transactions(id, block_id, ref_block_num, ref_block_prefix,"
-        "expiration, pending, created_at, updated_at, num_actions) VALUES (:id, :bi, :rbi, :rb, FROM_UNIXTIME(:ex), :pe, FROM_UNIXTIME(:ca), FROM_UNIXTIME(:ua), :na)";
-}
+SQL_DB_INSTANTIATE_DIALECTS(transactions_table)
 
 } // namespace
@@ -5,25 +5,29 @@
 #include <soci/soci.h>
 #include <eosio/chain/transaction_metadata.hpp>
 
+#include "chain_strings.h"
+#include "index_options.h"
+#include "sql_dialect.h"
+#include "sql_writer.h"
+
 namespace eosio {
 
+template<typename Dialect>
 class transactions_table
 {
 public:
-    transactions_table(std::shared_ptr<soci::session> session);
+    transactions_table(std::shared_ptr<soci::session> session, std::shared_ptr<sql_writer> writer);
 
     void drop();
-    void create();
-    void add(uint32_t block_id, chain::transaction transaction);
+    void create(const index_options& indexes = index_options());
+    void add(uint32_t block_id, const chain::transaction& transaction, const chain::transaction_id_type& transaction_id);
+    // the rows of the blocks first_block - last_block
+    void remove(uint32_t first_block, uint32_t last_block);
 
 private:
     std::shared_ptr<soci::session> m_session;
-    std::string backend;
-
-    std::string add_transaction();
-
-    void create_mysql();
-    void create_postgresql();
+    std::shared_ptr<sql_writer> m_writer;
+    const std::string m_insert = Dialect::transactions::insert();
 };
 
 } // namespace
@@ -0,0 +1,36 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "consumer_core.h"
+
+namespace eosio {
+
+/**
+ * Hands every batch to several cores in turn, from the same queue and thread:
+ * e.g. the SQL database and a file export fed by one consumer.
+ */
+template<typename T>
+class fanout_core : public consumer_core<T>
+{
+public:
+    fanout_core(std::vector<std::unique_ptr<consumer_core<T>>> cores) : m_cores(std::move(cores)) {}
+
+    void consume(const std::vector<T>& elements) override
+    {
+        for (auto& core : m_cores) {
+            core->consume(elements);
+        }
+    }
+
+private:
+    std::vector<std::unique_ptr<consumer_core<T>>> m_cores;
+};
+
+} // namespace
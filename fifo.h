@@ -8,6 +8,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <chrono>
 #include <deque>
 #include <vector>
 #include <boost/noncopyable.hpp>
@@ -19,18 +20,33 @@ class fifo : public boost::noncopyable
 {
 public:
     enum class behavior {blocking, not_blocking};
+    using clock = std::chrono::steady_clock;
 
     fifo(behavior value);
 
-    void push(const T& element);
+    // size: the estimated bytes held by the element, for the byte budget of pop().
+    // Waits while the queue holds max_size elements.
+    void push(const T& element, size_t size = 0);
     std::vector<T> pop_all();
+    // Waits for one element, then for min_count of them as long as the oldest one
+    // was pushed less than max_delay ago. Pops max_count elements and max_bytes at
+    // most (0: no limit), but always one element at least.
+    std::vector<T> pop(size_t min_count, size_t max_count, size_t max_bytes, clock::duration max_delay,
+                       clock::time_point* oldest_push = nullptr, size_t* popped_bytes = nullptr);
     void set_behavior(behavior value);
+    // 0: no limit
+    void set_max_size(size_t value);
+    size_t size();
 
 private:
     std::mutex m_mux;
     std::condition_variable m_cond;
+    std::condition_variable m_not_full;
+    size_t m_max_size = 0;
     std::atomic<behavior> m_behavior;
     std::deque<T> m_deque;
+    std::deque<clock::time_point> m_pushed;
+    std::deque<size_t> m_sizes;
 };
 
 template<typename T>
@@ -40,25 +56,54 @@ fifo<T>::fifo(behavior value)
 }
 
 template<typename T>
-void fifo<T>::push(const T& element)
+void fifo<T>::push(const T& element, size_t size)
 {
-    std::lock_guard<std::mutex> lock(m_mux);
+    std::unique_lock<std::mutex> lock(m_mux);
+    m_not_full.wait(lock, [&]{return m_behavior == behavior::not_blocking || m_max_size == 0 || m_deque.size() < m_max_size;});
     m_deque.push_back(element);
+    m_pushed.push_back(clock::now());
+    m_sizes.push_back(size);
     m_cond.notify_one();
 }
 
 template<typename T>
 std::vector<T> fifo<T>::pop_all()
+{
+    return this->pop(1, 0, 0, clock::duration::zero());
+}
+
+template<typename T>
+std::vector<T> fifo<T>::pop(size_t min_count, size_t max_count, size_t max_bytes, clock::duration max_delay,
+                            clock::time_point* oldest_push, size_t* popped_bytes)
 {
     std::unique_lock<std::mutex> lock(m_mux);
     m_cond.wait(lock, [&]{return m_behavior == behavior::not_blocking || !m_deque.empty();});
 
+    if (!m_deque.empty() && m_deque.size() < min_count && max_delay > clock::duration::zero()) {
+        m_cond.wait_until(lock, m_pushed.front() + max_delay, [&]{return m_behavior == behavior::not_blocking || m_deque.size() >= min_count;});
+    }
+
+    if (oldest_push && !m_pushed.empty()) {
+        *oldest_push = m_pushed.front();
+    }
+
     std::vector<T> result;
-    while(!m_deque.empty())
+    size_t bytes = 0;
+    while(!m_deque.empty() && (max_count == 0 || result.size() < max_count))
     {
+        if (max_bytes > 0 && !result.empty() && bytes + m_sizes.front() > max_bytes) {
+            break;
+        }
+        bytes += m_sizes.front();
         result.push_back(std::move(m_deque.front()));
         m_deque.pop_front();
+        m_pushed.pop_front();
+        m_sizes.pop_front();
+    }
+    if (popped_bytes) {
+        *popped_bytes = bytes;
     }
+    m_not_full.notify_all();
     return result;
 }
 
@@ -67,6 +112,22 @@ void fifo<T>::set_behavior(behavior value)
 {
     m_behavior = value;
     m_cond.notify_all();
+    m_not_full.notify_all();
+}
+
+template<typename T>
+void fifo<T>::set_max_size(size_t value)
+{
+    std::lock_guard<std::mutex> lock(m_mux);
+    m_max_size = value;
+    m_not_full.notify_all();
+}
+
+template<typename T>
+size_t fifo<T>::size()
+{
+    std::lock_guard<std::mutex> lock(m_mux);
+    return m_deque.size();
 }
 
 } // namespace
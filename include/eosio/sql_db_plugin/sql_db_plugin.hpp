@@ -11,6 +11,9 @@
 #include <memory>
 
 #include "consumer.h"
+#include "trace_buffer.h"
+#include "history_query.h"
+#include "database.h"
 
 namespace eosio {
 
@@ -43,10 +46,22 @@ public:
     void plugin_startup();
     void plugin_shutdown();
 
+    // account and contract history for the other plugins: null when the plugin is disabled
+    std::shared_ptr<history_query> history() const;
+    // the recent spans of the traced blocks, in Chrome trace_event JSON
+    std::string block_trace() const;
+
 private:
+    std::unique_ptr<database> make_database(const variables_map& options, const std::string& uri_str);
+
     std::unique_ptr<consumer<chain::block_state_ptr>> m_block_consumer;
     fc::optional<boost::signals2::scoped_connection> m_block_connection;
 
+    std::shared_ptr<trace_buffer> m_traces;
+    fc::optional<boost::signals2::scoped_connection> m_applied_transaction_connection;
+
+    std::shared_ptr<history_query> m_history;
+
     std::unique_ptr<consumer<chain::block_state_ptr>> m_irreversible_block_consumer;
     fc::optional<boost::signals2::scoped_connection> m_irreversible_block_connection;
 };
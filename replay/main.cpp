@@ -0,0 +1,84 @@
+/**
+ *  @file
+ *  @copyright defined in eos/LICENSE.txt
+ *
+ *  Writes a block capture (sql_db-capture-file) to the SQL DB, at full speed or
+ *  at the pace it was recorded: the same workload run after run, without nodeos,
+ *  for profiling and regression benchmarks.
+ */
+#include <iostream>
+
+#include <boost/program_options.hpp>
+#include <fc/log/logger.hpp>
+
+#include "block_capture.h"
+#include "database.h"
+
+namespace bpo = boost::program_options;
+
+namespace {
+const char* SQL_DB_URI_OPTION = "sql_db-uri";
+const char* SQL_DB_SCHEMA_OPTION = "sql_db-schema";
+const char* CAPTURE_FILE_OPTION = "capture-file";
+const char* RECORDED_TIMING_OPTION = "recorded-timing";
+const char* BATCH_MAX_BLOCKS_OPTION = "batch-max-blocks";
+const char* WIPE_OPTION = "wipe";
+const char* INDEX_PROFILE_OPTION = "index-profile";
+}
+
+int main(int argc, char** argv)
+{
+    bpo::options_description cli("sql_db_replay");
+    cli.add_options()
+            ("help,h", "Print this help message and exit.")
+            (SQL_DB_URI_OPTION, bpo::value<std::string>()->required(),
+             "Sql DB URI connection string.")
+            (SQL_DB_SCHEMA_OPTION, bpo::value<std::string>()->default_value("public"),
+             "Sql DB Schema setting string"
+             " Enabled for PostgreSQL only. Defaults to 'public'")
+            (CAPTURE_FILE_OPTION, bpo::value<std::string>()->required(),
+             "The file recorded by sql_db_plugin with sql_db-capture-file.")
+            (RECORDED_TIMING_OPTION, bpo::bool_switch()->default_value(false),
+             "Hand the blocks over as they arrived during the capture instead of as fast as possible.")
+            (BATCH_MAX_BLOCKS_OPTION, bpo::value<uint32_t>()->default_value(0),
+             "The most blocks written in one batch. 0 for no limit: the whole capture at full speed.")
+            (WIPE_OPTION, bpo::bool_switch()->default_value(false),
+             "Wipe the database before starting.")
+            (INDEX_PROFILE_OPTION, bpo::value<std::string>()->default_value("btree"),
+             "The indexes created by the wipe: btree or append-only, as sql_db-index-profile.")
+            ;
+
+    try {
+        bpo::variables_map options;
+        bpo::store(bpo::parse_command_line(argc, argv, cli), options);
+        if (options.count("help")) {
+            std::cout << cli << std::endl;
+            return 0;
+        }
+        bpo::notify(options);
+
+        auto traces = std::make_shared<eosio::trace_buffer>();
+        eosio::database db(options.at(SQL_DB_URI_OPTION).as<std::string>(), 0, options.at(SQL_DB_SCHEMA_OPTION).as<std::string>(), traces);
+        eosio::index_options indexes;
+        indexes.profile = eosio::parse_index_profile(options.at(INDEX_PROFILE_OPTION).as<std::string>());
+        db.set_indexes(indexes);
+        if (options.at(WIPE_OPTION).as<bool>() || !db.is_started()) {
+            db.wipe();
+        }
+
+        eosio::block_capture_reader reader(options.at(CAPTURE_FILE_OPTION).as<std::string>());
+        const auto stats = eosio::replay_capture(reader, db, traces,
+                                                 options.at(BATCH_MAX_BLOCKS_OPTION).as<uint32_t>(),
+                                                 options.at(RECORDED_TIMING_OPTION).as<bool>());
+
+        const auto seconds = stats.elapsed.count() / 1e6;
+        ilog("replayed ${b} blocks in ${n} batches, ${s} s, ${r} blocks/s",
+             ("b", stats.blocks)("n", stats.batches)("s", seconds)("r", seconds > 0 ? stats.blocks / seconds : 0));
+        return 0;
+    } catch (const fc::exception& ex) {
+        elog("${e}", ("e", ex.to_detail_string()));
+    } catch (const std::exception& ex) {
+        elog("${e}", ("e", ex.what()));
+    }
+    return 1;
+}
@@ -5,13 +5,39 @@
  */
 #include <eosio/sql_db_plugin/sql_db_plugin.hpp>
 
+#include <algorithm>
+
+#include "block_capture.h"
+#include "block_tracer.h"
 #include "database.h"
+#include "fanout_core.h"
+#include "parquet_sink.h"
 
 namespace {
 const char* BLOCK_START_OPTION = "sql_db-block-start";
 const char* BUFFER_SIZE_OPTION = "sql_db-queue-size";
 const char* SQL_DB_URI_OPTION = "sql_db-uri";
 const char* SQL_DB_SCHEMA_OPTION = "sql_db-schema";
+const char* SQL_DB_PIPELINE_OPTION = "sql_db-pipeline";
+const char* INDEX_PROFILE_OPTION = "sql_db-index-profile";
+const char* HOT_CONTRACTS_OPTION = "sql_db-hot-contracts";
+const char* BATCH_MIN_BLOCKS_OPTION = "sql_db-batch-min-blocks";
+const char* BATCH_MAX_BLOCKS_OPTION = "sql_db-batch-max-blocks";
+const char* BATCH_MAX_DELAY_OPTION = "sql_db-batch-max-delay-ms";
+const char* BATCH_MAX_MB_OPTION = "sql_db-batch-max-mb";
+const char* COMPRESS_PAYLOADS_OPTION = "sql_db-compress-payloads";
+const char* DEDUP_PAYLOADS_OPTION = "sql_db-dedup-payloads";
+const char* PAYLOAD_CACHE_OPTION = "sql_db-payload-cache";
+const char* ACTION_COSTS_OPTION = "sql_db-action-costs-interval-s";
+const char* TOKEN_CONTRACTS_OPTION = "sql_db-token-contracts";
+const char* HISTORY_CACHE_PAGES_OPTION = "sql_db-history-cache-pages";
+const char* PARQUET_DIR_OPTION = "sql_db-parquet-dir";
+const char* PARQUET_FILE_BLOCKS_OPTION = "sql_db-parquet-file-blocks";
+const char* NOTIFY_CHANNEL_OPTION = "sql_db-notify-channel";
+const char* FEED_SOCKET_OPTION = "sql_db-feed-socket";
+const char* TRACE_EVERY_BLOCKS_OPTION = "sql_db-trace-every-blocks";
+const char* TRACE_FILE_OPTION = "sql_db-trace-file";
+const char* CAPTURE_FILE_OPTION = "sql_db-capture-file";
 const char* HARD_REPLAY_OPTION = "hard-replay-blockchain";
 const char* RESYNC_OPTION = "delete-all-blocks";
 const char* REPLAY_OPTION = "replay-blockchain";
@@ -28,8 +54,9 @@ void sql_db_plugin::set_program_options(options_description& cli, options_descri
     dlog("set_program_options");
 
     cfg.add_options()
-            (BUFFER_SIZE_OPTION, bpo::value<uint>()->default_value(256),
-             "The queue size between nodeos and SQL DB plugin thread.")
+            (BUFFER_SIZE_OPTION, bpo::value<uint>()->default_value(0),
+             "The most blocks queued between nodeos and the SQL DB plugin thread. While the queue is full nodeos waits in its "
+             "accepted block handler: block production and p2p stop until the database catches up. 0 for no limit: never waits.")
             (BLOCK_START_OPTION, bpo::value<uint32_t>()->default_value(0),
              "The block to start sync.")
             (SQL_DB_URI_OPTION, bpo::value<std::string>(),
@@ -38,6 +65,55 @@ void sql_db_plugin::set_program_options(options_description& cli, options_descri
              (SQL_DB_SCHEMA_OPTION, bpo::value<std::string>()->default_value("public"),
              "Sql DB Schema setting string"
              " Enabled for PostgreSQL only. Defaults to 'public'")
+            (SQL_DB_PIPELINE_OPTION, bpo::value<bool>()->default_value(false),
+             "Queue the writes of a batch on the connection instead of waiting for each one."
+             " Enabled for PostgreSQL with libpq >= 14 only. Errors are reported once per batch and abort the rest of it.")
+            (INDEX_PROFILE_OPTION, bpo::value<std::string>()->default_value("btree"),
+             "The indexes created with the tables: btree, or append-only for BRIN on the block ordered columns"
+             " (PostgreSQL) and no index that a history index already serves.")
+            (HOT_CONTRACTS_OPTION, bpo::value<std::vector<std::string>>()->composing(),
+             "A contract whose actions get an index of their own, by name and block, created with the tables."
+             " Can be given more than once. PostgreSQL and SQLite only.")
+            (BATCH_MIN_BLOCKS_OPTION, bpo::value<uint32_t>()->default_value(1),
+             "The blocks to wait for before writing a batch, within the delay of sql_db-batch-max-delay-ms.")
+            (BATCH_MAX_BLOCKS_OPTION, bpo::value<uint32_t>()->default_value(0),
+             "The most blocks written in one batch. 0 for no limit: everything queued is written at once.")
+            (BATCH_MAX_DELAY_OPTION, bpo::value<uint32_t>()->default_value(0),
+             "The most a block waits for the batch to reach sql_db-batch-min-blocks, in milliseconds.")
+            (BATCH_MAX_MB_OPTION, bpo::value<uint32_t>()->default_value(256),
+             "The most memory held by the blocks of one batch, in MiB. A backlog is written in several batches. 0 for no limit.")
+            (COMPRESS_PAYLOADS_OPTION, bpo::value<bool>()->default_value(false),
+             "Store the action payloads compressed with zstd, with a dictionary per contract action, in actions.data_zstd instead of actions.data."
+             " Needs the plugin built with zstd.")
+            (DEDUP_PAYLOADS_OPTION, bpo::value<bool>()->default_value(false),
+             "Store every distinct action payload once, in the payloads table, referenced by actions.payload_id instead of actions.data."
+             " A repeated payload is neither decoded nor written again.")
+            (PAYLOAD_CACHE_OPTION, bpo::value<uint32_t>()->default_value(1000000),
+             "The latest payloads remembered by sql_db-dedup-payloads: the repeats of older ones are decoded again, but still stored once.")
+            (ACTION_COSTS_OPTION, bpo::value<uint32_t>()->default_value(0),
+             "Count what the actions of each contract action cost to ingest: their number, bytes, ABI lookup, decode and SQL time."
+             " The counts are added to the action_costs table every this many seconds. 0 disables them.")
+            (TOKEN_CONTRACTS_OPTION, bpo::value<std::vector<std::string>>()->composing()->default_value({"eosio.token"}, "eosio.token"),
+             "A contract whose issue and transfer actions update the tokens table. Can be given more than once, * for any contract.")
+            (HISTORY_CACHE_PAGES_OPTION, bpo::value<uint32_t>()->default_value(1024),
+             "The pages of account and contract history kept in cache by the read API. 0 disables the cache.")
+            (PARQUET_DIR_OPTION, bpo::value<std::string>()->default_value(""),
+             "Also export the blocks, transactions and actions to Parquet files in this directory, partitioned by day."
+             " Without sql_db-uri only the files are written. Needs the plugin built with Arrow and Parquet.")
+            (PARQUET_FILE_BLOCKS_OPTION, bpo::value<uint32_t>()->default_value(7200),
+             "The most blocks in one Parquet file: a file is readable once closed.")
+            (NOTIFY_CHANNEL_OPTION, bpo::value<std::string>()->default_value(""),
+             "After each committed batch, NOTIFY this channel with the block range and the contracts and accounts it changed."
+             " Enabled for PostgreSQL only.")
+            (FEED_SOCKET_OPTION, bpo::value<std::string>()->default_value(""),
+             "Send the same notifications, one JSON line each, to the clients of a Unix socket created at this path.")
+            (TRACE_EVERY_BLOCKS_OPTION, bpo::value<uint32_t>()->default_value(0),
+             "Trace the life of one block in this many through the plugin: handler, queue, table writes and commit. 0 disables the tracing.")
+            (TRACE_FILE_OPTION, bpo::value<std::string>()->default_value(""),
+             "Write the recent block traces to this file every minute, in Chrome trace_event JSON.")
+            (CAPTURE_FILE_OPTION, bpo::value<std::string>()->default_value(""),
+             "Record the blocks reaching the plugin, with their actions and arrival times, to this file for sql_db_replay."
+             " The file is overwritten at startup.")
             ;
 }
 
@@ -45,45 +121,153 @@ void sql_db_plugin::plugin_initialize(const variables_map& options)
 {
     ilog("initialize");
     try {
-        std::string uri_str = options.at(SQL_DB_URI_OPTION).as<std::string>();
-        if (uri_str.empty())
+        std::string uri_str = options.count(SQL_DB_URI_OPTION) ? options.at(SQL_DB_URI_OPTION).as<std::string>() : std::string();
+        std::string parquet_dir = options.at(PARQUET_DIR_OPTION).as<std::string>();
+        if (uri_str.empty() && parquet_dir.empty())
         {
             wlog("db URI not specified => eosio::sql_db_plugin disabled.");
             return;
         }
-        ilog("connecting to ${u}", ("u", uri_str));
-        uint32_t block_num_start = options.at(BLOCK_START_OPTION).as<uint32_t>();
-        std::string db_schema = options.at(SQL_DB_SCHEMA_OPTION).as<std::string>();
 
-        auto db = std::make_unique<database>(uri_str, block_num_start, db_schema);
+        auto& tracer = block_tracer::instance();
+        tracer.set_sampling(options.at(TRACE_EVERY_BLOCKS_OPTION).as<uint32_t>());
+        tracer.set_output(options.at(TRACE_FILE_OPTION).as<std::string>(), std::chrono::minutes(1));
 
-        if (options.at(HARD_REPLAY_OPTION).as<bool>() ||
-                options.at(REPLAY_OPTION).as<bool>() ||
-                options.at(RESYNC_OPTION).as<bool>() ||
-                !db->is_started())
-        {
-            if (block_num_start == 0) {
-                ilog("Resync requested: wiping database");
-                if( options.at( RESYNC_OPTION ).as<bool>() ||
-                        options.at( REPLAY_OPTION ).as<bool>()) {
-                    ilog( "Resync requested: wiping database" );
-                    db->wipe();
-                }
-            }
+        std::vector<std::unique_ptr<consumer_core<chain::block_state_ptr>>> cores;
+        if (!uri_str.empty()) {
+            m_traces = std::make_shared<trace_buffer>();
+            cores.push_back(this->make_database(options, uri_str));
+        }
+        if (!parquet_dir.empty()) {
+            ilog("exporting to Parquet files in ${d}", ("d", parquet_dir));
+            cores.push_back(std::make_unique<parquet_sink>(parquet_dir, options.at(PARQUET_FILE_BLOCKS_OPTION).as<uint32_t>()));
+        }
+        const auto capture_file = options.at(CAPTURE_FILE_OPTION).as<std::string>();
+        if (!capture_file.empty()) {
+            ilog("capturing the blocks to ${f}", ("f", capture_file));
+            // first: the database takes the actions of the blocks
+            cores.insert(cores.begin(), std::make_unique<block_capture>(capture_file, m_traces));
+        }
+
+        batch_policy policy;
+        policy.min_elements = options.at(BATCH_MIN_BLOCKS_OPTION).as<uint32_t>();
+        policy.max_elements = options.at(BATCH_MAX_BLOCKS_OPTION).as<uint32_t>();
+        policy.max_delay = std::chrono::milliseconds(options.at(BATCH_MAX_DELAY_OPTION).as<uint32_t>());
+        policy.max_bytes = size_t(options.at(BATCH_MAX_MB_OPTION).as<uint32_t>()) * 1024 * 1024;
+        policy.max_queued = options.at(BUFFER_SIZE_OPTION).as<uint>();
+        if (m_traces && policy.max_queued > 0) {
+            // a batch takes the whole queue at most: twice the queue size covers the blocks in flight
+            m_traces->set_max_sealed_age(2 * policy.max_queued);
         }
 
-        m_block_consumer = std::make_unique<consumer<chain::block_state_ptr>>(std::move(db));
-        m_irreversible_block_consumer = std::make_unique<consumer<chain::block_state_ptr>>(std::move(db));
+        std::unique_ptr<consumer_core<chain::block_state_ptr>> core;
+        if (cores.size() == 1) {
+            core = std::move(cores.front());
+        } else {
+            core = std::make_unique<fanout_core<chain::block_state_ptr>>(std::move(cores));
+        }
+        m_block_consumer = std::make_unique<consumer<chain::block_state_ptr>>(std::move(core), policy, &database::estimated_size);
+        m_irreversible_block_consumer = std::make_unique<consumer<chain::block_state_ptr>>(std::move(core));
 
         chain_plugin* chain_plug = app().find_plugin<chain_plugin>();
         FC_ASSERT(chain_plug);
         auto& chain = chain_plug->chain();
         // TODO: irreversible to different queue to just find block & update flag
         //m_irreversible_block_connection.emplace(chain.irreversible_block.connect([=](const chain::block_state_ptr& b) {m_irreversible_block_consumer->push(b);}));
-        m_block_connection.emplace(chain.accepted_block.connect([=](const chain::block_state_ptr& b) {m_block_consumer->push(b);}));
+        if (m_traces) {
+            m_applied_transaction_connection.emplace(chain.applied_transaction.connect([=](const chain::transaction_trace_ptr& t) {m_traces->add(t);}));
+        }
+        m_block_connection.emplace(chain.accepted_block.connect([=](const chain::block_state_ptr& b) {
+            trace_scope span("accepted", b->block_num);
+            if (m_traces) {
+                m_traces->seal(b);
+            }
+            block_tracer::instance().enqueued(b->block_num);
+            m_block_consumer->push(b);
+        }));
     } FC_LOG_AND_RETHROW()
 }
 
+std::unique_ptr<database> sql_db_plugin::make_database(const variables_map& options, const std::string& uri_str)
+{
+    ilog("connecting to ${u}", ("u", uri_str));
+    uint32_t block_num_start = options.at(BLOCK_START_OPTION).as<uint32_t>();
+    std::string db_schema = options.at(SQL_DB_SCHEMA_OPTION).as<std::string>();
+
+    auto db = std::make_unique<database>(uri_str, block_num_start, db_schema, m_traces);
+
+    index_options indexes;
+    indexes.profile = parse_index_profile(options.at(INDEX_PROFILE_OPTION).as<std::string>());
+    if (options.count(HOT_CONTRACTS_OPTION)) {
+        indexes.hot_contracts = options.at(HOT_CONTRACTS_OPTION).as<std::vector<std::string>>();
+    }
+    db->set_indexes(indexes);
+
+    if (options.at(HARD_REPLAY_OPTION).as<bool>() ||
+            options.at(REPLAY_OPTION).as<bool>() ||
+            options.at(RESYNC_OPTION).as<bool>() ||
+            !db->is_started())
+    {
+        if (block_num_start == 0) {
+            ilog("Resync requested: wiping database");
+            if( options.at( RESYNC_OPTION ).as<bool>() ||
+                    options.at( REPLAY_OPTION ).as<bool>()) {
+                ilog( "Resync requested: wiping database" );
+                db->wipe();
+            }
+        }
+    }
+
+    if (options.at(SQL_DB_PIPELINE_OPTION).as<bool>()) {
+        db->set_pipelined_writes(true);
+    }
+    if (options.at(COMPRESS_PAYLOADS_OPTION).as<bool>()) {
+        db->set_compressed_payloads(true);
+    }
+    if (options.at(DEDUP_PAYLOADS_OPTION).as<bool>()) {
+        db->set_deduplicated_payloads(std::max(1u, options.at(PAYLOAD_CACHE_OPTION).as<uint32_t>()));
+    }
+    db->set_action_costs(std::chrono::seconds(options.at(ACTION_COSTS_OPTION).as<uint32_t>()));
+    db->set_token_contracts(options.at(TOKEN_CONTRACTS_OPTION).as<std::vector<std::string>>());
+
+    const auto notify_channel = options.at(NOTIFY_CHANNEL_OPTION).as<std::string>();
+    const auto feed_socket = options.at(FEED_SOCKET_OPTION).as<std::string>();
+    if (!notify_channel.empty() || !feed_socket.empty()) {
+        auto feed = std::make_shared<change_feed>();
+        if (!notify_channel.empty()) {
+            feed->set_notify_channel(db->session(), notify_channel);
+        }
+        if (!feed_socket.empty()) {
+            feed->set_socket(feed_socket);
+        }
+        db->set_change_feed(feed);
+    }
+
+    // the read API has its own connection: it is used from the callers' threads
+    m_history = std::make_shared<history_query>(std::make_shared<soci::session>(uri_str),
+                                                options.at(HISTORY_CACHE_PAGES_OPTION).as<uint32_t>());
+    db->set_history(m_history);
+
+    if (block_num_start == 0) {
+        const auto backfill_end = db->backfill_end();
+        if (backfill_end > 0) {
+            ilog("history backfilled up to block ${b}: resuming from the next one", ("b", backfill_end));
+            db->set_block_num_start(backfill_end + 1);
+        }
+    }
+    return db;
+}
+
+std::shared_ptr<history_query> sql_db_plugin::history() const
+{
+    return m_history;
+}
+
+std::string sql_db_plugin::block_trace() const
+{
+    return block_tracer::instance().chrome_json();
+}
+
 void sql_db_plugin::plugin_startup()
 {
     ilog("startup");
@@ -93,6 +277,7 @@ void sql_db_plugin::plugin_shutdown()
 {
     ilog("shutdown");
     m_block_connection.reset();
+    m_applied_transaction_connection.reset();
     m_irreversible_block_connection.reset();
 }
 
@@ -0,0 +1,70 @@
+#include <boost/test/unit_test.hpp>
+
+#include "abi_history.h"
+#include "sqlite_test_db.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(abi_history_test)
+
+BOOST_FIXTURE_TEST_CASE(version_in_effect_at_a_block, sqlite_memory_db)
+{
+    abi_history<sqlite_dialect> history(session, writer);
+    history.create();
+
+    // written out of order, as by a backfill
+    const auto second = history.add(N(eosio.token), 2000, R"({"version":"eosio::abi/1.1"})");
+    const auto first = history.add(N(eosio.token), 1000, R"({"version":"eosio::abi/1.0"})");
+    BOOST_TEST(first != second);
+
+    BOOST_TEST(!history.find(N(eosio.token), 999));
+    BOOST_TEST(!history.find(N(other), 5000));
+    BOOST_TEST(history.find(N(eosio.token), 1000)->hash == first);
+    BOOST_TEST(history.find(N(eosio.token), 1999)->hash == first);
+    BOOST_TEST(history.find(N(eosio.token), 2000)->hash == second);
+    BOOST_TEST(history.find(N(eosio.token), 100000)->block_num == 2000u);
+
+    // set again in the same block: the last one wins
+    const auto replaced = history.add(N(eosio.token), 2000, R"({"version":"eosio::abi/1.2"})");
+    BOOST_TEST(history.find(N(eosio.token), 2000)->hash == replaced);
+
+    // another instance reads the same versions from the table
+    writer->sync();
+    abi_history<sqlite_dialect> reloaded(session, writer);
+    BOOST_TEST(reloaded.find(N(eosio.token), 1500)->hash == first);
+    BOOST_TEST(reloaded.find(N(eosio.token), 2500)->hash == replaced);
+    BOOST_TEST(reloaded.get(N(eosio.token), 2000) == R"({"version":"eosio::abi/1.2"})");
+}
+
+BOOST_FIXTURE_TEST_CASE(version_added_by_another_writer, sqlite_memory_db)
+{
+    // two backfill workers: the second one writes an older block after the first one looked it up
+    abi_history<sqlite_dialect> first(session, writer);
+    abi_history<sqlite_dialect> second(session, writer);
+    first.create();
+
+    BOOST_TEST(!first.find(N(eosio.token), 1500));
+    const auto hash = second.add(N(eosio.token), 1000, R"({"version":"eosio::abi/1.0"})");
+    writer->sync();
+
+    BOOST_TEST(!first.find(N(eosio.token), 1500)); // not read again
+    first.reload();
+    BOOST_TEST(first.find(N(eosio.token), 1500)->hash == hash);
+    BOOST_TEST(!first.find(N(other), 1500));
+}
+
+BOOST_FIXTURE_TEST_CASE(rollback_forgets_the_versions_of_the_batch, sqlite_memory_db)
+{
+    abi_history<sqlite_dialect> history(session, writer);
+    history.create();
+    {
+        soci::transaction batch(*session);
+        history.add(N(eosio.token), 1000, R"({"version":"eosio::abi/1.0"})");
+        writer->sync();
+        batch.rollback();
+    }
+    history.rollback();
+    BOOST_TEST(!history.find(N(eosio.token), 1500));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,223 @@
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <functional>
+
+#include "abi_json_writer.h"
+#include "native_actions.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(abi_json_writer_test)
+
+const fc::microseconds max_time(1000000);
+
+const char* test_abi = R"=====({
+    "version": "eosio::abi/1.0",
+    "types": [{"new_type_name": "account", "type": "name"}],
+    "structs": [
+        {"name": "base", "base": "", "fields": [{"name": "from", "type": "account"}]},
+        {"name": "transfer", "base": "base", "fields": [
+            {"name": "to", "type": "account_name"},
+            {"name": "quantity", "type": "asset"},
+            {"name": "memo", "type": "string"}
+        ]},
+        {"name": "item", "base": "", "fields": [{"name": "key", "type": "uint64"}, {"name": "value", "type": "int64"}]},
+        {"name": "mixed", "base": "", "fields": [
+            {"name": "flag", "type": "bool"},
+            {"name": "items", "type": "item[]"},
+            {"name": "maybe", "type": "item?"},
+            {"name": "numbers", "type": "uint32[]"},
+            {"name": "small", "type": "uint8[]"},
+            {"name": "blob", "type": "bytes"},
+            {"name": "hash", "type": "checksum256"},
+            {"name": "when", "type": "time_point_sec"},
+            {"name": "ratio", "type": "float64"}
+        ]}
+    ],
+    "actions": [
+        {"name": "transfer", "type": "transfer", "ricardian_contract": ""},
+        {"name": "mixed", "type": "mixed", "ricardian_contract": ""}
+    ],
+    "tables": []
+})=====";
+
+void check_same_json(const char* action, const char* json)
+{
+    const auto abi = fc::json::from_string(test_abi).as<chain::abi_def>();
+    chain::abi_serializer serializer(abi, max_time);
+    abi_json_writer writer(abi, serializer, max_time);
+
+    const auto data = serializer.variant_to_binary(action, fc::json::from_string(json), max_time);
+    decoded_action decoded;
+    writer.write(chain::action_name(action), data, decoded);
+
+    BOOST_TEST(decoded.json == fc::json::to_string(serializer.binary_to_variant(action, data, max_time)));
+    BOOST_TEST(!decoded.variant);
+}
+
+BOOST_AUTO_TEST_CASE(transfer_same_as_abi_serializer)
+{
+    check_same_json("transfer", R"({"from": "alice", "to": "bob.x", "quantity": "1.0000 EOS", "memo": "plain memo"})");
+    check_same_json("transfer", R"({"from": "alice", "to": "bob", "quantity": "-0.0001 SYS", "memo": "quote \" backslash \\ tab \t é"})");
+}
+
+BOOST_AUTO_TEST_CASE(nested_types_same_as_abi_serializer)
+{
+    check_same_json("mixed", R"({"flag": true, "items": [{"key": 1, "value": -1}, {"key": "18446744073709551615", "value": "-9223372036854775808"}],
+        "maybe": {"key": 4294967296, "value": 4294967295}, "numbers": [0, 4294967295], "small": [1, 2, 255], "blob": "00ff10",
+        "hash": "0102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f20", "when": "2018-06-01T12:00:00", "ratio": 0.1})");
+    check_same_json("mixed", R"({"flag": false, "items": [], "maybe": null, "numbers": [], "small": [], "blob": "",
+        "hash": "0000000000000000000000000000000000000000000000000000000000000000", "when": "1970-01-01T00:00:00", "ratio": -2.5})");
+}
+
+BOOST_AUTO_TEST_CASE(top_level_fields)
+{
+    const auto abi = fc::json::from_string(test_abi).as<chain::abi_def>();
+    chain::abi_serializer serializer(abi, max_time);
+    abi_json_writer writer(abi, serializer, max_time);
+
+    const auto data = serializer.variant_to_binary("transfer",
+            fc::json::from_string(R"({"from": "alice", "to": "bob", "quantity": "2.5000 EOS", "memo": ""})"), max_time);
+    decoded_action decoded;
+    writer.write(N(transfer), data, decoded);
+
+    BOOST_TEST(decoded.as<chain::name>("from") == N(alice));
+    BOOST_TEST(decoded.as<chain::name>("to") == N(bob));
+    BOOST_TEST(decoded.as<chain::asset>("quantity").to_string() == "2.5000 EOS");
+    BOOST_TEST(decoded.json_of("memo") == "\"\"");
+    BOOST_CHECK_THROW(decoded.json_of("missing"), fc::exception);
+}
+
+BOOST_AUTO_TEST_CASE(truncated_payload_throws_as_abi_serializer)
+{
+    const auto abi = fc::json::from_string(test_abi).as<chain::abi_def>();
+    chain::abi_serializer serializer(abi, max_time);
+    abi_json_writer writer(abi, serializer, max_time);
+
+    decoded_action decoded;
+    BOOST_CHECK_THROW(writer.write(N(transfer), chain::bytes{'a', 'b'}, decoded), fc::exception);
+}
+
+BOOST_AUTO_TEST_CASE(deadline_as_abi_serializer)
+{
+    const auto abi = fc::json::from_string(test_abi).as<chain::abi_def>();
+    chain::abi_serializer serializer(abi, max_time);
+    abi_json_writer writer(abi, serializer, fc::microseconds(0));
+
+    const auto data = serializer.variant_to_binary("transfer",
+            fc::json::from_string(R"({"from": "alice", "to": "bob", "quantity": "1.0000 EOS", "memo": "m"})"), max_time);
+    decoded_action decoded;
+    BOOST_CHECK_THROW(writer.write(N(transfer), data, decoded), chain::abi_serialization_deadline_exception);
+}
+
+BOOST_AUTO_TEST_CASE(layout_selects_the_typed_decoder)
+{
+    const auto abi = fc::json::from_string(test_abi).as<chain::abi_def>();
+    chain::abi_serializer serializer(abi, max_time);
+    abi_json_writer writer(abi, serializer, max_time);
+
+    // the typedef and the alias of name, the base struct: same layout as eosio.token
+    BOOST_TEST(writer.layout(N(transfer)) == token_transfer::layout());
+    BOOST_TEST(writer.layout(N(mixed)).find("items:item[],maybe:item?,") != std::string::npos);
+    BOOST_TEST(writer.layout(N(issue)).empty());
+
+    const auto data = serializer.variant_to_binary("transfer",
+            fc::json::from_string(R"({"from": "alice", "to": "bob", "quantity": "1.0000 EOS", "memo": "m"})"), max_time);
+    decoded_action decoded;
+    writer.write(N(transfer), data, decoded);
+
+    const auto native = fc::raw::unpack<token_transfer>(data);
+    const auto generic = token_transfer::from_decoded(decoded);
+    BOOST_TEST(native.from == generic.from);
+    BOOST_TEST(native.to == generic.to);
+    BOOST_TEST(native.quantity == generic.quantity);
+}
+
+// Actions decoded per second by abi_json_writer and by binary_to_variant + to_string,
+// run with --run_test=abi_json_writer_test/throughput_benchmark.
+BOOST_AUTO_TEST_CASE(throughput_benchmark, * boost::unit_test::disabled())
+{
+    using clock = std::chrono::steady_clock;
+
+    const auto abi = fc::json::from_string(test_abi).as<chain::abi_def>();
+    chain::abi_serializer serializer(abi, max_time);
+    abi_json_writer writer(abi, serializer, max_time);
+
+    const std::pair<const char*, const char*> payloads[] = {
+        {"transfer", R"({"from": "alice", "to": "bob", "quantity": "1.0000 EOS", "memo": "a memo of a few words"})"},
+        {"mixed", R"({"flag": true, "items": [{"key": 1, "value": -1}, {"key": 2, "value": 3}, {"key": 4, "value": 5}],
+            "maybe": {"key": 6, "value": 7}, "numbers": [0, 1, 2, 3, 4, 5, 6, 7], "small": [1, 2, 255], "blob": "00ff10",
+            "hash": "0102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f20", "when": "2018-06-01T12:00:00", "ratio": 0.1})"}
+    };
+    const int iterations = 100000;
+
+    for (const auto& payload : payloads) {
+        const auto data = serializer.variant_to_binary(payload.first, fc::json::from_string(payload.second), max_time);
+        decoded_action decoded;
+        size_t bytes = 0;
+
+        auto start = clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            writer.write(chain::action_name(payload.first), data, decoded);
+            bytes += decoded.json.size();
+        }
+        const auto direct = std::chrono::duration<double>(clock::now() - start).count();
+
+        start = clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            bytes -= fc::json::to_string(serializer.binary_to_variant(payload.first, data, max_time)).size();
+        }
+        const auto generic = std::chrono::duration<double>(clock::now() - start).count();
+
+        BOOST_TEST(bytes == 0u); // the same JSON
+        BOOST_TEST_MESSAGE(payload.first << ": " << static_cast<int>(iterations / direct) << " actions/s direct, "
+                           << static_cast<int>(iterations / generic) << " actions/s with binary_to_variant + to_string");
+    }
+}
+
+// What a transfer handler costs per action, run with
+// --run_test=abi_json_writer_test/handler_decode_benchmark:
+//   decoded: the payload decoded to JSON, the fields read from it (generic handler)
+//   decoded + native: the payload decoded to JSON for actions.data, the struct unpacked (native handler)
+//   native: the payload already stored, only the struct unpacked (no decode)
+BOOST_AUTO_TEST_CASE(handler_decode_benchmark, * boost::unit_test::disabled())
+{
+    using clock = std::chrono::steady_clock;
+
+    const auto abi = fc::json::from_string(test_abi).as<chain::abi_def>();
+    chain::abi_serializer serializer(abi, max_time);
+    abi_json_writer writer(abi, serializer, max_time);
+
+    const auto data = serializer.variant_to_binary("transfer",
+            fc::json::from_string(R"({"from": "alice", "to": "bob", "quantity": "1.0000 EOS", "memo": "a memo of a few words"})"), max_time);
+    const int iterations = 1000000;
+    decoded_action decoded;
+    int64_t total = 0;
+
+    auto per_action = [&](const std::function<void()>& handler) {
+        const auto start = clock::now();
+        for (int i = 0; i < iterations; ++i) {
+            handler();
+        }
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count() / iterations;
+    };
+
+    const auto generic = per_action([&]{
+        writer.write(N(transfer), data, decoded);
+        total += token_transfer::from_decoded(decoded).quantity.get_amount();
+    });
+    const auto decoded_native = per_action([&]{
+        writer.write(N(transfer), data, decoded);
+        total += fc::raw::unpack<token_transfer>(data).quantity.get_amount();
+    });
+    const auto native = per_action([&]{
+        total += fc::raw::unpack<token_transfer>(data).quantity.get_amount();
+    });
+
+    BOOST_TEST(total == 3LL * iterations * 10000);
+    BOOST_TEST_MESSAGE("transfer handler: " << generic << " ns decoded, " << decoded_native << " ns decoded + native, "
+                       << native << " ns native");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,61 @@
+#include <boost/test/unit_test.hpp>
+
+#include "account_set.h"
+#include "sqlite_test_db.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(account_set_test)
+
+BOOST_FIXTURE_TEST_CASE(missing_accounts_are_added_once, sqlite_memory_db)
+{
+    sqlite_dialect::accounts::create(*session);
+    *session << "INSERT INTO accounts (name) VALUES ('eosio')";
+
+    account_set<sqlite_dialect> accounts(session, writer);
+    BOOST_TEST(accounts.contains(N(eosio)));
+    BOOST_TEST(!accounts.contains(N(alice)));
+
+    // created before the first block written
+    accounts.add(N(alice));
+    accounts.add(N(alice));
+    accounts.add(N(eosio));
+    writer->sync();
+
+    long long count = 0;
+    *session << "SELECT COUNT(*) FROM accounts", soci::into(count);
+    BOOST_TEST(count == 2);
+    BOOST_TEST(accounts.size() == 2u);
+
+    // the table is read again after a wipe
+    *session << "DELETE FROM accounts WHERE name = 'alice'";
+    accounts.reset();
+    BOOST_TEST(!accounts.contains(N(alice)));
+}
+
+BOOST_FIXTURE_TEST_CASE(rollback_adds_the_accounts_of_the_batch_again, sqlite_memory_db)
+{
+    sqlite_dialect::accounts::create(*session);
+    account_set<sqlite_dialect> accounts(session, writer);
+    accounts.add(N(eosio));
+    writer->sync();
+    accounts.commit();
+
+    {
+        soci::transaction batch(*session);
+        accounts.add(N(alice));
+        writer->sync();
+        batch.rollback();
+    }
+    accounts.rollback();
+    BOOST_TEST(accounts.contains(N(eosio)));
+    BOOST_TEST(!accounts.contains(N(alice)));
+
+    accounts.add(N(alice));
+    writer->sync();
+    long long count = 0;
+    *session << "SELECT COUNT(*) FROM accounts WHERE name = 'alice'", soci::into(count);
+    BOOST_TEST(count == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
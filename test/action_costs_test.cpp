@@ -0,0 +1,53 @@
+#include <boost/test/unit_test.hpp>
+
+#include "action_costs_table.h"
+#include "sqlite_test_db.h"
+
+using namespace eosio;
+using std::chrono::microseconds;
+
+BOOST_AUTO_TEST_SUITE(action_costs_test)
+
+BOOST_FIXTURE_TEST_CASE(costs_are_added_every_refresh, sqlite_memory_db)
+{
+    action_costs_table<sqlite_dialect> costs(session, writer);
+    costs.create();
+    costs.set_refresh(std::chrono::seconds(3600));
+
+    costs.add(N(eosio.token), N(transfer), 30, microseconds(1), microseconds(5), microseconds(10));
+    costs.add(N(eosio.token), N(transfer), 34, microseconds(1), microseconds(5), microseconds(10));
+    costs.add(N(nested), N(exec), 2000, microseconds(2), microseconds(400), microseconds(20));
+    BOOST_TEST(costs.pending().size() == 2u);
+
+    costs.flush(); // not due
+    BOOST_TEST(costs.pending().size() == 2u);
+    costs.flush(true);
+    BOOST_TEST(costs.pending().empty());
+
+    costs.add(N(eosio.token), N(transfer), 30, microseconds(1), microseconds(5), microseconds(10));
+    costs.add_skipped(N(noabi), N(any), microseconds(7));
+    costs.flush(true);
+    writer->sync();
+
+    std::string account;
+    long long actions = 0, bytes = 0, total = 0;
+    *session << "SELECT account, actions, bytes, total_us FROM action_costs ORDER BY total_us DESC LIMIT 1",
+            soci::into(account), soci::into(actions), soci::into(bytes), soci::into(total);
+    BOOST_TEST(account == "nested");
+    BOOST_TEST(total == 422);
+
+    *session << "SELECT actions, bytes, total_us FROM action_costs WHERE account = 'eosio.token' AND name = 'transfer'",
+            soci::into(actions), soci::into(bytes), soci::into(total);
+    BOOST_TEST(actions == 3);
+    BOOST_TEST(bytes == 94);
+    BOOST_TEST(total == 48);
+
+    long long skipped = 0;
+    *session << "SELECT actions, skipped, total_us FROM action_costs WHERE account = 'noabi'",
+            soci::into(actions), soci::into(skipped), soci::into(total);
+    BOOST_TEST(actions == 0);
+    BOOST_TEST(skipped == 1);
+    BOOST_TEST(total == 7);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,61 @@
+#include <boost/test/unit_test.hpp>
+
+#include "action_handlers.h"
+
+using namespace eosio;
+
+namespace {
+
+action_handlers::handler counting(int& calls)
+{
+    return {{}, false, [&calls](const chain::action&, const decoded_action&){ calls++; }};
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(action_handlers_test)
+
+BOOST_AUTO_TEST_CASE(dispatch_by_contract_and_action)
+{
+    action_handlers handlers;
+    BOOST_CHECK(handlers.empty());
+
+    int transfers = 0;
+    int issues = 0;
+    handlers.add(N(eosio.token), N(transfer), counting(transfers));
+    handlers.add(N(eosio.token), N(issue), counting(issues));
+
+    BOOST_CHECK(!handlers.find(N(fake.token), N(transfer)));
+    BOOST_CHECK(!handlers.find(N(eosio.token), N(retire)));
+
+    const auto handler = handlers.find(N(eosio.token), N(transfer));
+    BOOST_REQUIRE(handler);
+    handler->run(chain::action(), decoded_action());
+    BOOST_CHECK_EQUAL(transfers, 1);
+    BOOST_CHECK_EQUAL(issues, 0);
+
+    handlers.remove(N(eosio.token), N(transfer));
+    BOOST_CHECK(!handlers.find(N(eosio.token), N(transfer)));
+    BOOST_CHECK(handlers.find(N(eosio.token), N(issue)));
+}
+
+BOOST_AUTO_TEST_CASE(any_contract_is_the_fallback)
+{
+    action_handlers handlers;
+    int own = 0;
+    int any = 0;
+    handlers.add(N(eosio.token), N(transfer), counting(own));
+    handlers.add(chain::name(action_handlers::any_contract), N(transfer), counting(any));
+
+    handlers.find(N(eosio.token), N(transfer))->run(chain::action(), decoded_action());
+    handlers.find(N(fake.token), N(transfer))->run(chain::action(), decoded_action());
+    BOOST_CHECK_EQUAL(own, 1);
+    BOOST_CHECK_EQUAL(any, 1);
+
+    // registered twice: still removed by one call
+    handlers.add(chain::name(action_handlers::any_contract), N(transfer), counting(any));
+    handlers.remove(chain::name(action_handlers::any_contract), N(transfer));
+    BOOST_CHECK(!handlers.find(N(fake.token), N(transfer)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
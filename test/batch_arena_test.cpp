@@ -0,0 +1,157 @@
+#include <boost/test/unit_test.hpp>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "batch_arena.h"
+
+using namespace eosio;
+
+namespace {
+
+// std::allocator counting its allocations, for the containers compared with the arena
+size_t heap_allocations = 0;
+
+template<typename T>
+struct counting_allocator : std::allocator<T> {
+    template<typename U>
+    struct rebind {
+        using other = counting_allocator<U>;
+    };
+
+    counting_allocator() = default;
+    template<typename U>
+    counting_allocator(const counting_allocator<U>&) {}
+
+    T* allocate(size_t n)
+    {
+        ++heap_allocations;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+template<typename T, typename U>
+bool operator==(const counting_allocator<T>&, const counting_allocator<U>&) { return true; }
+template<typename T, typename U>
+bool operator!=(const counting_allocator<T>&, const counting_allocator<U>&) { return false; }
+
+using counted_string = std::basic_string<char, std::char_traits<char>, counting_allocator<char>>;
+
+}
+
+BOOST_AUTO_TEST_SUITE(batch_arena_test)
+
+BOOST_AUTO_TEST_CASE(reset_reuses_memory)
+{
+    batch_arena arena(1024);
+    void* first = arena.allocate(16, 8);
+    arena.allocate(16, 8);
+    arena.reset();
+    BOOST_TEST(arena.allocate(16, 8) == first);
+    BOOST_TEST(arena.upstream_allocations() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(allocations_are_aligned)
+{
+    batch_arena arena(1024);
+    arena.allocate(1, 1);
+    void* p = arena.allocate(8, 8);
+    BOOST_TEST(reinterpret_cast<uintptr_t>(p) % 8 == 0);
+}
+
+BOOST_AUTO_TEST_CASE(allocation_larger_than_block)
+{
+    batch_arena arena(64);
+    char* p = static_cast<char*>(arena.allocate(1000, 1));
+    std::fill(p, p + 1000, 'x');
+    BOOST_TEST(arena.upstream_allocations() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(steady_batches_do_not_allocate)
+{
+    batch_arena arena(4096);
+    auto batch = [&arena]{
+        std::map<int, arena_string, std::less<int>, arena_allocator<std::pair<const int, arena_string>>> rows(&arena);
+        for (int i = 0; i < 1000; ++i) {
+            rows.emplace(i, arena_string("a row longer than the small string buffer", &arena));
+        }
+        BOOST_TEST(rows.size() == 1000);
+    };
+
+    batch();
+    arena.reset();
+    const auto warm = arena.upstream_allocations();
+    BOOST_TEST(warm > 0);
+
+    for (int i = 0; i < 10; ++i) {
+        batch();
+        arena.reset();
+    }
+    BOOST_TEST(arena.upstream_allocations() == warm);
+}
+
+// Heap allocations per batch of what the arena holds: the parameters staged by
+// sql_writer and the map from transaction id to executed actions. The statements
+// soci binds and the JSON of the payloads are not in it. Run with
+// --run_test=batch_arena_test/allocation_benchmark.
+BOOST_AUTO_TEST_CASE(allocation_benchmark, * boost::unit_test::disabled())
+{
+    const int batches = 100;
+    const int transactions = 1000;
+    const int params_per_row = 8;
+    const std::string param = "a text parameter longer than the small string buffer";
+
+    auto heap_batch = [&]{
+        std::map<counted_string, const void*, std::less<counted_string>, counting_allocator<std::pair<const counted_string, const void*>>> executed;
+        std::vector<std::vector<counted_string, counting_allocator<counted_string>>, counting_allocator<std::vector<counted_string, counting_allocator<counted_string>>>> rows;
+        for (int i = 0; i < transactions; ++i) {
+            counted_string id(param.c_str());
+            id += std::to_string(i).c_str();
+            executed[id] = nullptr;
+            std::vector<counted_string, counting_allocator<counted_string>> params;
+            for (int j = 0; j < params_per_row; ++j) {
+                params.emplace_back(param.c_str());
+            }
+            rows.push_back(std::move(params));
+        }
+    };
+
+    batch_arena arena;
+    auto arena_batch = [&]{
+        std::map<arena_string, const void*, std::less<arena_string>, arena_allocator<std::pair<const arena_string, const void*>>> executed(&arena);
+        std::vector<std::vector<arena_string, arena_allocator<arena_string>>, arena_allocator<std::vector<arena_string, arena_allocator<arena_string>>>> rows(&arena);
+        for (int i = 0; i < transactions; ++i) {
+            arena_string id(param.c_str(), &arena);
+            id += std::to_string(i).c_str();
+            executed.emplace(std::move(id), nullptr);
+            std::vector<arena_string, arena_allocator<arena_string>> params(&arena);
+            for (int j = 0; j < params_per_row; ++j) {
+                params.emplace_back(param.c_str(), &arena);
+            }
+            rows.push_back(std::move(params));
+        }
+        arena.reset();
+    };
+    arena_batch(); // warm-up: the arena grows to the size of a batch
+
+    heap_allocations = 0;
+    for (int i = 0; i < batches; ++i) {
+        heap_batch();
+    }
+    const auto heap = heap_allocations / batches;
+
+    const auto warm = arena.upstream_allocations();
+    for (int i = 0; i < batches; ++i) {
+        arena_batch();
+    }
+    const auto arena_allocations = (arena.upstream_allocations() - warm) / batches;
+
+    BOOST_TEST_MESSAGE("heap allocations per batch of " << transactions << " rows: " << heap
+                       << " with std::allocator, " << arena_allocations << " with the arena");
+    BOOST_TEST(arena_allocations < heap);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
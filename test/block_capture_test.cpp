@@ -0,0 +1,83 @@
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include "block_capture.h"
+#include "test_blocks.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(block_capture_test)
+
+namespace {
+
+struct counting_core : public consumer_core<chain::block_state_ptr> {
+    void consume(const std::vector<chain::block_state_ptr>& blocks) override
+    {
+        batches.push_back(blocks.size());
+        for (const auto& block : blocks) {
+            block_nums.push_back(block->block_num);
+        }
+    }
+
+    std::vector<size_t> batches;
+    std::vector<uint32_t> block_nums;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(replay_the_captured_blocks_and_actions)
+{
+    const auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    auto traces = std::make_shared<trace_buffer>();
+
+    const auto first = make_block(10);
+    transaction_actions transaction{fc::sha256::hash(std::string("trx")), {}};
+    transaction.actions.push_back(executed_action{chain::action(), N(alice), -1});
+    traces->put(first->id, {transaction});
+    {
+        block_capture capture(path, traces);
+        capture.consume({first});
+        capture.consume({make_block(11), make_block(12)});
+    }
+    BOOST_TEST(traces->take(first->id).size() == 1u); // left for the database
+
+    block_capture_reader reader(path);
+    captured_block captured;
+    BOOST_REQUIRE(reader.next(captured));
+    BOOST_TEST(captured.block->block_num == 10u);
+    BOOST_TEST(captured.block->id == first->id);
+    BOOST_REQUIRE(captured.actions.size() == 1u);
+    BOOST_TEST(captured.actions[0].actions[0].receiver == N(alice));
+    BOOST_TEST(captured.actions[0].actions[0].parent == -1);
+
+    reader.rewind();
+    auto replay_traces = std::make_shared<trace_buffer>();
+    counting_core core;
+    const auto stats = replay_capture(reader, core, replay_traces, 2, false);
+    BOOST_TEST(stats.blocks == 3u);
+    BOOST_TEST(core.batches == std::vector<size_t>({2, 1}), boost::test_tools::per_element());
+    BOOST_TEST(core.block_nums == std::vector<uint32_t>({10, 11, 12}), boost::test_tools::per_element());
+    BOOST_TEST(replay_traces->take(first->id).size() == 1u);
+
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_CASE(a_truncated_record_ends_the_capture)
+{
+    const auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    {
+        block_capture capture(path, nullptr);
+        capture.consume({make_block(1), make_block(2)});
+    }
+    boost::filesystem::resize_file(path, boost::filesystem::file_size(path) - 1);
+
+    block_capture_reader reader(path);
+    captured_block captured;
+    BOOST_TEST(reader.next(captured));
+    BOOST_TEST(!reader.next(captured));
+
+    boost::filesystem::remove(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
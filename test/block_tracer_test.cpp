@@ -0,0 +1,67 @@
+#include <boost/test/unit_test.hpp>
+
+#include <thread>
+
+#include "block_tracer.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(block_tracer_test)
+
+size_t count(const std::string& json, const std::string& what)
+{
+    size_t n = 0;
+    for (auto pos = json.find(what); pos != std::string::npos; pos = json.find(what, pos + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+BOOST_AUTO_TEST_CASE(only_sampled_blocks_are_traced)
+{
+    auto& tracer = block_tracer::instance();
+    tracer.set_sampling(10);
+    for (uint32_t block_num = 1000; block_num < 1100; ++block_num) {
+        trace_scope span("sampled_test", block_num);
+    }
+    tracer.set_sampling(0);
+    {
+        trace_scope span("sampled_test", 2000);
+    }
+
+    const auto json = tracer.chrome_json();
+    BOOST_TEST(count(json, "\"sampled_test\"") == 10);
+    BOOST_TEST(count(json, "\"block\":1010}") == 1);
+    BOOST_TEST(count(json, "\"block\":1011}") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(queue_span_from_enqueued_to_dequeued)
+{
+    auto& tracer = block_tracer::instance();
+    tracer.set_sampling(1);
+    tracer.enqueued(77);
+    std::thread consumer([&]{ tracer.dequeued(77); });
+    consumer.join();
+    tracer.dequeued(77); // once only
+    tracer.set_sampling(0);
+
+    BOOST_TEST(count(tracer.chrome_json(), "\"name\":\"queued\",\"cat\":\"block\",\"ph\":\"X\"") == 1);
+}
+
+BOOST_AUTO_TEST_CASE(ring_keeps_the_latest_spans)
+{
+    auto& tracer = block_tracer::instance();
+    std::thread writer([&]{
+        for (size_t i = 0; i < block_tracer::ring_size + 100; ++i) {
+            tracer.record("ring_test", i, 0, 1);
+        }
+    });
+    writer.join();
+
+    const auto json = tracer.chrome_json();
+    BOOST_TEST(count(json, "\"ring_test\"") == block_tracer::ring_size);
+    BOOST_TEST(count(json, "\"block\":99}") == 0);
+    BOOST_TEST(count(json, "\"block\":100}") == 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,59 @@
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+#include <fc/crypto/sha256.hpp>
+
+#include "chain_strings.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(chain_strings_test)
+
+BOOST_AUTO_TEST_CASE(name_string_same_as_to_string)
+{
+    BOOST_TEST(name_string(0) == chain::name(0).to_string());
+    BOOST_TEST(name_string(N(eosio.token)) == "eosio.token");
+    BOOST_TEST(name_string(N(a.b.c)) == "a.b.c");
+    BOOST_TEST(name_string(~uint64_t(0)) == chain::name(~uint64_t(0)).to_string());
+
+    std::mt19937_64 random(42);
+    for (int i = 0; i < 100000; ++i) {
+        const uint64_t value = random();
+        BOOST_TEST(name_string(value) == chain::name(value).to_string());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(checksum_string_same_as_str)
+{
+    const auto empty = fc::sha256();
+    BOOST_TEST(checksum_string(empty) == empty.str());
+
+    const auto hash = fc::sha256::hash(std::string("eosio"));
+    BOOST_TEST(checksum_string(hash) == hash.str());
+}
+
+BOOST_AUTO_TEST_CASE(hex_string_reuses_buffer)
+{
+    std::string out;
+    const char data[] = {0x00, 0x7f, static_cast<char>(0x80), static_cast<char>(0xff)};
+    hex_string(data, sizeof(data), out);
+    BOOST_TEST(out == "007f80ff");
+    hex_string(data, 1, out);
+    BOOST_TEST(out == "00");
+}
+
+BOOST_AUTO_TEST_CASE(name_cache_returns_the_same_text)
+{
+    name_cache names;
+    const auto& first = names.get(N(transfer));
+    const auto& second = names.get(N(transfer));
+    BOOST_TEST(first == "transfer");
+    BOOST_TEST(&first == &second);
+    BOOST_TEST(names.size() == 1);
+
+    names.clear();
+    BOOST_TEST(names.size() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,100 @@
+#include <boost/test/unit_test.hpp>
+
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "change_feed.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(change_feed_test)
+
+int connect_to(const std::string& path)
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    BOOST_REQUIRE(connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+    return fd;
+}
+
+std::string read_line(int fd)
+{
+    std::string line;
+    char c;
+    while (recv(fd, &c, 1, 0) == 1 && c != '\n') {
+        line += c;
+    }
+    return line;
+}
+
+BOOST_AUTO_TEST_CASE(socket_clients_get_a_line_per_batch)
+{
+    const std::string path = "/tmp/sql_db_change_feed_test.sock";
+    change_feed feed;
+    feed.set_socket(path);
+    const int client = connect_to(path);
+
+    chain::action transfer;
+    transfer.account = N(eosio.token);
+    transfer.name = N(transfer);
+    transfer.authorization.push_back(chain::permission_level{N(alice), N(active)});
+
+    feed.add_block(11);
+    feed.add_block(10);
+    feed.add_action(transfer, N(eosio.token));
+    feed.add_action(transfer, N(bob));
+    feed.publish();
+
+    BOOST_TEST(read_line(client) == R"({"first_block":10,"last_block":11,"contracts":["eosio.token"],"accounts":["alice","bob","eosio.token"]})");
+
+    feed.add_block(12);
+    feed.publish();
+    BOOST_TEST(read_line(client) == R"({"first_block":12,"last_block":12,"contracts":[],"accounts":[]})");
+
+    close(client);
+}
+
+BOOST_AUTO_TEST_CASE(empty_batches_are_not_published)
+{
+    const std::string path = "/tmp/sql_db_change_feed_test_empty.sock";
+    change_feed feed;
+    feed.set_socket(path);
+    const int client = connect_to(path);
+
+    feed.publish();
+    feed.add_block(5);
+    feed.publish();
+    BOOST_TEST(read_line(client) == R"({"first_block":5,"last_block":5,"contracts":[],"accounts":[]})");
+
+    close(client);
+}
+
+BOOST_AUTO_TEST_CASE(discarded_batches_are_not_published)
+{
+    const std::string path = "/tmp/sql_db_change_feed_test_discard.sock";
+    change_feed feed;
+    feed.set_socket(path);
+    const int client = connect_to(path);
+
+    chain::action transfer;
+    transfer.account = N(eosio.token);
+    transfer.name = N(transfer);
+
+    feed.add_block(5);
+    feed.add_action(transfer, N(eosio.token));
+    feed.discard();
+    feed.add_block(6);
+    feed.publish();
+    BOOST_TEST(read_line(client) == R"({"first_block":6,"last_block":6,"contracts":[],"accounts":[]})");
+
+    close(client);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
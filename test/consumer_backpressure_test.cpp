@@ -0,0 +1,176 @@
+#include <boost/test/unit_test.hpp>
+
+#include <iostream>
+
+#include "consumer.h"
+#include "latency_core.h"
+
+using namespace eosio;
+
+namespace {
+
+using core = latency_core<int>;
+
+// polls until done() or the timeout: the stats are recorded after consume()
+template<typename F>
+bool wait_for(F done, std::chrono::milliseconds timeout = std::chrono::seconds(10))
+{
+    const auto until = std::chrono::steady_clock::now() + timeout;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > until) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE(consumer_backpressure_test)
+
+BOOST_AUTO_TEST_CASE(batches_grow_behind_a_slow_core)
+{
+    core::profile profile;
+    profile.per_batch = std::chrono::milliseconds(20);
+    auto slow = std::make_unique<core>(profile);
+
+    consumer<int> c(std::move(slow));
+    for (int i = 0; i < 200; ++i) {
+        c.push(i);
+    }
+
+    BOOST_TEST(wait_for([&]{ return c.stats().elements == 200; }));
+    const auto stats = c.stats();
+    BOOST_TEST(stats.batches < 50);
+    BOOST_TEST(stats.max_batch > 1);
+}
+
+BOOST_AUTO_TEST_CASE(max_elements_bounds_the_batches_of_a_backlog)
+{
+    core::profile profile;
+    profile.per_element = std::chrono::milliseconds(1);
+    auto slow = std::make_unique<core>(profile);
+
+    batch_policy policy;
+    policy.max_elements = 10;
+    consumer<int> c(std::move(slow), policy);
+    for (int i = 0; i < 300; ++i) {
+        c.push(i);
+    }
+
+    BOOST_TEST(wait_for([&]{ return c.stats().elements == 300; }));
+    const auto stats = c.stats();
+    BOOST_TEST(stats.max_batch <= 10);
+    BOOST_TEST(stats.max_queued > 10);
+}
+
+BOOST_AUTO_TEST_CASE(max_bytes_bounds_the_memory_of_a_batch)
+{
+    core::profile profile;
+    profile.per_batch = std::chrono::milliseconds(5);
+    auto slow = std::make_unique<core>(profile);
+
+    batch_policy policy;
+    policy.max_bytes = 1000;
+    consumer<int> c(std::move(slow), policy, [](const int&) { return size_t(100); });
+    for (int i = 0; i < 200; ++i) {
+        c.push(i);
+    }
+
+    BOOST_TEST(wait_for([&]{ return c.stats().elements == 200; }));
+    const auto stats = c.stats();
+    BOOST_TEST(stats.max_batch_bytes <= 1000);
+    BOOST_TEST(stats.max_batch <= 10);
+}
+
+BOOST_AUTO_TEST_CASE(failing_batches_do_not_stop_the_consumer)
+{
+    core::profile profile;
+    profile.per_batch = std::chrono::milliseconds(1);
+    profile.failure_rate = 0.5;
+    auto flaky = std::make_unique<core>(profile);
+    auto& done = *flaky;
+
+    batch_policy policy;
+    policy.max_elements = 1;
+    consumer<int> c(std::move(flaky), policy);
+    for (int i = 0; i < 100; ++i) {
+        c.push(i);
+    }
+
+    BOOST_TEST(wait_for([&]{ return c.stats().elements == 100; }));
+    const auto stats = c.stats();
+    BOOST_TEST(stats.failures == done.failed);
+    BOOST_TEST(stats.failures > 0);
+    BOOST_TEST(done.consumed > 0);
+}
+
+BOOST_AUTO_TEST_CASE(backlog_of_a_stall_is_caught_up)
+{
+    core::profile profile;
+    profile.per_batch = std::chrono::milliseconds(2);
+    profile.stall_every = 1;
+    profile.stall = std::chrono::milliseconds(300);
+    auto stalling = std::make_unique<core>(profile);
+
+    consumer<int> c(std::move(stalling));
+    c.push(0); // the first batch stalls, the others queue behind it
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    for (int i = 1; i < 100; ++i) {
+        c.push(i);
+    }
+
+    BOOST_TEST(wait_for([&]{ return c.stats().elements == 100; }));
+    const auto stats = c.stats();
+    BOOST_TEST(stats.max_queued == 99);
+    BOOST_TEST(stats.batches == 2);
+}
+
+// Throughput of the consumer against a few database profiles, run with
+// --run_test=consumer_backpressure_benchmark
+BOOST_AUTO_TEST_CASE(consumer_backpressure_benchmark, * boost::unit_test::disabled())
+{
+    struct run {
+        const char* name;
+        core::profile profile;
+        batch_policy policy;
+    };
+
+    std::vector<run> runs(4);
+    runs[0].name = "fast commits";
+    runs[0].profile.per_batch = std::chrono::microseconds(200);
+    runs[1].name = "slow commits";
+    runs[1].profile.per_batch = std::chrono::milliseconds(20);
+    runs[2].name = "slow commits, 50 per batch";
+    runs[2].profile.per_batch = std::chrono::milliseconds(20);
+    runs[2].policy.max_elements = 50;
+    runs[3].name = "jitter and stalls";
+    runs[3].profile.per_batch = std::chrono::milliseconds(1);
+    runs[3].profile.jitter = std::chrono::milliseconds(5);
+    runs[3].profile.stall_every = 20;
+    runs[3].profile.stall = std::chrono::milliseconds(200);
+
+    for (auto& r : runs) {
+        r.profile.per_element = std::chrono::microseconds(50);
+        auto db = std::make_unique<core>(r.profile);
+        auto& done = *db;
+
+        const int elements = 5000;
+        const auto start = std::chrono::steady_clock::now();
+        consumer<int> c(std::move(db), r.policy);
+        for (int i = 0; i < elements; ++i) {
+            c.push(i);
+            std::this_thread::sleep_for(std::chrono::microseconds(100)); // 10k blocks per second at most
+        }
+        wait_for([&]{ return done.consumed == size_t(elements); }, std::chrono::minutes(5));
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        const auto stats = c.stats();
+        std::cout << r.name << ": " << elements / seconds << " elements/s, " << stats.batches << " batches (max " << stats.max_batch
+                  << "), max queued " << stats.max_queued << ", latency avg " << stats.total_latency.count() / 1000 / std::max<size_t>(stats.batches, 1)
+                  << " ms, max " << stats.max_latency.count() / 1000 << " ms" << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
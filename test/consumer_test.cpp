@@ -24,4 +24,64 @@ BOOST_AUTO_TEST_CASE(instantiate)
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 }
 
+BOOST_AUTO_TEST_CASE(coalesce_up_to_min_elements)
+{
+    struct counter : public consumer_core<int>
+    {
+    public:
+        std::atomic<size_t> count{0};
+
+        void consume(const std::vector<int> &blocks) override
+        {
+            count += blocks.size();
+        }
+    };
+
+    auto core = std::make_unique<counter>();
+    auto& count = core->count;
+
+    batch_policy policy;
+    policy.min_elements = 4;
+    policy.max_delay = std::chrono::milliseconds(500);
+
+    consumer<int> c(std::move(core), policy);
+    for (int i = 0; i < 4; ++i) {
+        c.push(i);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    const auto stats = c.stats();
+    BOOST_TEST(count == 4);
+    BOOST_TEST(stats.batches == 1);
+    BOOST_TEST(stats.max_batch == 4);
+}
+
+BOOST_AUTO_TEST_CASE(destruction_consumes_the_queue)
+{
+    struct counter : public consumer_core<int>
+    {
+    public:
+        explicit counter(std::atomic<size_t>& count) : count(count) {}
+
+        std::atomic<size_t>& count;
+
+        void consume(const std::vector<int> &blocks) override
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            count += blocks.size();
+        }
+    };
+
+    std::atomic<size_t> count{0};
+    batch_policy policy;
+    policy.max_elements = 2;
+    {
+        consumer<int> c(std::make_unique<counter>(count), policy);
+        for (int i = 0; i < 10; ++i) {
+            c.push(i);
+        }
+    }
+    BOOST_TEST(count == 10);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
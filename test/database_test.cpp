@@ -0,0 +1,144 @@
+#include <boost/test/unit_test.hpp>
+
+#include <eosio/chain/contract_types.hpp>
+#include <eosio/chain/transaction_metadata.hpp>
+
+#include "database.h"
+#include "test_blocks.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(database_test)
+
+const char* SQLITE_MEMORY_URI = "sqlite3://db=:memory:";
+
+BOOST_AUTO_TEST_CASE(sqlite_wipe_creates_schema)
+{
+    database db(SQLITE_MEMORY_URI, 0, "public");
+    BOOST_TEST(!db.is_started());
+    db.wipe();
+    BOOST_TEST(db.is_started());
+}
+
+BOOST_AUTO_TEST_CASE(sqlite_wipe_twice)
+{
+    database db(SQLITE_MEMORY_URI, 0, "public");
+    db.wipe();
+    db.wipe();
+    BOOST_TEST(db.is_started());
+}
+
+BOOST_AUTO_TEST_CASE(backfill_end_stops_at_first_gap)
+{
+    database db(SQLITE_MEMORY_URI, 0, "public");
+    db.wipe();
+    BOOST_TEST(db.backfill_end() == 0);
+
+    db.add_block_range(1, 10);
+    db.add_block_range(21, 30);
+    BOOST_TEST(db.backfill_end() == 10);
+
+    db.add_block_range(11, 20);
+    BOOST_TEST(db.backfill_end() == 30);
+}
+
+BOOST_AUTO_TEST_CASE(backfill_end_from_the_start_block)
+{
+    database db(SQLITE_MEMORY_URI, 0, "public");
+    db.wipe();
+    db.set_backfill_start(5001);
+    BOOST_TEST(db.backfill_end() == 0);
+
+    db.add_block_range(5001, 6000);
+    BOOST_TEST(db.backfill_end() == 6000);
+
+    db.set_backfill_start(7001); // a later run over newer blocks
+    db.add_block_range(7001, 8000);
+    BOOST_TEST(db.backfill_end() == 6000);
+
+    db.set_backfill_start(4001);
+    BOOST_TEST(db.backfill_end() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(backfill_end_without_start_block)
+{
+    database db(SQLITE_MEMORY_URI, 0, "public");
+    db.wipe();
+    db.add_block_range(101, 200);
+    BOOST_TEST(db.backfill_end() == 200);
+}
+
+BOOST_AUTO_TEST_CASE(consume_range_leaves_nothing_of_a_failed_chunk)
+{
+    database db(SQLITE_MEMORY_URI, 0, "public");
+    db.wipe();
+
+    const auto failed = db.consume_range(1, 10, [](uint32_t block_num) -> chain::signed_block_ptr {
+        if (block_num == 5) {
+            throw std::runtime_error("corrupted block");
+        }
+        auto block = std::make_shared<chain::signed_block>();
+        block->previous._hash[0] = fc::endian_reverse_u32(block_num - 1);
+        return block;
+    });
+    BOOST_TEST(!failed);
+    BOOST_TEST(db.backfill_end() == 0);
+
+    int blocks = -1;
+    *db.session() << "SELECT COUNT(*) FROM blocks", soci::into(blocks);
+    BOOST_TEST(blocks == 0);
+}
+
+BOOST_AUTO_TEST_CASE(consume_stores_the_executed_actions)
+{
+    auto traces = std::make_shared<trace_buffer>();
+    database db(SQLITE_MEMORY_URI, 0, "public", traces);
+    db.wipe();
+
+    // a system action, decoded with the built-in ABI
+    chain::action link;
+    link.account = chain::config::system_account_name;
+    link.name = N(linkauth);
+    link.authorization.push_back(chain::permission_level{N(alice), N(active)});
+    link.data = fc::raw::pack(chain::linkauth{N(alice), N(eosio.token), N(transfer), N(active)});
+    chain::signed_transaction transaction;
+    transaction.actions.push_back(link);
+    const chain::packed_transaction packed(transaction);
+
+    const auto block = make_block(1);
+    block->block->transactions.emplace_back(packed);
+    block->trxs.push_back(std::make_shared<chain::transaction_metadata>(packed));
+
+    // executed as a notification of alice, then an inline action
+    auto trace = std::make_shared<chain::transaction_trace>();
+    trace->id = packed.id();
+    trace->receipt = chain::transaction_receipt_header(chain::transaction_receipt_header::executed);
+    chain::action_trace top;
+    top.act = link;
+    top.receipt.receiver = link.account;
+    chain::action_trace notification = top;
+    notification.receipt.receiver = N(alice);
+    const chain::action_trace inline_action = top;
+    top.inline_traces.push_back(notification);
+    top.inline_traces.push_back(inline_action);
+    trace->action_traces.push_back(top);
+    traces->add(trace);
+    traces->seal(block);
+
+    db.consume({block});
+
+    std::vector<int> seqs(4), parents(4);
+    std::vector<std::string> receivers(4);
+    std::vector<soci::indicator> parents_ind(4);
+    *db.session() << "SELECT seq, receiver, parent FROM actions ORDER BY seq",
+            soci::into(seqs), soci::into(receivers), soci::into(parents, parents_ind);
+    BOOST_REQUIRE(seqs.size() == 3u); // not the one action of the block's transaction only
+    BOOST_TEST(receivers[0] == "eosio");
+    BOOST_TEST(parents_ind[0] == soci::i_null);
+    BOOST_TEST(receivers[1] == "alice");
+    BOOST_TEST(parents[1] == 0);
+    BOOST_TEST(receivers[2] == "eosio");
+    BOOST_TEST(parents[2] == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
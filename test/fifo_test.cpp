@@ -1,5 +1,8 @@
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <thread>
+
 #include "fifo.h"
 
 using namespace eosio;
@@ -36,4 +39,101 @@ BOOST_AUTO_TEST_CASE(pushing_2_int_pop_2_int)
     BOOST_TEST(2 == v.at(1));
 }
 
+BOOST_AUTO_TEST_CASE(pop_at_most_max_count)
+{
+    fifo<int> f(fifo<int>::behavior::blocking);
+    for (int i = 0; i < 5; ++i) {
+        f.push(i);
+    }
+    auto v = f.pop(1, 2, 0, fifo<int>::clock::duration::zero());
+    BOOST_TEST(v.size() == 2);
+    BOOST_TEST(0 == v.at(0));
+    v = f.pop(1, 0, 0, fifo<int>::clock::duration::zero());
+    BOOST_TEST(v.size() == 3);
+    BOOST_TEST(2 == v.at(0));
+}
+
+BOOST_AUTO_TEST_CASE(pop_waits_for_min_count_until_max_delay)
+{
+    fifo<int> f(fifo<int>::behavior::blocking);
+    f.push(1);
+
+    const auto start = fifo<int>::clock::now();
+    fifo<int>::clock::time_point oldest_push;
+    auto v = f.pop(3, 0, 0, std::chrono::milliseconds(50), &oldest_push);
+    BOOST_TEST(v.size() == 1);
+    BOOST_TEST((oldest_push <= start));
+    BOOST_TEST((fifo<int>::clock::now() - oldest_push >= std::chrono::milliseconds(50)));
+}
+
+BOOST_AUTO_TEST_CASE(pop_returns_once_min_count_is_reached)
+{
+    fifo<int> f(fifo<int>::behavior::blocking);
+    f.push(1);
+    std::thread producer([&f]{
+        f.push(2);
+        f.push(3);
+    });
+
+    auto v = f.pop(3, 0, 0, std::chrono::seconds(10));
+    producer.join();
+    BOOST_TEST(v.size() == 3);
+}
+
+BOOST_AUTO_TEST_CASE(pop_within_byte_budget)
+{
+    fifo<int> f(fifo<int>::behavior::blocking);
+    f.push(1, 100);
+    f.push(2, 100);
+    f.push(3, 100);
+
+    size_t bytes = 0;
+    auto v = f.pop(1, 0, 250, fifo<int>::clock::duration::zero(), nullptr, &bytes);
+    BOOST_TEST(v.size() == 2);
+    BOOST_TEST(bytes == 200);
+}
+
+BOOST_AUTO_TEST_CASE(pop_one_element_over_byte_budget)
+{
+    fifo<int> f(fifo<int>::behavior::blocking);
+    f.push(1, 1000);
+    f.push(2, 10);
+
+    auto v = f.pop(1, 0, 100, fifo<int>::clock::duration::zero());
+    BOOST_TEST(v.size() == 1);
+    BOOST_TEST(1 == v.at(0));
+}
+
+BOOST_AUTO_TEST_CASE(push_waits_while_full)
+{
+    fifo<int> f(fifo<int>::behavior::blocking);
+    f.set_max_size(2);
+    f.push(1);
+    f.push(2);
+
+    std::atomic<bool> pushed{false};
+    std::thread producer([&]{
+        f.push(3);
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    BOOST_TEST(!pushed);
+    BOOST_TEST(f.size() == 2u);
+
+    auto v = f.pop(1, 1, 0, fifo<int>::clock::duration::zero());
+    producer.join();
+    BOOST_TEST(pushed);
+    BOOST_TEST(f.size() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(push_does_not_wait_when_not_blocking)
+{
+    fifo<int> f(fifo<int>::behavior::blocking);
+    f.set_max_size(1);
+    f.push(1);
+    f.set_behavior(fifo<int>::behavior::not_blocking);
+    f.push(2);
+    BOOST_TEST(f.size() == 2u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,126 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+
+#include "database.h"
+#include "history_query.h"
+#include "sqlite_test_db.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(history_query_test)
+
+struct history_fixture : sqlite_file {
+    history_fixture()
+    {
+        database(uri(), 0, "public").wipe();
+        session = std::make_shared<soci::session>(uri());
+    }
+
+    void add_action(uint32_t block_number, const std::string& account, const std::string& actor)
+    {
+        *session << "INSERT INTO actions (block_number, account, receiver, seq, name, data, transaction_id) "
+                    "VALUES (:bn, :ac, :ac2, 0, 'transfer', '{}', 'trx')",
+                soci::use(block_number), soci::use(account), soci::use(account);
+        *session << "INSERT INTO actions_accounts (block_number, action_id, actor, permission) "
+                    "VALUES (:bn, (SELECT MAX(id) FROM actions), :ac, 'active')",
+                soci::use(block_number), soci::use(actor);
+    }
+
+    std::shared_ptr<soci::session> session; // closed before the file is removed
+};
+
+BOOST_FIXTURE_TEST_CASE(pages_are_newest_first_without_overlap, history_fixture)
+{
+    for (uint32_t block = 1; block <= 5; ++block) {
+        add_action(block, "eosio.token", "alice");
+        add_action(block, "eosio.token", "alice");
+        add_action(block, "eosio.token", "bob");
+    }
+
+    history_query history(session);
+    std::vector<uint64_t> ids;
+    fc::optional<history_cursor> after;
+    do {
+        auto page = history.account_history(N(alice), after, 3);
+        for (const auto& action : page.actions) {
+            ids.push_back(action.id);
+        }
+        after = page.next;
+    } while (after);
+
+    BOOST_TEST(ids.size() == 10);
+    BOOST_TEST(std::is_sorted(ids.rbegin(), ids.rend()));
+    BOOST_TEST(history.contract_history(N(eosio.token), fc::optional<history_cursor>(), 100).actions.size() == 15);
+}
+
+BOOST_FIXTURE_TEST_CASE(new_blocks_invalidate_the_first_page, history_fixture)
+{
+    add_action(1, "eosio.token", "alice");
+
+    history_query history(session);
+    BOOST_TEST(history.account_history(N(alice), fc::optional<history_cursor>(), 10).actions.size() == 1);
+
+    add_action(2, "eosio.token", "alice");
+    BOOST_TEST(history.account_history(N(alice), fc::optional<history_cursor>(), 10).actions.size() == 1); // cached
+
+    history.invalidate(2, 2);
+    const auto page = history.account_history(N(alice), fc::optional<history_cursor>(), 10);
+    BOOST_TEST(page.actions.size() == 2);
+    BOOST_TEST(page.actions.front().block_number == 2);
+    BOOST_TEST(!page.next);
+}
+
+BOOST_FIXTURE_TEST_CASE(two_permissions_of_an_actor_give_one_action, history_fixture)
+{
+    add_action(1, "eosio.token", "alice");
+    *session << "INSERT INTO actions_accounts (block_number, action_id, actor, permission) "
+                "VALUES (1, (SELECT MAX(id) FROM actions), 'alice', 'owner')";
+    add_action(2, "eosio.token", "alice");
+
+    history_query history(session);
+    auto page = history.account_history(N(alice), fc::optional<history_cursor>(), 1);
+    BOOST_TEST(page.actions.size() == 1);
+    BOOST_TEST(page.actions.front().block_number == 2);
+    page = history.account_history(N(alice), page.next, 10);
+    BOOST_TEST(page.actions.size() == 1);
+    BOOST_TEST(page.actions.front().block_number == 1);
+}
+
+BOOST_FIXTURE_TEST_CASE(backfilled_ranges_invalidate_the_cache, history_fixture)
+{
+    add_action(10, "eosio.token", "alice");
+
+    history_query history(session);
+    history.invalidate_backfilled();
+    BOOST_TEST(history.account_history(N(alice), fc::optional<history_cursor>(), 10).actions.size() == 1);
+
+    add_action(5, "eosio.token", "alice"); // written by sql_db_backfill
+    history.invalidate_backfilled();
+    BOOST_TEST(history.account_history(N(alice), fc::optional<history_cursor>(), 10).actions.size() == 1); // cached
+
+    database(uri(), 0, "public").add_block_range(1, 9);
+    history.invalidate_backfilled();
+    BOOST_TEST(history.account_history(N(alice), fc::optional<history_cursor>(), 10).actions.size() == 2);
+}
+
+BOOST_FIXTURE_TEST_CASE(large_limits_are_lowered, history_fixture)
+{
+    {
+        soci::transaction batch(*session);
+        for (uint32_t block = 1; block <= history_query::max_limit + 5; ++block) {
+            add_action(block, "eosio.token", "alice");
+        }
+        batch.commit();
+    }
+
+    history_query history(session);
+    auto page = history.account_history(N(alice), fc::optional<history_cursor>(), 1000000);
+    BOOST_TEST(page.actions.size() == history_query::max_limit);
+    BOOST_REQUIRE(page.next);
+    page = history.account_history(N(alice), page.next, 1000000);
+    BOOST_TEST(page.actions.size() == 5u);
+    BOOST_TEST(page.actions.back().block_number == 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
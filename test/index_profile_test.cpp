@@ -0,0 +1,139 @@
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+
+#include "database.h"
+#include "history_query.h"
+#include "sqlite_test_db.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(index_profile_test)
+
+namespace {
+
+std::vector<std::string> index_names(soci::session& session)
+{
+    std::vector<std::string> names;
+    std::string name;
+    soci::statement statement = (session.prepare << "SELECT name FROM sqlite_master WHERE type = 'index' AND name LIKE 'idx_actions%' ORDER BY name",
+            soci::into(name));
+    statement.execute();
+    while (statement.fetch()) {
+        names.push_back(name);
+    }
+    return names;
+}
+
+bool contains(const std::vector<std::string>& names, const std::string& name)
+{
+    return std::find(names.begin(), names.end(), name) != names.end();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(append_only_drops_the_history_prefixes)
+{
+    sqlite_file file;
+    index_options indexes;
+    indexes.profile = index_profile::append_only;
+    indexes.hot_contracts = {"eosio.token"};
+    {
+        database db(file.uri(), 0, "public");
+        db.set_indexes(indexes);
+        db.wipe();
+    }
+
+    soci::session session(file.uri());
+    const auto names = index_names(session);
+    BOOST_TEST(!contains(names, "idx_actions_account"));
+    BOOST_TEST(!contains(names, "idx_actions_actor"));
+    BOOST_TEST(contains(names, "idx_actions_account_history"));
+    BOOST_TEST(contains(names, "idx_actions_hot_eosio_token"));
+}
+
+BOOST_AUTO_TEST_CASE(btree_is_the_default)
+{
+    sqlite_file file;
+    database(file.uri(), 0, "public").wipe();
+
+    soci::session session(file.uri());
+    const auto names = index_names(session);
+    BOOST_TEST(contains(names, "idx_actions_account"));
+    BOOST_TEST(contains(names, "idx_actions_actor"));
+}
+
+BOOST_AUTO_TEST_CASE(invalid_profiles_and_contracts_are_rejected)
+{
+    BOOST_CHECK(parse_index_profile("append-only") == index_profile::append_only);
+    BOOST_CHECK_THROW(parse_index_profile("brin"), std::invalid_argument);
+    BOOST_CHECK_THROW(index_suffix("x'; DROP TABLE actions; --"), std::invalid_argument);
+}
+
+// Insert rate and history query latency of each profile, run with
+// --run_test=index_profile_test/index_profile_benchmark. SQL_DB_BENCH_URI selects the database
+// (e.g. a PostgreSQL one, where BRIN and hash indexes apply), else a SQLite file.
+BOOST_AUTO_TEST_CASE(index_profile_benchmark, * boost::unit_test::disabled())
+{
+    using clock = std::chrono::steady_clock;
+
+    sqlite_file file;
+    const char* bench_uri = std::getenv("SQL_DB_BENCH_URI");
+    const std::string uri = bench_uri ? bench_uri : file.uri();
+
+    const int blocks = 20000;
+    const int actions_per_block = 10;
+    const char* accounts[] = {"alice", "bob", "carol", "dave", "eosio.token", "eosio"};
+
+    for (const auto profile : {index_profile::btree, index_profile::append_only}) {
+        index_options indexes;
+        indexes.profile = profile;
+        indexes.hot_contracts = {"eosio.token"};
+        {
+            database db(uri, 0, "public");
+            db.set_indexes(indexes);
+            db.wipe();
+        }
+
+        auto session = std::make_shared<soci::session>(uri);
+        auto start = clock::now();
+        for (int block = 1; block <= blocks; ++block) {
+            soci::transaction transaction(*session);
+            for (int i = 0; i < actions_per_block; ++i) {
+                const std::string account = accounts[(block + i) % 6];
+                const std::string actor = accounts[(block * 7 + i) % 4];
+                *session << "INSERT INTO actions (block_number, account, receiver, seq, name, data, transaction_id) "
+                            "VALUES (:bn, :ac, :re, :se, 'transfer', '{}', 'trx')",
+                        soci::use(block), soci::use(account), soci::use(account), soci::use(i);
+                *session << "INSERT INTO actions_accounts (block_number, action_id, actor, permission) "
+                            "VALUES (:bn, (SELECT MAX(id) FROM actions), :ac, 'active')",
+                        soci::use(block), soci::use(actor);
+            }
+            transaction.commit();
+        }
+        const auto insert_seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        history_query history(session, 0); // no cache: every page is a query
+        const int pages = 2000;
+        start = clock::now();
+        for (int i = 0; i < pages; ++i) {
+            fc::optional<history_cursor> after;
+            if (i % 2) {
+                after = history_cursor{static_cast<uint32_t>(blocks - i * 5), std::numeric_limits<int32_t>::max()};
+            }
+            history.account_history(chain::name(accounts[i % 4]), after, 50);
+            history.contract_history(chain::name(accounts[i % 6]), after, 50);
+        }
+        const auto query_us = std::chrono::duration<double, std::micro>(clock::now() - start).count() / (pages * 2);
+
+        std::cout << (profile == index_profile::btree ? "btree" : "append-only") << ": "
+                  << blocks * actions_per_block / insert_seconds << " actions/s inserted, "
+                  << query_us << " us per history page" << std::endl;
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,70 @@
+#ifndef LATENCY_CORE_H
+#define LATENCY_CORE_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "consumer_core.h"
+
+namespace eosio {
+
+// Stands for a slow or unreliable database behind a consumer: every batch and
+// every element (a statement) costs some latency, with jitter, a share of the
+// batches fail and some of them stall. Everything offline.
+template<typename T>
+class latency_core : public consumer_core<T>
+{
+public:
+    struct profile {
+        std::chrono::microseconds per_batch{0}; // the commit
+        std::chrono::microseconds per_element{0};
+        std::chrono::microseconds jitter{0}; // up to, added to every batch
+        double failure_rate = 0; // of the batches: consume() throws after paying the latency
+        size_t stall_every = 0; // the nth batch stalls, 0: never
+        std::chrono::milliseconds stall{0};
+        unsigned seed = 1;
+    };
+
+    explicit latency_core(const profile& p):
+        m_profile(p),
+        m_random(p.seed)
+    {
+    }
+
+    void consume(const std::vector<T>& elements) override
+    {
+        const auto batch = ++batches;
+
+        auto latency = m_profile.per_batch + m_profile.per_element * static_cast<long>(elements.size());
+        if (m_profile.jitter.count() > 0) {
+            latency += std::chrono::microseconds(std::uniform_int_distribution<long>(0, m_profile.jitter.count())(m_random));
+        }
+        if (m_profile.stall_every > 0 && batch % m_profile.stall_every == 0) {
+            latency += m_profile.stall;
+        }
+        std::this_thread::sleep_for(latency);
+
+        if (std::uniform_real_distribution<double>(0, 1)(m_random) < m_profile.failure_rate) {
+            failed += elements.size();
+            throw std::runtime_error("injected failure");
+        }
+        consumed += elements.size();
+    }
+
+    std::atomic<size_t> batches{0};
+    std::atomic<size_t> consumed{0};
+    std::atomic<size_t> failed{0}; // elements of the failed batches
+
+private:
+    profile m_profile;
+    std::mt19937 m_random;
+};
+
+} // namespace
+
+#endif // LATENCY_CORE_H
@@ -0,0 +1,39 @@
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include "parquet_sink.h"
+#include "test_blocks.h"
+
+using namespace eosio;
+namespace bfs = boost::filesystem;
+
+BOOST_AUTO_TEST_SUITE(parquet_sink_test)
+
+BOOST_AUTO_TEST_CASE(failed_roll_is_tried_again)
+{
+    if (!parquet_sink::supported()) {
+        BOOST_TEST_MESSAGE("built without Arrow and Parquet");
+        return;
+    }
+
+    const auto dir = bfs::temp_directory_path() / bfs::unique_path();
+    bfs::create_directories(dir);
+    std::ofstream((dir / "blocks").string()) << "not a directory";
+    {
+        parquet_sink sink(dir.string(), 1);
+        sink.consume({make_block(1)}); // the blocks partition cannot be created
+        bfs::remove(dir / "blocks");
+        sink.consume({make_block(2), make_block(3)});
+    }
+
+    const auto partition = dir / "blocks" / "date=2018-06-01";
+    BOOST_TEST(!bfs::exists(partition / "part-1.parquet"));
+    BOOST_TEST(bfs::exists(partition / "part-2.parquet"));
+    BOOST_TEST(bfs::exists(partition / "part-3.parquet"));
+    bfs::remove_all(dir);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,92 @@
+#include <boost/test/unit_test.hpp>
+
+#include "payload_codec.h"
+#include "sqlite_test_db.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(payload_codec_test)
+
+namespace {
+
+std::string transfer(int i)
+{
+    return "{\"from\":\"alice\",\"to\":\"bob" + std::to_string(i % 7) + "\",\"quantity\":\"" +
+           std::to_string(i) + ".0000 EOS\",\"memo\":\"payment " + std::to_string(i * 31) + "\"}";
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE(round_trip_with_and_without_dictionary, sqlite_memory_db)
+{
+    if (!payload_compressor::supported()) {
+        return; // built without zstd
+    }
+
+    payload_compressor::create(*session);
+
+    payload_compressor compressor(session, writer);
+    payload_decompressor decompressor(session);
+
+    std::vector<std::string> payloads;
+    std::vector<std::string> stored;
+    for (int i = 0; i < 1500; ++i) {
+        payloads.push_back(transfer(i));
+        std::string out;
+        compressor.compress(N(eosio.token), N(transfer), payloads.back(), out);
+        stored.push_back(out);
+    }
+    writer->sync();
+
+    int dictionaries = 0;
+    *session << "SELECT COUNT(*) FROM payload_dictionaries", soci::into(dictionaries);
+    BOOST_TEST(dictionaries == 1);
+
+    for (size_t i = 0; i < payloads.size(); ++i) {
+        BOOST_TEST(decompressor.decompress(stored[i]) == payloads[i]);
+    }
+    BOOST_TEST(stored.back().size() < payloads.back().size());
+}
+
+BOOST_FIXTURE_TEST_CASE(dictionary_of_a_rolled_back_batch_is_trained_again, sqlite_memory_db)
+{
+    if (!payload_compressor::supported()) {
+        return; // built without zstd
+    }
+
+    payload_compressor::create(*session);
+
+    payload_compressor compressor(session, writer);
+    payload_decompressor decompressor(session);
+
+    std::string out;
+    {
+        soci::transaction batch(*session);
+        for (int i = 0; i < 1500; ++i) {
+            compressor.compress(N(eosio.token), N(transfer), transfer(i), out);
+        }
+        writer->sync();
+        batch.rollback();
+    }
+    compressor.rollback();
+
+    int dictionaries = 0;
+    *session << "SELECT COUNT(*) FROM payload_dictionaries", soci::into(dictionaries);
+    BOOST_TEST(dictionaries == 0);
+
+    std::vector<std::string> stored;
+    for (int i = 0; i < 1500; ++i) {
+        compressor.compress(N(eosio.token), N(transfer), transfer(i), out);
+        stored.push_back(out);
+    }
+    writer->sync();
+    compressor.commit();
+
+    *session << "SELECT COUNT(*) FROM payload_dictionaries", soci::into(dictionaries);
+    BOOST_TEST(dictionaries == 1);
+    for (size_t i = 0; i < stored.size(); ++i) {
+        BOOST_TEST(decompressor.decompress(stored[i]) == transfer(i));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+#include <boost/test/unit_test.hpp>
+
+#include "database.h"
+#include "payload_store.h"
+#include "sqlite_test_db.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(payload_store_test)
+
+namespace {
+
+chain::action make_action(chain::account_name account, chain::action_name name, const std::string& data)
+{
+    chain::action action;
+    action.account = account;
+    action.name = name;
+    action.data.assign(data.begin(), data.end());
+    return action;
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE(recent_payloads_are_written_once, sqlite_memory_db)
+{
+    *session << "CREATE TABLE payloads (id INTEGER PRIMARY KEY, data TEXT, data_zstd BLOB)";
+
+    using store = payload_store<sqlite_dialect>;
+    const auto airdrop = make_action(N(spam), N(transfer), "same bytes");
+    const auto id = store::id(airdrop, 1);
+    BOOST_TEST(id == store::id(make_action(N(spam), N(transfer), "same bytes"), 1));
+    BOOST_TEST(id != store::id(airdrop, 2)); // another ABI
+    BOOST_TEST(id != store::id(make_action(N(other), N(transfer), "same bytes"), 1));
+    BOOST_TEST(id != store::id(make_action(N(spam), N(transfer), "other bytes"), 1));
+
+    store payloads(writer, 4);
+    BOOST_TEST(!payloads.contains(id));
+    payloads.add(id, "{}", false);
+    BOOST_TEST(payloads.contains(id));
+
+    // a batch rolled back: written again by the next one
+    payloads.rollback();
+    BOOST_TEST(!payloads.contains(id));
+    payloads.add(id, "{}", false);
+    payloads.add(id, "{}", false);
+    payloads.commit();
+    BOOST_TEST(payloads.contains(id));
+    writer->sync();
+
+    long long count = 0;
+    *session << "SELECT COUNT(*) FROM payloads", soci::into(count);
+    BOOST_TEST(count == 1);
+
+    // two generations of 2: the oldest ids are forgotten
+    for (uint64_t other = 1; other <= 4; ++other) {
+        payloads.add(other, "{}", false);
+        payloads.commit();
+    }
+    BOOST_TEST(!payloads.contains(id));
+    BOOST_TEST(payloads.contains(4));
+}
+
+BOOST_AUTO_TEST_CASE(history_reads_the_stored_payloads)
+{
+    sqlite_file file;
+    database(file.uri(), 0, "public").wipe();
+
+    auto session = std::make_shared<soci::session>(file.uri());
+    *session << "INSERT INTO payloads (id, data) VALUES (42, '{\"memo\":\"airdrop\"}')";
+    for (int i = 0; i < 3; ++i) {
+        *session << "INSERT INTO actions (block_number, account, receiver, seq, name, payload_id, transaction_id) "
+                    "VALUES (:bn, 'spam', 'spam', 0, 'transfer', 42, 'trx')", soci::use(i + 1);
+    }
+    *session << "INSERT INTO actions (block_number, account, receiver, seq, name, data, transaction_id) "
+                "VALUES (4, 'spam', 'spam', 0, 'transfer', '{}', 'trx')";
+
+    history_query history(session, 0);
+    const auto page = history.contract_history(N(spam), fc::optional<history_cursor>(), 10);
+    BOOST_REQUIRE(page.actions.size() == 4u);
+    BOOST_TEST(page.actions[0].data == "{}");
+    BOOST_TEST(page.actions[3].data == "{\"memo\":\"airdrop\"}");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
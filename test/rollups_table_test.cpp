@@ -0,0 +1,59 @@
+#include <boost/test/unit_test.hpp>
+
+#include "rollups_table.h"
+#include "sqlite_test_db.h"
+#include "test_blocks.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(rollups_table_test)
+
+namespace {
+
+long long minute_blocks(soci::session& session)
+{
+    long long blocks = 0;
+    session << "SELECT SUM(blocks) FROM rollup_minutes", soci::into(blocks);
+    return blocks;
+}
+
+}
+
+BOOST_FIXTURE_TEST_CASE(failed_fork_batch_is_rolled_back, sqlite_memory_db)
+{
+    rollups_table<sqlite_dialect> rollups(session, writer);
+    rollups.create();
+
+    for (uint32_t block_num = 1; block_num <= 3; ++block_num) {
+        rollups.add_block(make_block(block_num));
+        rollups.add_action(N(eosio.token), N(transfer));
+    }
+    rollups.flush();
+    writer->sync();
+    rollups.commit();
+    BOOST_TEST(minute_blocks(*session) == 3);
+
+    {
+        soci::transaction batch(*session);
+        rollups.add_block(make_block(3)); // a fork replacing block 3
+        rollups.add_block(make_block(4));
+        rollups.flush();
+        writer->sync();
+        batch.rollback(); // the commit failed
+        rollups.rollback();
+    }
+    BOOST_TEST(minute_blocks(*session) == 3);
+
+    rollups.add_block(make_block(3)); // the same fork, written again
+    rollups.add_block(make_block(4));
+    rollups.flush();
+    writer->sync();
+    rollups.commit();
+    BOOST_TEST(minute_blocks(*session) == 4);
+
+    long long actions = 0;
+    *session << "SELECT actions FROM rollup_contracts WHERE account = 'eosio.token'", soci::into(actions);
+    BOOST_TEST(actions == 2); // the actions of block 3 were subtracted once
+}
+
+BOOST_AUTO_TEST_SUITE_END()
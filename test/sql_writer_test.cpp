@@ -0,0 +1,39 @@
+#include <boost/test/unit_test.hpp>
+
+#include "sql_writer.h"
+#include "sqlite_test_db.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(sql_writer_test)
+
+BOOST_FIXTURE_TEST_CASE(bulk_rows_are_written_in_few_statements, sqlite_memory_db)
+{
+    *session << "CREATE TABLE rows (n INTEGER, name TEXT, parent INTEGER)";
+
+    sql_writer::bulk rows("INSERT INTO rows (n, name, parent) VALUES (:n, :na, :pa)");
+    int statements = 0;
+    for (int i = 0; i < 1000; ++i) {
+        if (rows.add(i, std::to_string(i), i % 2 ? boost::optional<int>(i - 1) : boost::optional<int>())) {
+            writer->exec(rows);
+            ++statements;
+        }
+    }
+    BOOST_TEST(rows.size() < 1000u);
+    writer->exec(rows);
+    ++statements;
+    BOOST_TEST(rows.empty());
+    BOOST_TEST(statements == 4); // 333 rows of 3 parameters each
+
+    long long count = 0, nulls = 0, sum = 0;
+    *session << "SELECT COUNT(*), SUM(parent IS NULL), SUM(n) FROM rows", soci::into(count), soci::into(nulls), soci::into(sum);
+    BOOST_TEST(count == 1000);
+    BOOST_TEST(nulls == 500);
+    BOOST_TEST(sum == 999 * 1000 / 2);
+
+    std::string name;
+    *session << "SELECT name FROM rows WHERE n = 777", soci::into(name);
+    BOOST_TEST(name == "777");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,44 @@
+#ifndef SQLITE_TEST_DB_H
+#define SQLITE_TEST_DB_H
+
+#include <memory>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <soci/soci.h>
+
+#include "batch_arena.h"
+#include "sql_writer.h"
+
+namespace eosio {
+
+// An SQLite database in memory and the writer the tables queue their statements
+// to, as the plugin sets them up. Gone with the fixture.
+struct sqlite_memory_db {
+    std::shared_ptr<soci::session> session = std::make_shared<soci::session>("sqlite3://db=:memory:");
+    batch_arena arena;
+    std::shared_ptr<sql_writer> writer = std::make_shared<sql_writer>(session, &arena);
+};
+
+// An SQLite database in a file of its own, for what opens its own sessions
+// (database, history_query). The file is removed with the fixture: close the
+// sessions before.
+struct sqlite_file {
+    sqlite_file():
+        path((boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string())
+    {
+    }
+
+    ~sqlite_file()
+    {
+        boost::filesystem::remove(path);
+    }
+
+    std::string uri() const { return "sqlite3://db=" + path; }
+
+    std::string path;
+};
+
+} // namespace
+
+#endif // SQLITE_TEST_DB_H
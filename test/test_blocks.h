@@ -0,0 +1,25 @@
+#ifndef TEST_BLOCKS_H
+#define TEST_BLOCKS_H
+
+#include <memory>
+#include <string>
+
+#include <eosio/chain/block_state.hpp>
+
+namespace eosio {
+
+// A block state without transactions, as accepted on 2018-06-01, its id derived
+// from its number.
+inline chain::block_state_ptr make_block(uint32_t block_num)
+{
+    auto block = std::make_shared<chain::block_state>();
+    block->block = std::make_shared<chain::signed_block>();
+    block->block->timestamp = chain::block_timestamp_type(fc::time_point_sec(1527854400));
+    block->block_num = block_num;
+    block->id = fc::sha256::hash(std::to_string(block_num));
+    return block;
+}
+
+} // namespace
+
+#endif // TEST_BLOCKS_H
@@ -0,0 +1,96 @@
+#include <boost/test/unit_test.hpp>
+
+#include "trace_buffer.h"
+#include "test_blocks.h"
+
+using namespace eosio;
+
+BOOST_AUTO_TEST_SUITE(trace_buffer_test)
+
+namespace {
+
+chain::action_trace make_trace(chain::account_name receiver, chain::action_name name, std::vector<chain::action_trace> inline_traces = {})
+{
+    chain::action_trace trace;
+    trace.receipt.receiver = receiver;
+    trace.act.account = N(eosio.token);
+    trace.act.name = name;
+    trace.inline_traces = std::move(inline_traces);
+    return trace;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(inline_traces_are_flattened_in_execution_order)
+{
+    // transfer, notifying alice and bob, whose contract sends an inline log; then open
+    auto trace = std::make_shared<chain::transaction_trace>();
+    trace->id = fc::sha256::hash(std::string("trx"));
+    trace->receipt = chain::transaction_receipt_header(chain::transaction_receipt_header::executed);
+    trace->action_traces.push_back(make_trace(N(eosio.token), N(transfer), {
+            make_trace(N(alice), N(transfer)),
+            make_trace(N(bob), N(transfer), {make_trace(N(eosio.token), N(log))})}));
+    trace->action_traces.push_back(make_trace(N(eosio.token), N(open)));
+
+    trace_buffer traces;
+    traces.add(trace);
+    const auto block = make_block(1);
+    block->block->transactions.emplace_back(trace->id);
+    traces.seal(block);
+
+    const auto transactions = traces.take(block->id);
+    BOOST_REQUIRE(transactions.size() == 1u);
+    BOOST_TEST(transactions[0].id == trace->id);
+    const auto& actions = transactions[0].actions;
+    BOOST_REQUIRE(actions.size() == 5u);
+    // the index of an action is its seq, a child refers to the seq of its parent
+    const std::vector<chain::account_name> receivers{N(eosio.token), N(alice), N(bob), N(eosio.token), N(eosio.token)};
+    const std::vector<chain::action_name> names{N(transfer), N(transfer), N(transfer), N(log), N(open)};
+    const std::vector<int32_t> parents{-1, 0, 0, 2, -1};
+    for (size_t seq = 0; seq < actions.size(); ++seq) {
+        BOOST_TEST(actions[seq].receiver == receivers[seq]);
+        BOOST_TEST(actions[seq].act.name == names[seq]);
+        BOOST_TEST(actions[seq].parent == parents[seq]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(failed_and_unsealed_transactions_are_not_taken)
+{
+    auto failed = std::make_shared<chain::transaction_trace>();
+    failed->id = fc::sha256::hash(std::string("failed"));
+    failed->receipt = chain::transaction_receipt_header(chain::transaction_receipt_header::hard_fail);
+    failed->action_traces.push_back(make_trace(N(eosio.token), N(transfer)));
+
+    auto speculative = std::make_shared<chain::transaction_trace>();
+    speculative->id = fc::sha256::hash(std::string("speculative"));
+    speculative->receipt = chain::transaction_receipt_header(chain::transaction_receipt_header::executed);
+    speculative->action_traces.push_back(make_trace(N(eosio.token), N(transfer)));
+
+    trace_buffer traces;
+    traces.add(failed);
+    traces.add(speculative);
+    const auto block = make_block(1);
+    block->block->transactions.emplace_back(failed->id); // the speculative one is not in the block
+    traces.seal(block);
+    BOOST_TEST(traces.take(block->id).empty());
+}
+
+BOOST_AUTO_TEST_CASE(sealed_blocks_nobody_takes_are_dropped)
+{
+    trace_buffer traces;
+    traces.set_max_sealed_age(2);
+
+    const auto first = make_block(1);
+    const auto second = make_block(2);
+    traces.seal(first);
+    traces.put(first->id, {transaction_actions{fc::sha256::hash(std::string("trx")), {}}});
+    traces.seal(second);
+    BOOST_TEST(traces.peek(first->id).size() == 1u);
+
+    traces.seal(make_block(3)); // the first is older than the last 2 seals
+    BOOST_TEST(traces.peek(first->id).empty());
+    BOOST_TEST(traces.take(second->id).empty()); // taken: nothing left to drop
+    traces.seal(make_block(5));
+}
+
+BOOST_AUTO_TEST_SUITE_END()